@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _perplexcpp_bench_dataset_h
+#define _perplexcpp_bench_dataset_h
+
+
+#include <cstddef>
+#include <string>
+
+
+namespace perplexcpp
+{
+namespace bench
+{
+  /**
+   * A Perple_X data set that the benchmarks may be run on.
+   */
+  struct Dataset
+  {
+    std::string name;
+
+    std::string problem_file;
+
+    std::string working_dir;
+  };
+
+
+  /**
+   * @return The data set selected on the command line (--dataset=NAME) or with
+   *         the PERPLEXCPP_BENCH_DATASET environment variable. Defaults to
+   *         "simple".
+   */
+  const Dataset&
+  get_dataset();
+
+
+  /**
+   * Initialize the wrapper with the selected data set.
+   *
+   * @param cache_capacity The capacity of the wrapper's cache.
+   */
+  void
+  initialize_wrapper(const size_t cache_capacity=0);
+}
+}
+
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Run the benchmarks on one Perple_X data set. The Wrapper is a singleton so
+ * each data set needs its own process. Usage:
+ *
+ *     benchperplexcpp [--dataset=simple|klb-1] [benchmark options]
+ *
+ * Use --benchmark_out=FILE --benchmark_out_format=json for machine-readable
+ * results, or build the bench-json target to run every data set.
+ */
+
+
+#include "dataset.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <perplexcpp/wrapper.h>
+
+
+namespace perplexcpp
+{
+namespace bench
+{
+namespace
+{
+
+/**
+ * The data sets copied into the build directory.
+ */
+const std::vector<Dataset> datasets = {
+  { "simple", "test.dat", PERPLEXCPP_BENCH_DATA_DIR "/simple" },
+  { "klb-1", "khgp.dat", PERPLEXCPP_BENCH_DATA_DIR "/klb-1" }
+};
+
+
+/**
+ * The selected data set.
+ */
+const Dataset* selected = &datasets[0];
+
+
+/**
+ * Select a data set by name.
+ */
+void
+select_dataset(const std::string& name)
+{
+  for (const Dataset& dataset : datasets)
+    if (dataset.name == name) {
+      selected = &dataset;
+      return;
+    }
+  throw std::invalid_argument("Unknown data set '" + name + "'");
+}
+
+}  // namespace
+
+
+const Dataset&
+get_dataset()
+{
+  return *selected;
+}
+
+
+void
+initialize_wrapper(const size_t cache_capacity)
+{
+  Wrapper::initialize(selected->problem_file, selected->working_dir, cache_capacity);
+}
+
+}
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  using namespace perplexcpp::bench;
+
+  const char* const option = "--dataset=";
+  try {
+    if (const char* name = std::getenv("PERPLEXCPP_BENCH_DATASET"))
+      select_dataset(name);
+
+    // Remove the option so that it is not rejected by Google Benchmark.
+    int n_args = 0;
+    for (int i = 0; i < argc; ++i) {
+      if (std::strncmp(argv[i], option, std::strlen(option)) == 0)
+	select_dataset(argv[i] + std::strlen(option));
+      else
+	argv[n_args++] = argv[i];
+    }
+    argc = n_args;
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return EXIT_FAILURE;
+
+  benchmark::AddCustomContext("dataset", get_dataset().name);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return EXIT_SUCCESS;
+}
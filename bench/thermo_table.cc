@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "dataset.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <perplexcpp/thermo_table.h>
+#include <perplexcpp/wrapper.h>
+#include <random>
+#include <vector>
+
+
+using namespace perplexcpp;
+
+
+namespace
+{
+
+/**
+ * The number of points interpolated per iteration.
+ */
+const size_t n_points = 1 << 16;
+
+
+/**
+ * @return The table shared by the benchmarks, built on first use.
+ */
+ThermoTable&
+get_table()
+{
+  static std::unique_ptr<ThermoTable> table;
+  if (!table) {
+    bench::initialize_wrapper();
+    table.reset(new ThermoTable(Wrapper::get_instance(), 32, 32));
+  }
+  return *table;
+}
+
+
+/**
+ * Fill the arrays with random points lying inside the table.
+ */
+void
+make_points(const ThermoTable& table,
+            std::vector<double>& pressures,
+	    std::vector<double>& temperatures)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> 
+    pressure(table.min_pressure, table.max_pressure),
+    temperature(table.min_temperature, table.max_temperature);
+
+  pressures.resize(n_points);
+  temperatures.resize(n_points);
+  for (size_t n = 0; n < n_points; ++n) {
+    pressures[n] = pressure(generator);
+    temperatures[n] = temperature(generator);
+  }
+}
+
+}  // namespace
+
+
+/**
+ * Interpolate every property one point at a time.
+ */
+static void
+BM_ThermoTablePointwise(benchmark::State& state)
+{
+  const ThermoTable& table = get_table();
+  std::vector<double> pressures, temperatures;
+  make_points(table, pressures, temperatures);
+
+  for (auto _ : state)
+    for (size_t n = 0; n < n_points; ++n)
+      benchmark::DoNotOptimize(table.interpolate(pressures[n], temperatures[n]));
+
+  state.SetItemsProcessed(state.iterations() * n_points);
+}
+BENCHMARK(BM_ThermoTablePointwise);
+
+
+/**
+ * Interpolate every property for the whole batch at once.
+ */
+static void
+BM_ThermoTableBatch(benchmark::State& state)
+{
+  const ThermoTable& table = get_table();
+  std::vector<double> pressures, temperatures;
+  make_points(table, pressures, temperatures);
+
+  std::vector<std::vector<double>> values(n_thermo_properties, 
+					  std::vector<double>(n_points));
+  double* out[n_thermo_properties];
+  for (size_t k = 0; k < n_thermo_properties; ++k)
+    out[k] = values[k].data();
+
+  for (auto _ : state) {
+    table.interpolate(n_points, pressures.data(), temperatures.data(), out);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * n_points);
+}
+BENCHMARK(BM_ThermoTableBatch);
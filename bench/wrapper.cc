@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "dataset.h"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <perplexcpp/prewarm.h>
+#include <perplexcpp/result_batch.h>
+#include <perplexcpp/result_cache.h>
+#include <perplexcpp/utils.h>
+#include <perplexcpp/wrapper.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "f2c.h"
+
+
+using namespace perplexcpp;
+
+
+namespace
+{
+
+/**
+ * @return The wrapper, initialized on first use without a cache.
+ */
+const Wrapper&
+get_wrapper()
+{
+  static bool initialized = false;
+  if (!initialized) {
+    bench::initialize_wrapper();
+    initialized = true;
+  }
+  return Wrapper::get_instance();
+}
+
+
+/**
+ * @return The pressure a fraction of the way across the problem bounds.
+ */
+double
+get_pressure(const Wrapper& wrapper, const double fraction)
+{
+  return wrapper.min_pressure + fraction * (wrapper.max_pressure - wrapper.min_pressure);
+}
+
+
+/**
+ * @return The temperature a fraction of the way across the problem bounds.
+ */
+double
+get_temperature(const Wrapper& wrapper, const double fraction)
+{
+  return wrapper.min_temperature + 
+	 fraction * (wrapper.max_temperature - wrapper.min_temperature);
+}
+
+
+/**
+ * The P-T points used for the latency benchmarks, as percentages of the way
+ * across the problem bounds.
+ */
+void
+pt_points(benchmark::internal::Benchmark* benchmark)
+{
+  benchmark->ArgNames({ "P%", "T%" });
+  for (const auto& point : std::vector<std::pair<int,int>> { 
+	 { 25, 25 }, { 25, 75 }, { 50, 50 }, { 75, 25 }, { 75, 75 } })
+    benchmark->Args({ point.first, point.second });
+}
+
+}  // namespace
+
+
+/**
+ * Read the problem definition and data files.
+ */
+static void
+BM_WrapperInitialize(benchmark::State& state)
+{
+  for (auto _ : state)
+    bench::initialize_wrapper();
+}
+BENCHMARK(BM_WrapperInitialize)->Unit(benchmark::kMillisecond);
+
+
+/**
+ * Minimize at a point without consulting the caches.
+ */
+static void
+BM_MinimizeCold(benchmark::State& state)
+{
+  const Wrapper& wrapper = get_wrapper();
+  const double pressure = get_pressure(wrapper, state.range(0) / 100.0);
+  const double temperature = get_temperature(wrapper, state.range(1) / 100.0);
+
+  Wrapper& mutable_wrapper = const_cast<Wrapper&>(wrapper);
+  mutable_wrapper.reset_stats();
+  try {
+    for (auto _ : state)
+      benchmark::DoNotOptimize(wrapper.solve(pressure, temperature, 
+					     wrapper.initial_bulk_composition));
+  }
+  catch (const std::exception& e) {
+    state.SkipWithError(e.what());
+  }
+
+  const SolverStats& stats = wrapper.get_stats();
+  const auto mean = benchmark::Counter::kAvgIterations;
+  state.counters["lp_iterations"] = benchmark::Counter(stats.lp_iterations, mean);
+  state.counters["reopt_iterations"] = benchmark::Counter(stats.reopt_iterations, mean);
+  state.counters["static_compounds"] = benchmark::Counter(stats.n_static_compounds, mean);
+  state.counters["dynamic_compounds"] = benchmark::Counter(stats.n_dynamic_compounds, mean);
+  state.counters["p99_us"] = stats.solve_latency.percentile(0.99) * 1e6;
+}
+BENCHMARK(BM_MinimizeCold)->Apply(pt_points)->Unit(benchmark::kMicrosecond);
+
+
+/**
+ * Minimize at a point with the Perple_X stage timers enabled, reporting the
+ * mean CPU time of each stage. If the hardware performance counters are
+ * available the mean cycles, instructions per cycle and cache and branch misses
+ * of the main stages are reported too.
+ */
+static void
+BM_MinimizeProfiled(benchmark::State& state)
+{
+  Wrapper& wrapper = const_cast<Wrapper&>(get_wrapper());
+  const double pressure = get_pressure(wrapper, state.range(0) / 100.0);
+  const double temperature = get_temperature(wrapper, state.range(1) / 100.0);
+
+  wrapper.set_profiling(true);
+  wrapper.reset_profile();
+  try {
+    wrapper.set_hardware_counting(true);
+  }
+  catch (const std::runtime_error&) {
+    // The counters are optional.
+  }
+
+  try {
+    for (auto _ : state)
+      benchmark::DoNotOptimize(wrapper.solve(pressure, temperature, 
+					     wrapper.initial_bulk_composition));
+  }
+  catch (const std::exception& e) {
+    state.SkipWithError(e.what());
+  }
+  wrapper.set_profiling(false);
+  const bool is_counted = wrapper.is_hardware_counting();
+  wrapper.set_hardware_counting(false);
+
+  const SolveProfile& profile = wrapper.get_profile();
+  const auto mean = benchmark::Counter::kAvgIterations;
+  state.counters["static_g"] = benchmark::Counter(profile.static_g_time, mean);
+  state.counters["static_lp"] = benchmark::Counter(profile.static_lp_time, mean);
+  state.counters["resub"] = benchmark::Counter(profile.resub_time, mean);
+  state.counters["dynamic_lp"] = benchmark::Counter(profile.dynamic_lp_time, mean);
+  state.counters["getloc"] = benchmark::Counter(profile.getloc_time, mean);
+  state.counters["total"] = benchmark::Counter(profile.total_time, mean);
+
+  if (is_counted) {
+    const std::pair<const char*, const HardwareCounters*> stages[] = {
+      { "static_g", &profile.static_g_hardware },
+      { "dynamic_lp", &profile.dynamic_lp_hardware },
+      { "getloc", &profile.getloc_hardware },
+      { "total", &profile.total_hardware }
+    };
+    for (const auto& stage : stages) {
+      const std::string name = stage.first;
+      const HardwareCounters& counts = *stage.second;
+      state.counters[name + "_cycles"] = benchmark::Counter(counts.cycles, mean);
+      state.counters[name + "_ipc"] = counts.cycles == 0 ? 0.0 :
+	static_cast<double>(counts.instructions) / counts.cycles;
+      state.counters[name + "_cache_misses"] = benchmark::Counter(counts.cache_misses, mean);
+      state.counters[name + "_branch_misses"] = benchmark::Counter(counts.branch_misses, mean);
+    }
+  }
+}
+BENCHMARK(BM_MinimizeProfiled)->Apply(pt_points)->Unit(benchmark::kMicrosecond);
+
+
+/**
+ * Look up results in a full ResultCache of the given capacity through
+ * Wrapper::minimize_into. Every lookup is a hit.
+ */
+static void
+BM_MinimizeCacheHit(benchmark::State& state)
+{
+  Wrapper& wrapper = const_cast<Wrapper&>(get_wrapper());
+  const size_t capacity = state.range(0);
+
+  // Fill the cache with copies of a single result at distinct temperatures
+  // rather than solving every point.
+  MinimizeResult result = wrapper.solve(get_pressure(wrapper, 0.5), 
+					get_temperature(wrapper, 0.5),
+					wrapper.initial_bulk_composition);
+  auto cache = std::make_shared<ResultCache>(capacity);
+  std::vector<double> temperatures;
+  for (size_t i = 0; i < capacity; ++i) {
+    result.temperature = get_temperature(wrapper, (i + 0.5) / capacity);
+    temperatures.push_back(result.temperature);
+    cache->put(result);
+  }
+  std::shuffle(temperatures.begin(), temperatures.end(), std::mt19937(42));
+  wrapper.set_cache_backend(cache);
+
+  MinimizeResult out;
+  size_t i = 0;
+  for (auto _ : state) {
+    wrapper.minimize_into(result.pressure, temperatures[i], out);
+    i = (i + 1) % capacity;
+  }
+
+  wrapper.set_cache_backend(nullptr);
+  state.counters["hit_rate"] = 
+    static_cast<double>(cache->get_n_hits()) / (cache->get_n_hits() + cache->get_n_misses());
+}
+BENCHMARK(BM_MinimizeCacheHit)
+  ->RangeMultiplier(8)->Range(8, 32768)->Unit(benchmark::kMicrosecond);
+
+
+/**
+ * Solve a P-T grid with minimize_batch using the given number of workers.
+ */
+static void
+BM_MinimizeBatch(benchmark::State& state)
+{
+  const Wrapper& wrapper = get_wrapper();
+  const std::vector<QueryPoint> points = 
+    make_query_grid(get_pressure(wrapper, 0.1), get_pressure(wrapper, 0.9), 4,
+		    get_temperature(wrapper, 0.1), get_temperature(wrapper, 0.9), 4);
+
+  try {
+    for (auto _ : state)
+      benchmark::DoNotOptimize(minimize_batch(wrapper, points, state.range(0)));
+  }
+  catch (const std::exception& e) {
+    state.SkipWithError(e.what());
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_MinimizeBatch)
+  ->Apply([](benchmark::internal::Benchmark* benchmark) {
+      benchmark->ArgName("workers")->Arg(1);
+      if (std::thread::hardware_concurrency() > 1)
+	benchmark->Arg(std::thread::hardware_concurrency());
+    })
+  ->UseRealTime()
+  ->Unit(benchmark::kMillisecond);
+
+
+/**
+ * Set the bulk composition, pressure and temperature in Perple_X.
+ */
+static void
+BM_StageSetInputs(benchmark::State& state)
+{
+  const Wrapper& wrapper = get_wrapper();
+  const double pressure = utils::convert_pascals_to_bar(get_pressure(wrapper, 0.5));
+  const double temperature = get_temperature(wrapper, 0.5);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < wrapper.n_composition_components; ++i)
+      f2c::bulk_props_set_composition(i, wrapper.initial_bulk_composition[i]);
+    f2c::solver_set_pressure(pressure);
+    f2c::solver_set_temperature(temperature);
+  }
+}
+BENCHMARK(BM_StageSetInputs);
+
+
+/**
+ * Silence and restore stdout, as done around every call into Perple_X.
+ */
+static void
+BM_StageRedirectStdout(benchmark::State& state)
+{
+  for (auto _ : state)
+    utils::enable_stdout(utils::disable_stdout());
+}
+BENCHMARK(BM_StageRedirectStdout);
+
+
+/**
+ * Run the MEEMUM minimization on its own.
+ */
+static void
+BM_StageMinimize(benchmark::State& state)
+{
+  const Wrapper& wrapper = get_wrapper();
+  wrapper.solve(get_pressure(wrapper, 0.5), get_temperature(wrapper, 0.5),
+		wrapper.initial_bulk_composition);
+
+  const int fd = utils::disable_stdout();
+  for (auto _ : state)
+    f2c::solver_minimize();
+  utils::enable_stdout(fd);
+}
+BENCHMARK(BM_StageMinimize)->Unit(benchmark::kMicrosecond);
+
+
+/**
+ * Export the result of a minimization from Perple_X.
+ */
+static void
+BM_StageExportResult(benchmark::State& state)
+{
+  const Wrapper& wrapper = get_wrapper();
+  wrapper.solve(get_pressure(wrapper, 0.5), get_temperature(wrapper, 0.5),
+		wrapper.initial_bulk_composition);
+
+  const size_t n_max = f2c::res_props_get_max_n();
+  std::vector<double> values(4 + n_max * (5 + wrapper.n_composition_components));
+  std::vector<int> ids(n_max);
+  size_t n;
+  for (auto _ : state) {
+    f2c::res_props_export(values.data(), ids.data(), &n);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_StageExportResult);
@@ -0,0 +1,79 @@
+      program meemm
+c----------------------------------------------------------------------
+c meemm - a minimal, non-interactive version of the MEEMUM driver 
+c program built from the perple_x sources without the perplex-cpp 
+c changes, for use as a reference. 
+c
+c the project name is read from the first line of standard input as in
+c MEEMUM. each following line holds P(bar), T(K) and the bulk 
+c composition, which is always read. the output of each point begins
+c with a line '#point n' and is followed by the output of calpr0, or by
+c '#failed' if the optimization failed. input ends at the end of the
+c file or at a line with a zero pressure.
+c----------------------------------------------------------------------
+      implicit none
+
+      include 'perplex_parameters.h'
+
+      integer i, ier, ipt
+
+      logical bad
+
+      double precision v,tr,pr,r,ps
+      common/ cst5  /v(l2),tr,pr,r,ps
+
+      integer iam
+      common/ cst4 /iam
+
+      integer iwt
+      common/ cst209 /iwt
+
+      double precision atwt
+      common/ cst45 /atwt(k0)
+
+      integer io3,io4,io9
+      common / cst41 /io3,io4,io9
+c----------------------------------------------------------------------
+c                                 iam is a flag indicating the perple_x
+c                                 program, 2 is meemum
+      iam = 2
+c                                 version info
+      call vrsion (6)
+c                                 read the project name and data files
+      call iniprp
+
+      ipt = 0
+
+      do 
+
+         read (*,*,iostat=ier) v(1), v(2), (cblk(i), i = 1, jbulk)
+
+         if (ier.ne.0.or.v(1).eq.0d0) exit
+
+         ipt = ipt + 1
+
+         write (*,'(/,a,i8)') '#point ', ipt
+c                                 convert to moles if needed
+         if (iwt.eq.1) then 
+            do i = 1, jbulk
+               cblk(i) = cblk(i)/atwt(i)
+            end do 
+         end if
+
+         call meemum (bad)
+
+         if (.not.bad) then
+
+            call calpr0 (6)
+
+            if (io3.eq.0) call calpr0 (n3)
+
+         else 
+
+            write (*,'(a)') '#failed'
+
+         end if 
+
+      end do
+
+      end 
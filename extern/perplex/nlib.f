@@ -35,6 +35,11 @@ c----------------------------------------------------------------------
       integer loclc
       common/ ae04mf /loclc(15)
 
+#ifdef PERPLEXCPP
+      integer lpitr, reitr, nstcpd, ndycpd
+      common/ cxtcpp /lpitr, reitr, nstcpd, ndycpd
+#endif
+
       double precision  wmach(9)
       common/ cstmch /wmach
 
@@ -186,7 +191,14 @@ c     move x onto the constraints in the working set.
       iw(2) = nfree
       iw(3) = nactiv
 
+#ifdef PERPLEXCPP
+c                                 count the iterations for perplex-cpp
+   60 lpitr = lpitr + iter
+
+      if (msg.eq.'optiml') then
+#else
    60 if (msg.eq.'optiml') then
+#endif
          idead = 0
       else if (msg.eq.'feasbl') then
          idead = 0
@@ -38,6 +38,11 @@ c-----------------------------------------------------------------------
       integer jphct,istart
       common/ cst111 /jphct,istart
 
+#ifdef PERPLEXCPP
+      integer lpitr, reitr, nstcpd, ndycpd
+      common/ cxtcpp /lpitr, reitr, nstcpd, ndycpd
+#endif
+
       double precision a,b,c
       common/ cst313 /a(k5,k1),b(k5),c(k1)
 
@@ -101,6 +106,10 @@ c                                load the adaptive refinement cpd g's
 c                                 idead = -1 tells lpnag to save parameters
 c                                 for subsequent warm starts
       idead = -1
+#ifdef PERPLEXCPP
+c                                 count the static compounds for perplex-cpp
+      nstcpd = jphct
+#endif
 
       if (lopt(28)) call begtim (2)
 
@@ -223,6 +232,11 @@ c-----------------------------------------------------------------------
       double precision g2, cp2, c2tot
       common/ cxt12 /g2(k21),cp2(k5,k21),c2tot(k21),jphct
 
+#ifdef PERPLEXCPP
+      integer lpitr, reitr, nstcpd, ndycpd
+      common/ cxtcpp /lpitr, reitr, nstcpd, ndycpd
+#endif
+
       double precision x
       common/ scrtch /x(k21)
 
@@ -285,6 +299,12 @@ c                                 cold start
 c                                 set idead = 0 to prevent lpnag from
 c                                 overwriting warm start parameters
          idead = 0 
+#ifdef PERPLEXCPP
+c                                 count the iterations and dynamic 
+c                                 compounds for perplex-cpp
+         reitr = reitr + 1
+         ndycpd = ndycpd + jphct - jpoint
+#endif
 
          if (lopt(28)) call begtim (8)
 c                                 do the optimization
@@ -293,7 +313,9 @@ c                                 do the optimization
 
          if (lopt(28)) then 
             call endtim (8,.true.,'Dynamic optimization N ')
+#if !defined(PERPLEXCPP) || defined(ALLOW_PERPLEX_OUTPUT)
             write (666,'(a,i6)') 'jphct = ',jphct
+#endif
          end if 
 c                                 warn if severe error
          if (idead.gt.0) then
@@ -3155,17 +3177,23 @@ c                                 the results to the print file.
 
          end do
 
+#if !defined(PERPLEXCPP) || defined(ALLOW_PERPLEX_OUTPUT)
          write (*,'(/,a,2x,g14.7,//,a)') 'sum of timed intervals ',cum,
      *                                 '----------------------------'
          write (666,'(/,a,2x,g14.7,//,a)') 'sum of timed intervals ',cum
      *                                ,'----------------------------'
+#endif
 
       end if 
 
       if (idead.eq.0) then
 c                                 compute derivative properties
+         if (lopt(28)) call begtim (9)
+
          call getloc (itri,jtri,ijpt,wt,nodata)
 
+         if (lopt(28)) call endtim (9,.false.,'GETLOC ')
+
          bad = .false.
 
       else 
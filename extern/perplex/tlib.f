@@ -5082,7 +5082,9 @@ c                                 check length
                write (*,1010) 
                cycle 
             end if 
-c                                 look for path characters / or \
+c                                 look for path characters / or \ (the comment must
+c                                 not end in a backslash as the sources are
+c                                 preprocessed)
             siz = kscan (100,1,'/')
             if (siz.eq.0) siz = kscan (100,1,'\')
 
@@ -6596,8 +6598,20 @@ c----------------------------------------------------------------------
       include 'perplex_parameters.h'
 
       integer itime
+#ifdef PERPLEXCPP_PERF_COUNTERS
+c                                 hardware counters of perplex-cpp
+      interface
+         subroutine pcbegn (itime) bind(c, name='perplexcpp_perf_begin')
+         use, intrinsic :: iso_c_binding, only: c_int
+         integer(c_int) itime
+         end subroutine
+      end interface
+#endif
 c----------------------------------------------------------------------
       call CPU_TIME(btime(itime))
+#ifdef PERPLEXCPP_PERF_COUNTERS
+      call pcbegn (itime)
+#endif
 
       end 
 
@@ -6614,11 +6628,24 @@ c----------------------------------------------------------------------
       character chars*(*)
 
       integer itime
+#ifdef PERPLEXCPP_PERF_COUNTERS
+c                                 hardware counters of perplex-cpp
+      interface
+         subroutine pcend (itime) bind(c, name='perplexcpp_perf_end')
+         use, intrinsic :: iso_c_binding, only: c_int
+         integer(c_int) itime
+         end subroutine
+      end interface
+#endif
 c----------------------------------------------------------------------
+#ifdef PERPLEXCPP_PERF_COUNTERS
+      call pcend (itime)
+#endif
 
       call CPU_TIME(etime(itime))
       times(itime) = times(itime) + (etime(itime)-btime(itime))
 
+#if !defined(PERPLEXCPP) || defined(ALLOW_PERPLEX_OUTPUT)
       if (output) then 
 
       write (*,'(/,a,3(2x,g14.7))') chars,
@@ -6629,6 +6656,7 @@ c----------------------------------------------------------------------
      *                              etime(itime)-btime(itime)
 
       end if 
+#endif
 
       end 
 
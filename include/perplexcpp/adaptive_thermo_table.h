@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_ADAPTIVETHERMOTABLE_H
+#define PERPLEXCPP_ADAPTIVETHERMOTABLE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/thermo_table.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A table of system properties on an adaptively refined pressure-temperature
+   * quadtree for a fixed bulk composition.
+   *
+   * Starting from the whole P-T range, a cell is split into four whenever the
+   * assemblage (the set of phases present) differs between its corners, centre
+   * and edge midpoints, or when bilinear interpolation from its corners predicts
+   * the properties at those points with a relative error above the tolerance.
+   * Refinement stops at the maximum depth. Cells are therefore small around phase
+   * boundaries such as the solidus and large where the properties vary smoothly.
+   *
+   * Each level of the tree is solved in parallel (see prewarm()). Lookups descend
+   * the tree in O(depth) and interpolate bilinearly within the leaf. Neighbouring
+   * leaves of different sizes do not share all of their corners so the
+   * interpolated properties may jump slightly across their common edge.
+   */
+  class AdaptiveThermoTable
+  {
+    public:
+
+      /**
+       * Build the table covering the pressure and temperature bounds of the
+       * problem.
+       *
+       * @param wrapper     The initialized wrapper.
+       * @param max_depth   The maximum depth of the tree. The smallest cells are
+       *                    1/2^max_depth of the range along each axis.
+       * @param rtol        The tolerance on the relative interpolation error
+       *                    (absolute for the melt fraction).
+       * @param min_depth   The depth to which every cell is refined.
+       * @param composition The bulk composition (empty for the initial bulk
+       *                    composition).
+       * @param melt_phases The names of the melt phases (see ThermoTable).
+       * @param n_workers   The number of worker processes used to build the
+       *                    table (zero for the number of hardware threads).
+       */
+      AdaptiveThermoTable(const Wrapper& wrapper,
+	                  const size_t max_depth,
+			  const double rtol=1e-3,
+			  const size_t min_depth=2,
+			  const std::vector<double>& composition=std::vector<double>(),
+			  const std::vector<std::string>& melt_phases=std::vector<std::string>(),
+			  const unsigned int n_workers=0);
+
+
+      /**
+       * Load a table written by save().
+       */
+      static AdaptiveThermoTable
+      load(const std::string& filename);
+
+
+      /**
+       * Write the table to a file.
+       */
+      void
+      save(const std::string& filename) const;
+
+
+      /**
+       * Interpolate a single property. Throws an exception if the point lies
+       * outside of the table.
+       *
+       * @param property    The property.
+       * @param pressure    The pressure (Pa).
+       * @param temperature The temperature (K).
+       */
+      double
+      interpolate(const ThermoProperty property,
+		  const double pressure,
+		  const double temperature) const;
+
+
+      /**
+       * Interpolate every property. Throws an exception if the point lies outside
+       * of the table.
+       *
+       * @param pressure    The pressure (Pa).
+       * @param temperature The temperature (K).
+       */
+      ThermoProperties
+      interpolate(const double pressure, const double temperature) const;
+
+
+      /**
+       * @return The number of points at which the properties are stored (and
+       *         hence the number of minimizations needed to build the table).
+       */
+      inline size_t
+      n_points() const { return this->values.size() / n_thermo_properties; }
+
+
+      /**
+       * @return The number of leaf cells.
+       */
+      inline size_t
+      n_leaves() const { return (this->nodes.size() - 1) / 4 * 3 + 1; }
+
+
+      /**
+       * @return The depth of the leaf containing a point.
+       */
+      size_t
+      depth(const double pressure, const double temperature) const;
+
+
+      /**
+       * The hash of the problem definition file used to build the table.
+       */
+      const std::uint64_t problem_hash;
+
+
+      /**
+       * The maximum depth of the tree.
+       */
+      const size_t max_depth;
+
+
+      /**
+       * The lowest pressure (Pa).
+       */
+      const double min_pressure;
+
+
+      /**
+       * The highest pressure (Pa).
+       */
+      const double max_pressure;
+
+
+      /**
+       * The lowest temperature (K).
+       */
+      const double min_temperature;
+
+
+      /**
+       * The highest temperature (K).
+       */
+      const double max_temperature;
+
+
+      /**
+       * The bulk composition.
+       */
+      const std::vector<double> composition;
+
+    private:
+
+      /**
+       * A cell of the tree.
+       */
+      struct Node
+      {
+	/**
+	 * The index of the first of the four children, ordered (low P, low T),
+	 * (low P, high T), (high P, low T), (high P, high T). Zero for a leaf.
+	 */
+	std::uint32_t children;
+
+	/**
+	 * The indices of the corner points in the same order as the children.
+	 */
+	std::uint32_t corners[4];
+      };
+
+
+      /**
+       * Construct a table from its contents.
+       */
+      AdaptiveThermoTable(const std::uint64_t problem_hash,
+	                  const size_t max_depth,
+			  const double min_pressure,
+			  const double max_pressure,
+			  const double min_temperature,
+			  const double max_temperature,
+			  const std::vector<double>& composition,
+			  std::vector<Node>&& nodes,
+			  std::vector<double>&& values);
+
+
+      /**
+       * The cells. The first is the root.
+       */
+      std::vector<Node> nodes;
+
+
+      /**
+       * The property values. Property k at point i is stored at index
+       * k * n_points() + i.
+       */
+      std::vector<double> values;
+
+
+      /**
+       * Find the leaf containing a point.
+       *
+       * @param u     Set to the position within the leaf along the pressure axis.
+       * @param v     Set to the position within the leaf along the temperature axis.
+       * @param depth Set to the depth of the leaf.
+       */
+      const Node&
+      find_leaf(const double pressure,
+		const double temperature,
+		double& u,
+		double& v,
+		size_t& depth) const;
+
+
+      /**
+       * Interpolate a property within a leaf.
+       */
+      inline double
+      interpolate(const ThermoProperty property,
+		  const Node& leaf,
+		  const double u,
+		  const double v) const
+      {
+	const double* column = this->values.data() + 
+			       static_cast<size_t>(property) * this->n_points();
+	return (1-u) * ((1-v) * column[leaf.corners[0]] + v * column[leaf.corners[1]]) +
+	       u * ((1-v) * column[leaf.corners[2]] + v * column[leaf.corners[3]]);
+      }
+  };
+}
+
+
+#endif
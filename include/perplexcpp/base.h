@@ -22,6 +22,8 @@
 #define PERPLEXCPP_BASE_H
 
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -115,8 +117,178 @@ namespace perplexcpp
   /**
    * Return the phase that matches the given name. Throws an exception if the name
    * does not match a known phase.
+   *
+   * This compares strings; for repeated lookups use the phase id (or a generated
+   * FixedResult, see fixed_result.h) instead.
    */
-  Phase find_phase(const std::vector<Phase> phases, const std::string name);
+  Phase
+  find_phase(const std::vector<Phase>& phases, const std::string& name);
+
+
+  /**
+   * Return the index into phases of the phase that matches the given name. This
+   * is the same as find_phase() but does not copy the phase.
+   */
+  size_t
+  find_phase_index(const std::vector<Phase>& phases, const std::string& name);
+
+
+  /**
+   * Counts from the hardware performance counters of the CPU over some part of
+   * one or more minimizations (see Wrapper::set_hardware_counting). Only user
+   * space is counted.
+   */
+  struct HardwareCounters
+  {
+    std::uint64_t cycles;
+
+    std::uint64_t instructions;
+
+    std::uint64_t cache_misses;
+
+    std::uint64_t branch_misses;
+
+
+    inline HardwareCounters&
+    operator+=(const HardwareCounters& other)
+    {
+      this->cycles += other.cycles;
+      this->instructions += other.instructions;
+      this->cache_misses += other.cache_misses;
+      this->branch_misses += other.branch_misses;
+      return *this;
+    }
+
+
+    inline HardwareCounters&
+    operator-=(const HardwareCounters& other)
+    {
+      this->cycles -= other.cycles;
+      this->instructions -= other.instructions;
+      this->cache_misses -= other.cache_misses;
+      this->branch_misses -= other.branch_misses;
+      return *this;
+    }
+  };
+
+
+
+  /**
+   * The CPU time spent in each stage of one or more minimizations, as measured
+   * by the Perple_X stage timers (see Wrapper::set_profiling). All times are in
+   * seconds.
+   */
+  struct SolveProfile
+  {
+    /**
+     * The number of minimizations measured.
+     */
+    size_t n_solves;
+
+    /**
+     * The time spent computing the Gibbs energies of the static compounds.
+     */
+    double static_g_time;
+
+    /**
+     * The time spent solving the linear program over the static compounds.
+     */
+    double static_lp_time;
+
+    /**
+     * The time spent generating refined compositions during reoptimization
+     * (resubstitution).
+     */
+    double resub_time;
+
+    /**
+     * The time spent solving the linear programs of the reoptimization.
+     */
+    double dynamic_lp_time;
+
+    /**
+     * The time spent computing the derivative properties of the result.
+     */
+    double getloc_time;
+
+    /**
+     * The time spent in the whole minimization.
+     */
+    double total_time;
+
+    /**
+     * The hardware counts of each of the stages above. These are zero unless
+     * hardware counting is enabled.
+     */
+    HardwareCounters static_g_hardware;
+    HardwareCounters static_lp_hardware;
+    HardwareCounters resub_hardware;
+    HardwareCounters dynamic_lp_hardware;
+    HardwareCounters getloc_hardware;
+    HardwareCounters total_hardware;
+
+
+    inline SolveProfile&
+    operator+=(const SolveProfile& other)
+    {
+      this->n_solves += other.n_solves;
+      this->static_g_time += other.static_g_time;
+      this->static_lp_time += other.static_lp_time;
+      this->resub_time += other.resub_time;
+      this->dynamic_lp_time += other.dynamic_lp_time;
+      this->getloc_time += other.getloc_time;
+      this->total_time += other.total_time;
+      this->static_g_hardware += other.static_g_hardware;
+      this->static_lp_hardware += other.static_lp_hardware;
+      this->resub_hardware += other.resub_hardware;
+      this->dynamic_lp_hardware += other.dynamic_lp_hardware;
+      this->getloc_hardware += other.getloc_hardware;
+      this->total_hardware += other.total_hardware;
+      return *this;
+    }
+  };
+
+
+
+  /**
+   * Counts of the work done by the solver in a minimization.
+   */
+  struct SolveCounters
+  {
+    /**
+     * The number of iterations taken by the linear program solver.
+     */
+    size_t lp_iterations;
+
+    /**
+     * The number of iterations of the reoptimization (resubstitution) loop.
+     */
+    size_t reopt_iterations;
+
+    /**
+     * The number of static pseudocompounds passed to the linear program.
+     */
+    size_t n_static_compounds;
+
+    /**
+     * The number of dynamic pseudocompounds passed to the linear programs of
+     * the reoptimization, summed over its iterations.
+     */
+    size_t n_dynamic_compounds;
+
+    /**
+     * Whether the result was taken from a cache. If it was the other counters
+     * are zero.
+     */
+    bool cache_hit;
+
+    /**
+     * The hardware counts of the whole call, including any cache lookup. These
+     * are zero unless hardware counting is enabled.
+     */
+    HardwareCounters hardware;
+  };
+
 
 
   /**
@@ -168,6 +340,60 @@ namespace perplexcpp
      */
     double molar_heat_capacity;
   };
+
+
+
+  /**
+   * A read-only view of a contiguous array of doubles such as a bulk
+   * composition. It may be constructed implicitly from a std::vector or an
+   * array so that callers can pass their data without copying it. The data
+   * must outlive the view.
+   */
+  class DoubleSpan
+  {
+    public:
+
+      DoubleSpan(const double* data, const size_t size) 
+	: ptr(data), length(size) {}
+
+
+      DoubleSpan(const std::vector<double>& values) 
+	: ptr(values.data()), length(values.size()) {}
+
+
+      template <size_t N>
+      DoubleSpan(const double (&values)[N]) : ptr(values), length(N) {}
+
+
+      inline const double*
+      data() const { return this->ptr; }
+
+
+      inline size_t
+      size() const { return this->length; }
+
+
+      inline bool
+      empty() const { return this->length == 0; }
+
+
+      inline const double*
+      begin() const { return this->ptr; }
+
+
+      inline const double*
+      end() const { return this->ptr + this->length; }
+
+
+      inline double
+      operator[](const size_t i) const { return this->ptr[i]; }
+
+    private:
+
+      const double* ptr;
+
+      size_t length;
+  };
 }
 
 
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_CACHEBACKEND_H
+#define PERPLEXCPP_CACHEBACKEND_H
+
+
+#include <cstddef>
+#include <vector>
+
+#include <perplexcpp/base.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * Interface shared by all of the result caches. The wrapper can be given
+   * any implementation of this class (see Wrapper::set_cache_backend()) to
+   * consult before performing a minimization.
+   */
+  class CacheBackend
+  {
+    public:
+
+      virtual ~CacheBackend() = default;
+
+
+      /**
+       * Try to retrieve an item from the cache. Returns 0 if successful and -1 if not.
+       */
+      virtual int
+      get(const double pressure,
+	  const double temperature,
+	  const std::vector<double> &composition,
+	  MinimizeResult &out) = 0;
+
+
+      /**
+       * Add an item to the cache.
+       */
+      virtual void
+      put(const MinimizeResult& result) = 0;
+
+
+      /**
+       * @return The number of items stored in the cache.
+       */
+      virtual size_t
+      size() const = 0;
+
+
+      /**
+       * Reset the hit and miss counters to zero.
+       */
+      virtual void
+      reset_counters() = 0;
+
+
+      virtual unsigned int
+      get_n_hits() const = 0;
+
+
+      virtual unsigned int
+      get_n_misses() const = 0;
+  };
+}
+
+
+#endif
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_COMPOSITIONTABLE_H
+#define PERPLEXCPP_COMPOSITIONTABLE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/prewarm.h>
+#include <perplexcpp/thermo_table.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A table of system properties over pressure, temperature and a range of bulk
+   * compositions, stored as a sparse grid.
+   *
+   * A dense grid with m points along each of d axes needs m^d minimizations,
+   * which is infeasible once a few composition components vary. A sparse grid
+   * of level L instead combines only the hierarchical subspaces whose levels
+   * sum to at most L, needing O(2^L L^(d-1)) points for an interpolation error
+   * of O(4^-L L^(d-1)) if the properties are smooth. The properties are
+   * interpolated with piecewise (multi)linear basis functions and the table
+   * stores their hierarchical surpluses: the difference between the solved
+   * value at each point and the interpolant of the coarser levels there.
+   *
+   * Phase boundaries make the properties non-smooth so the error near them is
+   * considerably larger than elsewhere. Use validate() to measure the error
+   * against direct minimizations.
+   */
+  class CompositionTable
+  {
+    public:
+
+      /**
+       * Build the table covering the pressure and temperature bounds of the
+       * problem and a box of bulk compositions.
+       *
+       * @param wrapper         The initialized wrapper.
+       * @param level           The level of the sparse grid. Each axis is
+       *                        resolved to 1/2^level of its range.
+       * @param min_composition The lower bound of each composition component.
+       * @param max_composition The upper bound of each composition component.
+       *                        Components with equal bounds are held fixed.
+       * @param melt_phases     The names of the melt phases (see ThermoTable).
+       * @param n_workers       The number of worker processes used to build the
+       *                        table (zero for the number of hardware threads).
+       */
+      CompositionTable(const Wrapper& wrapper,
+	               const size_t level,
+		       const std::vector<double>& min_composition,
+		       const std::vector<double>& max_composition,
+		       const std::vector<std::string>& melt_phases=std::vector<std::string>(),
+		       const unsigned int n_workers=0);
+
+
+      /**
+       * Load a table written by save().
+       */
+      static CompositionTable
+      load(const std::string& filename);
+
+
+      /**
+       * Write the table to a file (see TableWriter).
+       */
+      void
+      save(const std::string& filename) const;
+
+
+      /**
+       * Interpolate a single property. Throws an exception if the point lies
+       * outside of the table.
+       *
+       * @param property    The property.
+       * @param pressure    The pressure (Pa).
+       * @param temperature The temperature (K).
+       * @param composition The bulk composition. The fixed components are
+       *                    ignored.
+       */
+      double
+      interpolate(const ThermoProperty property,
+		  const double pressure,
+		  const double temperature,
+		  const std::vector<double>& composition) const;
+
+
+      /**
+       * Interpolate every property. Throws an exception if the point lies outside
+       * of the table.
+       */
+      ThermoProperties
+      interpolate(const double pressure,
+		  const double temperature,
+		  const std::vector<double>& composition) const;
+
+
+      /**
+       * Measure the interpolation error by comparing the table against direct
+       * minimizations at random points within it.
+       *
+       * @param wrapper   The initialized wrapper.
+       * @param n_samples The number of points to compare.
+       * @param n_workers The number of worker processes used to solve the points.
+       * @param seed      The seed for the random points.
+       *
+       * @return For each property the largest relative error (the absolute
+       *         error for the melt fraction).
+       */
+      ThermoProperties
+      validate(const Wrapper& wrapper,
+	       const size_t n_samples,
+	       const unsigned int n_workers=0,
+	       const unsigned int seed=0) const;
+
+
+      /**
+       * @return The number of points at which the properties are stored (and
+       *         hence the number of minimizations needed to build the table).
+       */
+      inline size_t
+      n_points() const { return this->surpluses.size() / n_thermo_properties; }
+
+
+      /**
+       * @return The number of dimensions of the table: pressure, temperature and
+       *         the composition components that vary.
+       */
+      inline size_t
+      n_dimensions() const { return 2 + this->varying_components.size(); }
+
+
+      /**
+       * The hash of the problem definition file used to build the table.
+       */
+      const std::uint64_t problem_hash;
+
+
+      /**
+       * The level of the sparse grid.
+       */
+      const size_t level;
+
+
+      /**
+       * The lowest pressure (Pa).
+       */
+      const double min_pressure;
+
+
+      /**
+       * The highest pressure (Pa).
+       */
+      const double max_pressure;
+
+
+      /**
+       * The lowest temperature (K).
+       */
+      const double min_temperature;
+
+
+      /**
+       * The highest temperature (K).
+       */
+      const double max_temperature;
+
+
+      /**
+       * The lower bound of each composition component.
+       */
+      const std::vector<double> min_composition;
+
+
+      /**
+       * The upper bound of each composition component.
+       */
+      const std::vector<double> max_composition;
+
+    private:
+
+      /**
+       * Construct a table from its contents.
+       */
+      CompositionTable(const std::uint64_t problem_hash,
+	               const size_t level,
+		       const double min_pressure,
+		       const double max_pressure,
+		       const double min_temperature,
+		       const double max_temperature,
+		       const std::vector<double>& min_composition,
+		       const std::vector<double>& max_composition,
+		       const std::vector<bool>& is_melt_phase,
+		       std::vector<double>&& surpluses);
+
+
+      /**
+       * The indices of the composition components that vary.
+       */
+      std::vector<size_t> varying_components;
+
+
+      /**
+       * Whether or not each phase is counted as melt, as resolved when the table
+       * was built, so that validate() compares the same melt fraction.
+       */
+      std::vector<bool> is_melt_phase;
+
+
+      /**
+       * The levels of each hierarchical subspace along each dimension, ordered by
+       * the sum of the levels. Subspace s has levels
+       * subspace_levels[s * n_dimensions() + d].
+       */
+      std::vector<std::uint8_t> subspace_levels;
+
+
+      /**
+       * The index of the first point of each subspace. The points of a subspace
+       * form a dense grid ordered with the last dimension varying fastest.
+       */
+      std::vector<size_t> subspace_offsets;
+
+
+      /**
+       * The hierarchical surpluses. Property k at point i is stored at index
+       * k * n_points() + i.
+       */
+      std::vector<double> surpluses;
+
+
+      /**
+       * Enumerate the subspaces and their offsets.
+       *
+       * @return The total number of points.
+       */
+      size_t
+      make_subspaces();
+
+
+      /**
+       * @return The position of a point scaled to the unit hypercube. Throws an
+       *         exception if it lies outside of the table.
+       */
+      std::vector<double>
+      scale(const double pressure,
+	    const double temperature,
+	    const std::vector<double>& composition) const;
+
+
+      /**
+       * @return The point at a position within the unit hypercube.
+       */
+      QueryPoint
+      unscale(const std::vector<double>& x) const;
+
+
+      /**
+       * Evaluate the interpolant of each property at a scaled position.
+       *
+       * @param out Set to the value of each property.
+       */
+      void
+      evaluate(const std::vector<double>& x, double* out) const;
+  };
+}
+
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_CONCURRENTRESULTCACHE_H
+#define PERPLEXCPP_CONCURRENTRESULTCACHE_H
+
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <perplexcpp/base.h>
+#include <perplexcpp/cache_backend.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A result cache that may be used from many threads at once.
+   *
+   * The items are split between a number of shards, each protected by its own
+   * reader-writer lock, so lookups never block each other and insertions only
+   * block lookups of the same shard. Eviction uses the CLOCK approximation of
+   * LRU: a hit only sets the (atomic) reference bit of the item rather than
+   * reordering a list, so lookups can safely happen under a shared lock.
+   *
+   * Items are assigned to shards by a hash of their exact key. With a nonzero
+   * tolerance a near match may live in a different shard, so the home shard is
+   * searched first and then the rest.
+   */
+  class ConcurrentResultCache : public CacheBackend
+  {
+    public:
+
+      /**
+       * The max number of results that may be saved.
+       */
+      const size_t capacity;
+
+
+      /**
+       * The number of shards.
+       */
+      const size_t n_shards;
+
+
+      /**
+       * Constructor.
+       *
+       * @param capacity The max number of results that may be saved. This is
+       *                 divided evenly between the shards.
+       * @param rtol     The cache tolerance.
+       * @param n_shards The number of shards.
+       */
+      ConcurrentResultCache(const size_t capacity,
+	                    const double rtol=0.0,
+			    const size_t n_shards=16);
+
+
+      ~ConcurrentResultCache();
+
+
+      /**
+       * Try to retrieve an item from the cache. Returns 0 if successful and -1 if not.
+       * This is safe to call concurrently with any other method.
+       */
+      int
+      get(const double pressure,
+	  const double temperature,
+	  const std::vector<double> &composition,
+	  MinimizeResult &out) override;
+
+
+      /**
+       * Add an item to the cache. This is safe to call concurrently with any other
+       * method.
+       */
+      void
+      put(const MinimizeResult& result) override;
+
+
+      /**
+       * @return The size of the cache.
+       */
+      size_t
+      size() const override;
+
+
+      /**
+       * Reset the hit and miss counters to zero.
+       */
+      void
+      reset_counters() override;
+
+
+      inline unsigned int
+      get_n_hits() const override { return this->n_hits.load(std::memory_order_relaxed); }
+
+
+      inline unsigned int
+      get_n_misses() const override { return this->n_misses.load(std::memory_order_relaxed); }
+
+
+      ConcurrentResultCache(ConcurrentResultCache const&) = delete;
+      void operator=(ConcurrentResultCache const&) = delete;
+
+    private:
+
+      struct Shard;
+
+
+      /**
+       * The cache tolerance.
+       */
+      const double rtol;
+
+
+      /**
+       * The number of hits.
+       */
+      std::atomic<unsigned int> n_hits;
+
+
+      /**
+       * The number of misses.
+       */
+      std::atomic<unsigned int> n_misses;
+
+
+      /**
+       * The shards.
+       */
+      std::vector<std::unique_ptr<Shard>> shards;
+
+
+      /**
+       * @return The index of the shard that an exact key is stored in.
+       */
+      size_t
+      home_shard(const double pressure,
+	         const double temperature,
+		 const std::vector<double>& composition) const;
+
+
+      /**
+       * Search a single shard. Returns true if the item was found.
+       */
+      bool
+      find_in_shard(Shard& shard,
+	            const double pressure,
+		    const double temperature,
+		    const std::vector<double>& composition,
+		    MinimizeResult& out) const;
+  };
+}
+
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_FIXEDRESULT_H
+#define PERPLEXCPP_FIXEDRESULT_H
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <perplexcpp/base.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * The properties of a phase in a FixedResult.
+   */
+  template <size_t NComp>
+  struct FixedPhase
+  {
+    double weight_frac;
+
+    double volume_frac;
+
+    double molar_frac;
+
+    /**
+     * The amount of the phase (mol).
+     */
+    double n_moles;
+
+    /**
+     * The density (kg/m3).
+     */
+    double density;
+
+    /**
+     * The number of moles of each composition component per mole of phase.
+     */
+    std::array<double,NComp> composition_ratio;
+  };
+
+
+
+  /**
+   * A MinimizeResult for a problem with a known number of composition components
+   * and phases.
+   *
+   * Every array has a fixed size so the result is a trivially copyable type of
+   * fixed size with no heap storage: it can be sent as a single MPI message,
+   * memcpy'd into a cache or stored in arrays for vectorized post-processing.
+   * The phases are stored in Wrapper::phase_names order and are looked up by
+   * index (or by an enum, see below) rather than by name.
+   *
+   * The types for a particular problem file, along with enums naming its
+   * components and phases, can be generated at build time with the CMake
+   * function perplexcpp_generate_fixed_result (see tools/CMakeLists.txt).
+   */
+  template <size_t NComp, size_t NPhase>
+  struct FixedResult
+  {
+    static const size_t n_components = NComp;
+
+    static const size_t n_phases = NPhase;
+
+
+    /**
+     * The pressure (Pa).
+     */
+    double pressure;
+
+    /**
+     * The temperature (K).
+     */
+    double temperature;
+
+    /**
+     * The bulk composition.
+     */
+    std::array<double,NComp> composition;
+
+    /**
+     * The density (kg/m3).
+     */
+    double density;
+
+    /**
+     * The expansivity (1/K).
+     */
+    double expansivity;
+
+    /**
+     * The molar entropy (J/K).
+     */
+    double molar_entropy;
+
+    /**
+     * The molar heat capacity (J/K).
+     */
+    double molar_heat_capacity;
+
+    /**
+     * The phases, indexed by phase id.
+     */
+    std::array<FixedPhase<NComp>,NPhase> phases;
+
+
+    /**
+     * @return The phase with a compile-time index.
+     */
+    template <size_t I>
+    inline const FixedPhase<NComp>&
+    phase() const 
+    {
+      static_assert(I < NPhase, "The phase index is out of range");
+      return this->phases[I];
+    }
+
+
+    /**
+     * @return The phase identified by an enumerator (e.g. a generated PhaseId).
+     */
+    template <typename Id>
+    inline const FixedPhase<NComp>&
+    phase(const Id id) const { return this->phases[static_cast<size_t>(id)]; }
+  };
+
+
+  template <size_t NComp, size_t NPhase>
+  const size_t FixedResult<NComp,NPhase>::n_components;
+
+
+  template <size_t NComp, size_t NPhase>
+  const size_t FixedResult<NComp,NPhase>::n_phases;
+
+
+
+  /**
+   * Copy a MinimizeResult into a FixedResult. Throws an exception if the numbers
+   * of components or phases differ.
+   */
+  template <size_t NComp, size_t NPhase>
+  void
+  copy_to_fixed(const MinimizeResult& result, FixedResult<NComp,NPhase>& out)
+  {
+    if (result.composition.size() != NComp || result.phases.size() != NPhase)
+      throw std::invalid_argument("The result does not match the fixed result size");
+
+    out.pressure = result.pressure;
+    out.temperature = result.temperature;
+    std::copy(result.composition.begin(), result.composition.end(), 
+	      out.composition.begin());
+    out.density = result.density;
+    out.expansivity = result.expansivity;
+    out.molar_entropy = result.molar_entropy;
+    out.molar_heat_capacity = result.molar_heat_capacity;
+
+    for (size_t p = 0; p < NPhase; ++p) {
+      const Phase& phase = result.phases[p];
+      FixedPhase<NComp>& fixed = out.phases[p];
+      if (phase.composition_ratio.size() != NComp)
+	throw std::invalid_argument("The result does not match the fixed result size");
+
+      fixed.weight_frac = phase.weight_frac;
+      fixed.volume_frac = phase.volume_frac;
+      fixed.molar_frac = phase.molar_frac;
+      fixed.n_moles = phase.n_moles;
+      fixed.density = phase.density;
+      std::copy(phase.composition_ratio.begin(), phase.composition_ratio.end(), 
+		fixed.composition_ratio.begin());
+    }
+  }
+
+
+
+  /**
+   * Copy a FixedResult into a MinimizeResult, reusing its storage.
+   *
+   * @param phase_names The phase names (e.g. Wrapper::phase_names).
+   */
+  template <size_t NComp, size_t NPhase>
+  void
+  copy_from_fixed(const FixedResult<NComp,NPhase>& result,
+		  const std::vector<PhaseName>& phase_names,
+		  MinimizeResult& out)
+  {
+    if (phase_names.size() != NPhase)
+      throw std::invalid_argument("The number of phase names is wrong");
+
+    out.pressure = result.pressure;
+    out.temperature = result.temperature;
+    out.composition.assign(result.composition.begin(), result.composition.end());
+    out.density = result.density;
+    out.expansivity = result.expansivity;
+    out.molar_entropy = result.molar_entropy;
+    out.molar_heat_capacity = result.molar_heat_capacity;
+
+    out.phases.resize(NPhase);
+    for (size_t p = 0; p < NPhase; ++p) {
+      const FixedPhase<NComp>& fixed = result.phases[p];
+      Phase& phase = out.phases[p];
+
+      phase.id = p;
+      phase.name = phase_names[p];
+      phase.weight_frac = fixed.weight_frac;
+      phase.volume_frac = fixed.volume_frac;
+      phase.molar_frac = fixed.molar_frac;
+      phase.n_moles = fixed.n_moles;
+      phase.density = fixed.density;
+      phase.composition_ratio.assign(fixed.composition_ratio.begin(), 
+				     fixed.composition_ratio.end());
+    }
+  }
+
+
+
+  /**
+   * Perform the minimization (see Wrapper::minimize_into) and write the result
+   * into a FixedResult. Throws an exception if the problem does not have NComp
+   * components and NPhase phases.
+   */
+  template <size_t NComp, size_t NPhase>
+  void
+  minimize_into(const Wrapper& wrapper,
+		const double pressure,
+		const double temperature,
+		const DoubleSpan composition,
+		FixedResult<NComp,NPhase>& out)
+  {
+    if (wrapper.n_composition_components != NComp || wrapper.n_phases != NPhase)
+      throw std::invalid_argument("The problem does not match the fixed result size");
+
+    // Reuse the storage of the intermediate result between calls. Like the
+    // wrapper itself this is not thread safe.
+    static MinimizeResult result;
+    wrapper.minimize_into(pressure, temperature, composition, result);
+    copy_to_fixed(result, out);
+  }
+}
+
+
+#endif
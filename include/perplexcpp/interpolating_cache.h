@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_INTERPOLATINGCACHE_H
+#define PERPLEXCPP_INTERPOLATINGCACHE_H
+
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <perplexcpp/base.h>
+#include <perplexcpp/cache_backend.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A cache that, rather than requiring a near exact match, interpolates
+   * between the nearest cached results.
+   *
+   * Each result is stored as a point in normalized (P, T, composition) space
+   * (each coordinate is divided by a user provided scale) and indexed with a
+   * kd-tree. A lookup finds the k nearest neighbours and, provided that they all
+   * lie within the distance threshold and share the same stable assemblage (the
+   * same set of phases with a nonzero amount), returns an inverse distance
+   * weighted interpolation of them. Otherwise the lookup misses and a real
+   * minimization should be performed.
+   */
+  class InterpolatingCache : public CacheBackend
+  {
+    public:
+
+      /**
+       * The max number of results that may be saved.
+       */
+      const size_t capacity;
+
+
+      /**
+       * The number of neighbours used for the interpolation.
+       */
+      const size_t n_neighbours;
+
+
+      /**
+       * Constructor.
+       *
+       * @param capacity          The max number of results that may be saved.
+       * @param n_neighbours      The number of neighbours to interpolate between.
+       * @param max_distance      The maximum (normalized) distance a neighbour may
+       *                          lie from the query point.
+       * @param pressure_scale    The pressure normalization (Pa).
+       * @param temperature_scale The temperature normalization (K).
+       * @param composition_scale The composition normalization.
+       */
+      InterpolatingCache(const size_t capacity,
+	                 const size_t n_neighbours,
+			 const double max_distance,
+			 const double pressure_scale,
+			 const double temperature_scale,
+			 const double composition_scale=1.0);
+
+
+      /**
+       * Try to interpolate a result from the cache. Returns 0 if successful and -1
+       * if not.
+       */
+      int
+      get(const double pressure,
+	  const double temperature,
+	  const std::vector<double> &composition,
+	  MinimizeResult &out) override;
+
+
+      /**
+       * Try to interpolate a result from the cache. Returns 0 if successful and -1
+       * if not.
+       *
+       * @param error_estimate The estimated interpolation error. This is the
+       *                       largest deviation of any neighbour from the
+       *                       interpolated value, measured as the relative density
+       *                       or the absolute phase molar fraction.
+       */
+      int
+      get(const double pressure,
+	  const double temperature,
+	  const std::vector<double> &composition,
+	  MinimizeResult &out,
+	  double &error_estimate);
+
+
+      /**
+       * Add an item to the cache. If the cache is full then the oldest items are
+       * discarded.
+       */
+      void
+      put(const MinimizeResult& result) override;
+
+
+      /**
+       * @return The size of the cache.
+       */
+      size_t
+      size() const override;
+
+
+      /**
+       * Reset the hit and miss counters to zero.
+       */
+      void
+      reset_counters() override;
+
+
+      /**
+       * @param max_distance The maximum (normalized) distance a neighbour may lie
+       *                     from the query point.
+       */
+      void
+      set_max_distance(const double max_distance);
+
+
+      inline double
+      get_max_distance() const { return this->max_distance; }
+
+
+      /**
+       * @return The error estimate of the most recent successful lookup.
+       */
+      inline double
+      get_last_error_estimate() const { return this->last_error_estimate; }
+
+
+      inline unsigned int
+      get_n_hits() const override { return this->n_hits; }
+
+
+      inline unsigned int
+      get_n_misses() const override { return this->n_misses; }
+
+    private:
+
+      /**
+       * A cached result along with its location in normalized space and its
+       * stable assemblage.
+       */
+      struct Item
+      {
+	std::vector<double> point;
+
+	std::vector<size_t> assemblage;
+
+	MinimizeResult result;
+      };
+
+
+      /**
+       * A node of the kd-tree. The children are indices into the node array
+       * (-1 if absent).
+       */
+      struct Node
+      {
+	size_t item;
+
+	size_t axis;
+
+	long left;
+
+	long right;
+      };
+
+
+      /**
+       * The maximum distance a neighbour may lie from the query point.
+       */
+      double max_distance;
+
+
+      /**
+       * The normalizations applied to pressure, temperature and composition.
+       */
+      const double pressure_scale;
+
+      const double temperature_scale;
+
+      const double composition_scale;
+
+
+      /**
+       * The error estimate of the most recent successful lookup.
+       */
+      double last_error_estimate = 0.0;
+
+
+      /**
+       * The number of hits.
+       */
+      unsigned int n_hits = 0;
+
+
+      /**
+       * The number of misses.
+       */
+      unsigned int n_misses = 0;
+
+
+      /**
+       * The items stored in the cache, oldest first.
+       */
+      std::vector<Item> items;
+
+
+      /**
+       * The kd-tree nodes. The first node is the root.
+       */
+      std::vector<Node> nodes;
+
+
+      /**
+       * The number of insertions since the tree was last rebalanced.
+       */
+      size_t n_unbalanced_inserts = 0;
+
+
+      /**
+       * @return The normalized location of the given state.
+       */
+      std::vector<double>
+      make_point(const double pressure,
+	         const double temperature,
+		 const std::vector<double>& composition) const;
+
+
+      /**
+       * Rebuild a balanced kd-tree from the stored items.
+       */
+      void
+      rebuild_tree();
+
+
+      /**
+       * Recursively build a balanced subtree from the given items and return the
+       * index of its root node.
+       */
+      long
+      build_subtree(std::vector<size_t>& item_idxs,
+	            const size_t begin,
+		    const size_t end,
+		    const size_t depth);
+
+
+      /**
+       * Insert a single item into the tree without rebalancing.
+       */
+      void
+      insert_into_tree(const size_t item_idx);
+
+
+      /**
+       * Recursively search the tree for the nearest neighbours of a point. The
+       * neighbours are stored as a max-heap of (squared distance, item) pairs.
+       */
+      void
+      search(const long node_idx,
+	     const std::vector<double>& point,
+	     std::vector<std::pair<double,size_t>>& heap) const;
+  };
+}
+
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_MAPPEDCACHE_H
+#define PERPLEXCPP_MAPPEDCACHE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/base.h>
+#include <perplexcpp/cache_backend.h>
+
+
+namespace perplexcpp
+{
+  class MappedResultTable;
+
+
+  /**
+   * A result cache stored in a memory mapped file or shared memory object.
+   *
+   * The object holds a fixed-size hash table along with the hash of the problem
+   * definition file it was created for. Any number of processes may map the same
+   * object and read and insert results concurrently; new results only become
+   * visible once they have been completely written. Only exact matches are
+   * returned and nothing is ever evicted: once the table is full new results are
+   * discarded.
+   *
+   * PersistentCache and SharedMemoryCache open the object to map.
+   */
+  class MappedCache : public CacheBackend
+  {
+    public:
+
+      /**
+       * Map the table stored in an open object, creating it if the object is
+       * empty. Throws an exception if it was created for a different problem.
+       *
+       * @param fd           The open file descriptor. It is closed by the
+       *                     constructor.
+       * @param name         The name of the object (used in error messages).
+       * @param problem_hash The hash of the problem definition file (see
+       *                     Wrapper::problem_file_hash).
+       * @param n_components The number of composition components.
+       * @param phase_names  The phase names (see Wrapper::phase_names).
+       * @param n_slots      The max number of results that may be saved. This is
+       *                     ignored if the table already exists.
+       */
+      MappedCache(const int fd,
+	          const std::string& name,
+		  const std::uint64_t problem_hash,
+		  const size_t n_components,
+		  const std::vector<PhaseName>& phase_names,
+		  const size_t n_slots);
+
+
+      ~MappedCache();
+
+
+      /**
+       * Try to retrieve an item from the cache. Returns 0 if successful and -1 if not.
+       */
+      int
+      get(const double pressure,
+	  const double temperature,
+	  const std::vector<double> &composition,
+	  MinimizeResult &out) override;
+
+
+      /**
+       * Add an item to the cache.
+       */
+      void
+      put(const MinimizeResult& result) override;
+
+
+      /**
+       * @return The number of results stored in the table.
+       */
+      size_t
+      size() const override;
+
+
+      /**
+       * Reset the hit and miss counters to zero.
+       */
+      void
+      reset_counters() override;
+
+
+      inline unsigned int
+      get_n_hits() const override { return this->n_hits; }
+
+
+      inline unsigned int
+      get_n_misses() const override { return this->n_misses; }
+
+
+      MappedCache(MappedCache const&) = delete;
+      void operator=(MappedCache const&) = delete;
+
+    private:
+
+      /**
+       * The size of the mapping (bytes).
+       */
+      size_t length = 0;
+
+
+      /**
+       * The start of the mapping.
+       */
+      void* memory = nullptr;
+
+
+      /**
+       * The table stored in the mapping.
+       */
+      std::unique_ptr<MappedResultTable> table;
+
+
+      /**
+       * The number of hits.
+       */
+      unsigned int n_hits = 0;
+
+
+      /**
+       * The number of misses.
+       */
+      unsigned int n_misses = 0;
+  };
+}
+
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_PERSISTENTCACHE_H
+#define PERPLEXCPP_PERSISTENTCACHE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/base.h>
+#include <perplexcpp/mapped_cache.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A result cache that is stored in a memory mapped file so that it persists
+   * between runs.
+   *
+   * The file holds a fixed-size hash table along with the hash of the problem
+   * definition file it was created for. Any number of processes may open the same
+   * file and read and insert results concurrently; new results only become visible
+   * once they have been completely written. Only exact matches are returned and
+   * nothing is ever evicted: once the table is full new results are discarded.
+   */
+  class PersistentCache : public MappedCache
+  {
+    public:
+
+      /**
+       * Open the cache file, creating it if it does not exist. Throws an exception
+       * if the file was created for a different problem.
+       *
+       * @param filename     The cache file.
+       * @param problem_hash The hash of the problem definition file (see
+       *                     Wrapper::problem_file_hash).
+       * @param n_components The number of composition components.
+       * @param phase_names  The phase names (see Wrapper::phase_names).
+       * @param n_slots      The max number of results that may be saved. This is
+       *                     ignored if the file already exists.
+       */
+      PersistentCache(const std::string& filename,
+	              const std::uint64_t problem_hash,
+		      const size_t n_components,
+		      const std::vector<PhaseName>& phase_names,
+		      const size_t n_slots=65536);
+  };
+}
+
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_PREWARM_H
+#define PERPLEXCPP_PREWARM_H
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/cache_backend.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A point at which a minimization is requested.
+   */
+  struct QueryPoint
+  {
+    /**
+     * The pressure (Pa).
+     */
+    double pressure;
+
+    /**
+     * The temperature (K).
+     */
+    double temperature;
+
+    /**
+     * The bulk composition. If empty the initial bulk composition is used.
+     */
+    std::vector<double> composition;
+  };
+
+
+
+  /**
+   * Make a regular pressure-temperature grid of query points.
+   *
+   * @param min_pressure    The lowest pressure (Pa).
+   * @param max_pressure    The highest pressure (Pa).
+   * @param n_pressures     The number of pressures.
+   * @param min_temperature The lowest temperature (K).
+   * @param max_temperature The highest temperature (K).
+   * @param n_temperatures  The number of temperatures.
+   * @param composition     The bulk composition at every point (empty for the
+   *                        initial bulk composition).
+   *
+   * @return The points, ordered by pressure and then temperature.
+   */
+  std::vector<QueryPoint>
+  make_query_grid(const double min_pressure,
+                  const double max_pressure,
+		  const size_t n_pressures,
+		  const double min_temperature,
+		  const double max_temperature,
+		  const size_t n_temperatures,
+		  const std::vector<double>& composition=std::vector<double>());
+
+
+  /**
+   * Read query points from a text file. Each line holds the pressure (Pa), the
+   * temperature (K) and optionally the bulk composition, separated by
+   * whitespace. Blank lines and lines starting with '#' are ignored.
+   */
+  std::vector<QueryPoint>
+  read_query_points(const std::string& filename);
+
+
+  /**
+   * Solve a set of query points ahead of time and add the results to a cache.
+   *
+   * Perple_X cannot be used from multiple threads so the points are divided
+   * between forked worker processes that each hold a copy of the initialized
+   * Perple_X state. The workers write their results into a shared memory table
+   * which the calling process then loads into the cache. Points that cannot be
+   * solved (e.g. because they lie outside the problem bounds) are skipped.
+   * Throws an exception if a worker process cannot be forked or fails.
+   *
+   * @param wrapper   The initialized wrapper.
+   * @param points    The points to solve.
+   * @param cache     The cache to fill, e.g. Wrapper::get_cache() or a
+   *                  PersistentCache.
+   * @param n_workers The number of worker processes. If zero the number of
+   *                  hardware threads is used.
+   *
+   * @return The number of results added to the cache.
+   */
+  size_t
+  prewarm(const Wrapper& wrapper,
+          const std::vector<QueryPoint>& points,
+	  CacheBackend& cache,
+	  const unsigned int n_workers=0);
+}
+
+
+#endif
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_QUERYTRACE_H
+#define PERPLEXCPP_QUERYTRACE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/base.h>
+#include <perplexcpp/prewarm.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A minimize call recorded by a TraceRecorder.
+   */
+  struct TraceRecord
+  {
+    /**
+     * The pressure (Pa).
+     */
+    double pressure;
+
+    /**
+     * The temperature (K).
+     */
+    double temperature;
+
+    /**
+     * The bulk composition.
+     */
+    std::vector<double> composition;
+
+    /**
+     * Whether or not the result came from a cache.
+     */
+    bool cache_hit;
+
+    /**
+     * The wall time of the call (s), stored with single precision.
+     */
+    double latency;
+  };
+
+
+
+  /**
+   * A sequence of minimize calls recorded by a TraceRecorder, e.g. from a
+   * production run, that can be replayed to judge cache and scheduling changes
+   * on real traffic (see the perplexcpp-replay-trace tool).
+   */
+  struct QueryTrace
+  {
+    /**
+     * The hash of the problem definition file the trace was recorded for.
+     */
+    std::uint64_t problem_hash;
+
+    /**
+     * The number of composition components.
+     */
+    size_t n_components;
+
+    std::vector<TraceRecord> records;
+
+
+    /**
+     * Read a trace file. Throws an exception if the file is not a trace or was
+     * written by an incompatible version. A truncated final record, as left if
+     * the recording process was killed, is ignored.
+     */
+    static QueryTrace
+    load(const std::string& filename);
+
+
+    /**
+     * @return The number of recorded cache hits.
+     */
+    size_t
+    n_cache_hits() const;
+
+
+    /**
+     * @return The recorded queries as points, e.g. to prewarm a cache with.
+     */
+    std::vector<QueryPoint>
+    to_query_points() const;
+  };
+
+
+
+  /**
+   * Append minimize calls to a compact binary trace file (see
+   * Wrapper::set_trace_recorder()).
+   *
+   * Each record holds the pressure and temperature as doubles, the latency as a
+   * float and a flags byte. The composition is only stored, as doubles, when it
+   * differs from that of the previous record, so a typical record takes 21 bytes.
+   * Records are buffered and so are not all on disk until the recorder is
+   * flushed or destroyed.
+   */
+  class TraceRecorder
+  {
+    public:
+
+      /**
+       * Open the trace file for appending, creating it if it does not exist.
+       * Throws an exception if the file exists and was created for a different
+       * problem.
+       *
+       * @param filename     The trace file.
+       * @param problem_hash The hash of the problem definition file (see
+       *                     Wrapper::problem_file_hash).
+       * @param n_components The number of composition components.
+       */
+      TraceRecorder(const std::string& filename,
+	            const std::uint64_t problem_hash,
+		    const size_t n_components);
+
+
+      /**
+       * Append a call to the trace.
+       */
+      void
+      record(const double pressure,
+	     const double temperature,
+	     const DoubleSpan composition,
+	     const bool cache_hit,
+	     const double latency);
+
+
+      /**
+       * Write any buffered records to the file.
+       */
+      void
+      flush();
+
+
+      /**
+       * @return The number of records appended by this recorder.
+       */
+      inline size_t
+      size() const { return this->n_records; }
+
+
+      TraceRecorder(TraceRecorder const&) = delete;
+      void operator=(TraceRecorder const&) = delete;
+
+    private:
+
+      std::ofstream file;
+
+
+      /**
+       * The number of composition components.
+       */
+      const size_t n_components;
+
+
+      /**
+       * The number of records appended.
+       */
+      size_t n_records;
+
+
+      /**
+       * The composition of the previous record.
+       */
+      std::vector<double> last_composition;
+  };
+}
+
+
+#endif
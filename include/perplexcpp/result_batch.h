@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_RESULTBATCH_H
+#define PERPLEXCPP_RESULTBATCH_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/base.h>
+#include <perplexcpp/prewarm.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * The results of many minimizations stored column by column.
+   *
+   * Each scalar property (pressure, temperature, density, ...) is stored as one
+   * contiguous array with an element per point. The bulk composition and the
+   * phase properties are stored as matrices of such columns: composition(c) is
+   * the column of component c and phase_weight_frac(p), phase_density(p) etc.
+   * are the columns of phase p (in Wrapper::phase_names order), so reductions
+   * over the points, such as averaging the melt fraction, are simple loops over
+   * contiguous memory.
+   *
+   * The storage is a single shared memory mapping so that forked worker
+   * processes (see minimize_batch) can write their results in place. A batch can
+   * be exported to, and loaded from, a table file (see TableWriter).
+   */
+  class ResultBatch
+  {
+    public:
+
+      /**
+       * Construct an empty batch. Every point is initially marked as unsolved.
+       *
+       * @param n_points        The number of points.
+       * @param component_names The names of the composition components.
+       * @param phase_names     The names of the phases.
+       * @param problem_hash    The hash of the problem definition file.
+       */
+      ResultBatch(const size_t n_points,
+		  const std::vector<std::string>& component_names,
+		  const std::vector<PhaseName>& phase_names,
+		  const std::uint64_t problem_hash);
+
+
+      /**
+       * Construct an empty batch for the problem solved by a wrapper.
+       */
+      ResultBatch(const Wrapper& wrapper, const size_t n_points);
+
+
+      ResultBatch(ResultBatch&& other);
+
+
+      ~ResultBatch();
+
+
+      /**
+       * Load a batch from a file written by save(). Throws an exception if the
+       * file does not hold a batch.
+       */
+      static ResultBatch
+      load(const std::string& filename);
+
+
+      /**
+       * Save the batch to a table file of kind "ResultBatch". The file has a
+       * single axis, "point", and an array for each column; the matrices are
+       * stored as single arrays with the columns one after the other.
+       */
+      void
+      save(const std::string& filename) const;
+
+
+      /**
+       * Store a result at a point.
+       */
+      void
+      set(const size_t idx, const MinimizeResult& result);
+
+
+      /**
+       * Copy the result at a point into a MinimizeResult, reusing its storage.
+       * Every member of the result is overwritten, so nothing is left from the
+       * result it held before. Throws an exception if the point has not been
+       * solved.
+       */
+      void
+      get(const size_t idx, MinimizeResult& out) const;
+
+
+      /**
+       * @return The number of points.
+       */
+      inline size_t
+      size() const { return this->n_points; }
+
+
+      inline size_t
+      n_components() const { return this->component_names.size(); }
+
+
+      inline size_t
+      n_phases() const { return this->phase_names.size(); }
+
+
+      inline const std::vector<std::string>&
+      get_component_names() const { return this->component_names; }
+
+
+      inline const std::vector<PhaseName>&
+      get_phase_names() const { return this->phase_names; }
+
+
+      inline std::uint64_t
+      get_problem_hash() const { return this->problem_hash; }
+
+
+      /**
+       * @return For each point, 1 if it has been solved and 0 if not. The
+       *         properties of unsolved points are zero.
+       */
+      inline const std::uint8_t*
+      solved() const { return this->flags; }
+
+
+      /**
+       * @return The number of solved points.
+       */
+      size_t
+      n_solved() const;
+
+
+      inline const double*
+      pressure() const { return this->column(0); }
+
+
+      inline const double*
+      temperature() const { return this->column(1); }
+
+
+      inline const double*
+      density() const { return this->column(2); }
+
+
+      inline const double*
+      expansivity() const { return this->column(3); }
+
+
+      inline const double*
+      molar_entropy() const { return this->column(4); }
+
+
+      inline const double*
+      molar_heat_capacity() const { return this->column(5); }
+
+
+      /**
+       * @return The amount of composition component c at each point.
+       */
+      inline const double*
+      composition(const size_t c) const { return this->column(n_scalars + c); }
+
+
+      inline const double*
+      phase_weight_frac(const size_t p) const { return this->phase_column(0, p); }
+
+
+      inline const double*
+      phase_volume_frac(const size_t p) const { return this->phase_column(1, p); }
+
+
+      inline const double*
+      phase_molar_frac(const size_t p) const { return this->phase_column(2, p); }
+
+
+      inline const double*
+      phase_n_moles(const size_t p) const { return this->phase_column(3, p); }
+
+
+      inline const double*
+      phase_density(const size_t p) const { return this->phase_column(4, p); }
+
+
+      /**
+       * @return Component c of the composition ratio of phase p at each point.
+       */
+      inline const double*
+      phase_composition_ratio(const size_t p, const size_t c) const
+      { return this->phase_column(n_phase_scalars + c, p); }
+
+
+      ResultBatch(ResultBatch const&) = delete;
+      void operator=(ResultBatch const&) = delete;
+
+    private:
+
+      /**
+       * The number of system scalars stored (P, T, density, expansivity, molar
+       * entropy and molar heat capacity).
+       */
+      static const size_t n_scalars = 6;
+
+
+      /**
+       * The number of scalars stored per phase (weight, volume and molar fractions,
+       * amount and density).
+       */
+      static const size_t n_phase_scalars = 5;
+
+
+      size_t n_points;
+
+      std::vector<std::string> component_names;
+
+      std::vector<PhaseName> phase_names;
+
+      std::uint64_t problem_hash;
+
+
+      /**
+       * The mapping holding the columns followed by the solved flags.
+       */
+      void* memory;
+
+      size_t length;
+
+
+      /**
+       * The columns. Column k of point i is stored at index k * n_points + i.
+       * The system scalars come first, then the bulk composition, then for each
+       * phase property (the phase scalars followed by the composition ratio) a
+       * column per phase.
+       */
+      double* values;
+
+
+      std::uint8_t* flags;
+
+
+      /**
+       * @return The number of columns.
+       */
+      inline size_t
+      n_columns() const 
+      {
+	return n_scalars + this->n_components() + 
+	       this->n_phases() * (n_phase_scalars + this->n_components());
+      }
+
+
+      inline double*
+      column(const size_t k) const { return this->values + k * this->n_points; }
+
+
+      /**
+       * @return The column of phase property k (see above) of phase p.
+       */
+      inline double*
+      phase_column(const size_t k, const size_t p) const
+      { 
+	return this->column(n_scalars + this->n_components() + k * this->n_phases() + p); 
+      }
+  };
+
+
+
+  /**
+   * Solve a set of query points in parallel, writing the results directly into
+   * a batch. Like prewarm(), the points are divided between forked worker
+   * processes. Points that cannot be solved are marked as unsolved.
+   *
+   * @param wrapper   The initialized wrapper.
+   * @param points    The points to solve.
+   * @param n_workers The number of worker processes. If zero the number of
+   *                  hardware threads is used.
+   *
+   * @return The batch, with point i holding the result of points[i].
+   */
+  ResultBatch
+  minimize_batch(const Wrapper& wrapper,
+		 const std::vector<QueryPoint>& points,
+		 const unsigned int n_workers=0);
+}
+
+
+#endif
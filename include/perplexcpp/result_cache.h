@@ -22,19 +22,45 @@
 #define PERPLEXCPP_RESULTCACHE_H
 
 
+#include <limits>
 #include <list>
+#include <memory>
 #include <vector>
 
 #include <perplexcpp/base.h>
+#include <perplexcpp/cache_backend.h>
+#include <perplexcpp/result_view.h>
 
 
 namespace perplexcpp
 {
+  /**
+   * The strategies used to choose which result to evict from a ResultCache.
+   */
+  enum class EvictionPolicy
+  {
+    /**
+     * Evict the least recently used result.
+     */
+    lru,
+
+    /**
+     * GreedyDual-Size: evict the result with the lowest priority, where the
+     * priority of a result is its solve time per byte plus an inflation value
+     * that ages results that are not reused. Expensive results are therefore
+     * kept for longer than cheap ones.
+     */
+    greedy_dual_size
+  };
+
+
+
   /**
    * Class that stores the results of minimisations so that they can be referred
-   * to later.
+   * to later. The results are stored compactly as ResultViews that share a single
+   * table of phase names.
    */
-  class ResultCache
+  class ResultCache : public CacheBackend
   {
     public:
 
@@ -57,45 +83,295 @@ namespace perplexcpp
       get(const double pressure,
 	  const double temperature,
 	  const std::vector<double> &composition,
-	  MinimizeResult &out);
+	  MinimizeResult &out) override;
+
+
+      /**
+       * Try to find an item in the cache. Unlike get() this does not copy the
+       * result and performs no heap allocations.
+       *
+       * @return A pointer to the stored result or nullptr if it was not found. The
+       *         pointer is valid until the result is evicted.
+       *
+       * @remark If compositions are normalized the stored result may be for a
+       *         different total amount than requested. Use get() to have the
+       *         extensive properties rescaled.
+       */
+      const ResultView*
+      lookup(const double pressure,
+	     const double temperature,
+	     const std::vector<double> &composition);
 
 
       /**
        * Add an item to the cache.
        */
       void
-      put(const MinimizeResult& result);
+      put(const MinimizeResult& result) override;
+
+
+      /**
+       * Add an item to the cache.
+       *
+       * @param result     The result.
+       * @param solve_time The time taken to compute the result (in seconds). This
+       *                   is used by cost-aware eviction and to estimate the time
+       *                   saved by the cache.
+       */
+      void
+      put(const MinimizeResult& result, const double solve_time);
+
+
+      /**
+       * Set how newly added results are stored. The compact encodings quantize the
+       * phase properties and omit absent phases, greatly reducing the memory used
+       * by each result. They require the phase name table to be indexed by phase
+       * id (see set_phase_names()).
+       */
+      inline void
+      set_encoding(const ResultEncoding encoding) { this->encoding = encoding; }
+
+
+      inline ResultEncoding
+      get_encoding() const { return this->encoding; }
+
+
+      /**
+       * Replace the table of phase names used by newly added results. Passing
+       * Wrapper::phase_names makes the table indices the phase ids.
+       */
+      void
+      set_phase_names(const std::vector<PhaseName>& names);
+
+
+      /**
+       * Compare compositions by their proportions rather than their absolute
+       * amounts. Perple_X normalizes the bulk composition before minimizing so
+       * compositions that differ only by a scale factor have the same fractions,
+       * densities and phase compositions. On a hit the extensive properties
+       * (the phase amounts, molar entropy and molar heat capacity) and the
+       * composition are rescaled to the requested total.
+       *
+       * The total is the sum of the composition, which is the total number of
+       * moles or, if the problem specifies the composition by weight, the total
+       * mass. In either case the rescaling is the same.
+       */
+      inline void
+      set_normalize_composition(const bool normalize) 
+      { this->normalize_composition = normalize; }
+
+
+      inline bool
+      get_normalize_composition() const { return this->normalize_composition; }
+
+
+      /**
+       * Accept near matches based on the predicted error rather than the distance
+       * alone.
+       *
+       * Each stored result records how quickly the properties change around it,
+       * measured against the other stored results lying within twice the cache
+       * tolerance: the sensitivity is the largest relative change in density or
+       * absolute change in a phase molar fraction per unit relative distance. If a
+       * neighbour has a different assemblage then a phase boundary lies between
+       * them and the result is only trusted up to half the distance to it.
+       *
+       * A near match is then accepted only if it lies within the cache tolerance,
+       * within its trusted radius and the predicted error (the sensitivity times
+       * the distance) is no more than the error tolerance. A result whose
+       * sensitivity has not yet been measured only matches exactly.
+       *
+       * @param error_tolerance The error tolerance. Zero disables the adaptive mode.
+       *
+       * @remark The distance between two points is the largest relative
+       *         difference of the pressure, temperature and composition.
+       */
+      void
+      set_error_tolerance(const double error_tolerance);
+
+
+      inline double
+      get_error_tolerance() const { return this->error_tolerance; }
+
+
+      /**
+       * Set the policy used to choose which result to evict.
+       */
+      void
+      set_eviction_policy(const EvictionPolicy policy);
+
+
+      inline EvictionPolicy
+      get_eviction_policy() const { return this->policy; }
+
+
+      /**
+       * Limit the memory used by the stored results. Results are evicted until a
+       * new result fits in the budget, as well as when the capacity is reached.
+       *
+       * @param max_bytes The budget in bytes. Zero means unlimited.
+       */
+      void
+      set_max_bytes(const size_t max_bytes);
+
+
+      inline size_t
+      get_max_bytes() const { return this->max_bytes; }
+
+
+      /**
+       * @return The approximate number of bytes used by the stored results.
+       */
+      inline size_t
+      get_n_bytes() const { return this->n_bytes; }
 
 
       /**
        * @return The size of the cache.
        */
       size_t
-      size() const;
+      size() const override;
 
 
       /**
        * Reset the hit and miss counters to zero.
        */
       void
-      reset_counters();
+      reset_counters() override;
 
 
       inline unsigned int
-      get_n_hits() const { return this->n_hits; }
+      get_n_hits() const override { return this->n_hits; }
 
 
       inline unsigned int
-      get_n_misses() const { return this->n_misses; }
+      get_n_misses() const override { return this->n_misses; }
+
+
+      /**
+       * @return An estimate of the solver time saved (in seconds) since the counters
+       *         were last reset, being the sum of the solve times of the hits.
+       */
+      inline double
+      get_solve_time_saved() const { return this->solve_time_saved; }
+
+
+      /**
+       * @return The total solve time (in seconds) of the results added since the
+       *         counters were last reset.
+       */
+      inline double
+      get_solve_time_spent() const { return this->solve_time_spent; }
 
     private:
 
+      /**
+       * A stored result along with the information needed for eviction.
+       */
+      struct Item
+      {
+	Item(const MinimizeResult& result,
+	     const std::shared_ptr<PhaseNameTable>& names,
+	     const ResultEncoding encoding,
+	     const double solve_time);
+
+	ResultView view;
+
+	/**
+	 * The sum of the composition.
+	 */
+	double composition_total;
+
+	/**
+	 * The time taken to compute the result (in seconds).
+	 */
+	double solve_time;
+
+	/**
+	 * The approximate number of bytes used by the item.
+	 */
+	size_t n_bytes;
+
+	/**
+	 * The GreedyDual-Size priority.
+	 */
+	double priority = 0.0;
+
+	/**
+	 * The largest change in the properties per unit relative distance measured
+	 * between this and the neighbouring items. Negative if it is unknown.
+	 */
+	double sensitivity = -1.0;
+
+	/**
+	 * The relative distance within which the assemblage is expected to be
+	 * the same.
+	 */
+	double trust_radius = std::numeric_limits<double>::infinity();
+      };
+
+
       /**
        * The cache tolerance.
        */
       const double rtol;
 
 
+      /**
+       * The encoding of newly added results.
+       */
+      ResultEncoding encoding = ResultEncoding::float64;
+
+
+      /**
+       * Whether or not compositions are compared by proportion.
+       */
+      bool normalize_composition = false;
+
+
+      /**
+       * The tolerance on the predicted error (zero if not used).
+       */
+      double error_tolerance = 0.0;
+
+
+      /**
+       * The eviction policy.
+       */
+      EvictionPolicy policy = EvictionPolicy::lru;
+
+
+      /**
+       * The memory budget in bytes (zero if unlimited).
+       */
+      size_t max_bytes = 0;
+
+
+      /**
+       * The number of bytes used by the items.
+       */
+      size_t n_bytes = 0;
+
+
+      /**
+       * The GreedyDual-Size inflation value. This is the priority of the most
+       * recently evicted item.
+       */
+      double inflation = 0.0;
+
+
+      /**
+       * The solve time saved by hits.
+       */
+      double solve_time_saved = 0.0;
+
+
+      /**
+       * The solve time of the items added.
+       */
+      double solve_time_spent = 0.0;
+
+
       /**
        * The number of hits.
        */
@@ -108,11 +384,73 @@ namespace perplexcpp
       unsigned int n_misses = 0;
 
 
+      /**
+       * The phase names shared by all of the items.
+       */
+      std::shared_ptr<PhaseNameTable> phase_names;
+
+
       /**
        * List of the items stored in the cache. A linked list rather than vector is
        * used for efficient reordering.
        */
-      std::list<MinimizeResult> items;
+      std::list<Item> items;
+
+
+      /**
+       * Find a matching item, updating the counters and moving it to the front.
+       *
+       * @return The item or nullptr if it was not found.
+       */
+      Item*
+      find(const double pressure,
+	   const double temperature,
+	   const std::vector<double> &composition);
+
+
+      /**
+       * Returns true if the item may be returned for the given key in the adaptive
+       * mode.
+       */
+      bool
+      is_accurate_enough(const Item& item,
+			 const double pressure,
+			 const double temperature,
+			 const std::vector<double>& composition,
+			 const double composition_total) const;
+
+
+      /**
+       * Measure the sensitivity of a new item and update those of its neighbours.
+       */
+      void
+      measure_sensitivities(Item& item);
+
+
+      /**
+       * @return The largest relative difference between the key and the item.
+       */
+      double
+      compute_distance(const Item& item,
+		       const double pressure,
+		       const double temperature,
+		       const double* composition,
+		       const size_t n_components,
+		       const double composition_total) const;
+
+
+      /**
+       * Remove an item according to the eviction policy.
+       */
+      void
+      evict();
+
+
+      /**
+       * @return The GreedyDual-Size priority of an item.
+       */
+      double
+      compute_priority(const Item& item) const;
 
 
       /**
@@ -123,11 +461,14 @@ namespace perplexcpp
 
 
       /**
-       * Returns true if each value in the two vectors lie within the prescribed tolerance.
+       * Returns true if each value in the vector and array lie within the prescribed
+       * tolerance after dividing them by the given totals.
        */
       bool 
-      is_near_enough(const std::vector<double> xs, 
-                     const std::vector<double> ys) const;
+      is_near_enough(const std::vector<double>& xs, 
+                     const double* ys,
+		     const double x_total=1.0,
+		     const double y_total=1.0) const;
   };
 }
 
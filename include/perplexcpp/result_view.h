@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_RESULTVIEW_H
+#define PERPLEXCPP_RESULTVIEW_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <perplexcpp/base.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A table of interned phase names. Results stored in a compact form refer to
+   * their phase names by an index into this table so that the strings are only
+   * stored once.
+   */
+  class PhaseNameTable
+  {
+    public:
+
+      /**
+       * Construct an empty table.
+       */
+      PhaseNameTable() = default;
+
+
+      /**
+       * Construct a table holding the given names. If the names are unique the
+       * index of each name is its position, so if the names are
+       * Wrapper::phase_names then the indices are the phase ids.
+       */
+      explicit PhaseNameTable(const std::vector<PhaseName>& names);
+
+
+      /**
+       * @return The index of the name, adding it to the table if necessary.
+       */
+      size_t
+      intern(const PhaseName& name);
+
+
+      /**
+       * @return The name with the given index.
+       */
+      inline const PhaseName&
+      get(const size_t idx) const { return this->names[idx]; }
+
+
+      /**
+       * @return The number of names stored.
+       */
+      inline size_t
+      size() const { return this->names.size(); }
+
+    private:
+
+      /**
+       * The names.
+       */
+      std::vector<PhaseName> names;
+
+
+      /**
+       * Map from the standard name to the index.
+       */
+      std::unordered_map<std::string,size_t> indices;
+  };
+
+
+
+  /**
+   * The ways in which the phase properties of a ResultView may be stored. The
+   * pressure, temperature, composition and system properties are always stored
+   * exactly.
+   */
+  enum class ResultEncoding
+  {
+    /**
+     * Store everything as doubles.
+     */
+    float64,
+
+    /**
+     * Store only the phases that are present, as floats. The relative error of
+     * each value is at most 6e-8.
+     */
+    float32,
+
+    /**
+     * Store only the phases that are present. The phase fractions are stored as
+     * 16-bit fixed point numbers with an absolute error of at most 7.7e-6, with
+     * fractions that are not zero kept at least as large as 1.5e-5. The
+     * composition ratios of each phase are stored as 16-bit fixed point numbers
+     * spanning their range, giving an absolute error of at most 7.7e-6 times the
+     * range. The amounts and densities are stored as floats.
+     */
+    fixed16
+  };
+
+
+
+  /**
+   * A compact, read-only representation of a MinimizeResult.
+   *
+   * All of the numbers are stored contiguously and the phase names are referenced
+   * by an index into a shared PhaseNameTable. Reading a stored result therefore
+   * requires no heap allocations, and copying it into a MinimizeResult only
+   * allocates if the destination is too small.
+   *
+   * With the float32 and fixed16 encodings the phase properties are quantized and
+   * absent phases (those whose properties are all zero) are not stored at all.
+   * These encodings require the phases of the result to be listed in id order,
+   * with ids matching the indices of their names in the name table, as is the
+   * case for results from Wrapper::minimize when the table is constructed from
+   * Wrapper::phase_names.
+   */
+  class ResultView
+  {
+    public:
+
+      /**
+       * Construct the view.
+       *
+       * @param result   The result to store.
+       * @param names    The table used to intern the phase names.
+       * @param encoding How to store the phase properties.
+       *
+       * @remark Every phase must have the same number of composition components as
+       *         the bulk composition (or none).
+       */
+      ResultView(const MinimizeResult& result,
+	         const std::shared_ptr<PhaseNameTable>& names,
+		 const ResultEncoding encoding=ResultEncoding::float64);
+
+
+      inline double
+      pressure() const { return this->values[0]; }
+
+
+      inline double
+      temperature() const { return this->values[1]; }
+
+
+      inline double
+      density() const { return this->values[2]; }
+
+
+      inline double
+      expansivity() const { return this->values[3]; }
+
+
+      inline double
+      molar_entropy() const { return this->values[4]; }
+
+
+      inline double
+      molar_heat_capacity() const { return this->values[5]; }
+
+
+      /**
+       * @return The number of composition components.
+       */
+      inline size_t
+      n_components() const { return this->n_comps; }
+
+
+      /**
+       * @return The bulk composition (n_components() values).
+       */
+      inline const double*
+      composition() const { return this->values.data() + n_scalars; }
+
+
+      /**
+       * @return The number of phases, including absent ones.
+       */
+      inline size_t
+      n_phases() const 
+      { 
+	return this->encoding == ResultEncoding::float64 ? 
+	  this->phase_ids.size() : this->slots.size(); 
+      }
+
+
+      inline size_t
+      phase_id(const size_t p) const 
+      { 
+	return this->encoding == ResultEncoding::float64 ? this->phase_ids[p] : p; 
+      }
+
+
+      inline const PhaseName&
+      phase_name(const size_t p) const 
+      { 
+	return this->names->get(this->encoding == ResultEncoding::float64 ? 
+				this->name_ids[p] : p); 
+      }
+
+
+      inline double
+      phase_weight_frac(const size_t p) const { return this->phase_value(p, 0); }
+
+
+      inline double
+      phase_volume_frac(const size_t p) const { return this->phase_value(p, 1); }
+
+
+      inline double
+      phase_molar_frac(const size_t p) const { return this->phase_value(p, 2); }
+
+
+      inline double
+      phase_n_moles(const size_t p) const { return this->phase_value(p, 3); }
+
+
+      inline double
+      phase_density(const size_t p) const { return this->phase_value(p, 4); }
+
+
+      /**
+       * @return Component c of the composition ratio of phase p.
+       */
+      inline double
+      phase_composition_ratio(const size_t p, const size_t c) const
+      { return this->phase_value(p, n_phase_scalars + c); }
+
+
+      /**
+       * @return The number of components in each phase composition ratio.
+       */
+      inline size_t
+      n_phase_components() const { return this->n_phase_comps; }
+
+
+      /**
+       * @return The encoding of the phase properties.
+       */
+      inline ResultEncoding
+      get_encoding() const { return this->encoding; }
+
+
+      /**
+       * Copy the result into a MinimizeResult, reusing its existing storage.
+       */
+      void
+      copy_to(MinimizeResult& out) const;
+
+
+      /**
+       * @return The approximate number of bytes used by the view.
+       */
+      size_t
+      memory_footprint() const;
+
+    private:
+
+      /**
+       * The number of system scalars stored (P, T, density, expansivity, molar
+       * entropy and molar heat capacity).
+       */
+      static const size_t n_scalars = 6;
+
+
+      /**
+       * The number of scalars stored per phase (weight, volume and molar fractions,
+       * amount and density).
+       */
+      static const size_t n_phase_scalars = 5;
+
+
+      /**
+       * The number of phase fractions (weight, volume and molar).
+       */
+      static const size_t n_phase_fracs = 3;
+
+
+      /**
+       * The encoding of the phase properties.
+       */
+      ResultEncoding encoding;
+
+
+      /**
+       * The numbers making up the result. These are, in order, the system
+       * scalars, the bulk composition and then, with the float64 encoding, for
+       * each phase the phase scalars and composition ratio.
+       */
+      std::vector<double> values;
+
+
+      /**
+       * The phase ids (float64 encoding only).
+       */
+      std::vector<size_t> phase_ids;
+
+
+      /**
+       * The indices of the phase names in the name table (float64 encoding only).
+       */
+      std::vector<size_t> name_ids;
+
+
+      /**
+       * For each phase, one plus the index of its stored properties or zero if it
+       * is absent (compact encodings only).
+       */
+      std::vector<std::uint16_t> slots;
+
+
+      /**
+       * The phase properties stored as floats. With the float32 encoding these are
+       * the phase scalars and composition ratio of each stored phase. With the
+       * fixed16 encoding these are the amount, density, composition ratio offset
+       * and composition ratio scale of each stored phase.
+       */
+      std::vector<float> floats;
+
+
+      /**
+       * The phase fractions and composition ratio of each stored phase as fixed
+       * point numbers (fixed16 encoding only).
+       */
+      std::vector<std::uint16_t> fixed;
+
+
+      /**
+       * The phase name table.
+       */
+      std::shared_ptr<PhaseNameTable> names;
+
+
+      /**
+       * The number of composition components.
+       */
+      size_t n_comps;
+
+
+      /**
+       * The number of components in each phase composition ratio.
+       */
+      size_t n_phase_comps;
+
+
+      /**
+       * @return The start of the values for phase p (float64 encoding only).
+       */
+      inline const double*
+      phase_values(const size_t p) const
+      {
+	return this->values.data() + n_scalars + this->n_comps +
+	       p * (n_phase_scalars + this->n_phase_comps);
+      }
+
+
+      /**
+       * @return Value i of phase p where the phase scalars are followed by the
+       *         composition ratio.
+       */
+      inline double
+      phase_value(const size_t p, const size_t i) const
+      {
+	if (this->encoding == ResultEncoding::float64)
+	  return this->phase_values(p)[i];
+	else if (this->slots[p] == 0)
+	  return 0.0;
+	else
+	  return this->decode(this->slots[p]-1, i);
+      }
+
+
+      /**
+       * @return Value i of the phase stored in a slot (compact encodings only).
+       */
+      double
+      decode(const size_t slot, const size_t i) const;
+  };
+}
+
+
+#endif
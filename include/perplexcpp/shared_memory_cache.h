@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_SHAREDMEMORYCACHE_H
+#define PERPLEXCPP_SHAREDMEMORYCACHE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/base.h>
+#include <perplexcpp/mapped_cache.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A result cache stored in POSIX shared memory so that it is visible to every
+   * process on a node (e.g. all of the MPI ranks).
+   *
+   * Insertion and lookup are lock-free so every process can both consult the
+   * cache and add its own results, meaning that a point solved by one rank is
+   * immediately available to the others. It uses the same fixed-size hash table
+   * as PersistentCache: only exact matches are returned and once the table is
+   * full new results are discarded. The shared memory object outlives the
+   * processes using it until it is removed with SharedMemoryCache::unlink().
+   *
+   * To use it in place of the private cache in Wrapper initialize the wrapper
+   * with a cache capacity of zero and pass it to Wrapper::set_cache_backend().
+   */
+  class SharedMemoryCache : public MappedCache
+  {
+    public:
+
+      /**
+       * Open the shared memory object, creating it if it does not exist. Throws an
+       * exception if it was created for a different problem.
+       *
+       * @param name         The name of the shared memory object. It must start
+       *                     with a '/' (see make_name()).
+       * @param problem_hash The hash of the problem definition file (see
+       *                     Wrapper::problem_file_hash).
+       * @param n_components The number of composition components.
+       * @param phase_names  The phase names (see Wrapper::phase_names).
+       * @param n_slots      The max number of results that may be saved. This is
+       *                     ignored if the object already exists.
+       */
+      SharedMemoryCache(const std::string& name,
+	                const std::uint64_t problem_hash,
+			const size_t n_components,
+			const std::vector<PhaseName>& phase_names,
+			const size_t n_slots=65536);
+
+
+      /**
+       * @param problem_hash The hash of the problem definition file.
+       * @return             A shared memory object name unique to the problem, so
+       *                     that every process solving it shares the same cache.
+       */
+      static std::string
+      make_name(const std::uint64_t problem_hash);
+
+
+      /**
+       * Remove the shared memory object. Processes that have already opened it
+       * may continue to use it.
+       */
+      static void
+      unlink(const std::string& name);
+  };
+}
+
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_SOLVERSTATS_H
+#define PERPLEXCPP_SOLVERSTATS_H
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <perplexcpp/base.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * A histogram of latencies with logarithmically spaced buckets.
+   *
+   * Latencies are recorded in whole nanoseconds. Each power of two is split
+   * into 2^sub_bucket_bits linear sub-buckets so a percentile is accurate to
+   * within 1/2^sub_bucket_bits (12.5%) of its value. Recording a value does not
+   * allocate and the histogram has a fixed size whatever the range of the
+   * values.
+   */
+  class LatencyHistogram
+  {
+    public:
+
+      /**
+       * The number of bits of each value used to select a sub-bucket.
+       */
+      static const size_t sub_bucket_bits = 3;
+
+
+      /**
+       * The number of buckets needed to cover every 64-bit value.
+       */
+      static const size_t n_buckets = (64 - sub_bucket_bits + 1) << sub_bucket_bits;
+
+
+      /**
+       * Construct an empty histogram.
+       */
+      LatencyHistogram();
+
+
+      /**
+       * Record a latency.
+       *
+       * @param seconds The latency (s).
+       */
+      void
+      record(const double seconds);
+
+
+      /**
+       * Add the values of another histogram to this one.
+       */
+      void
+      merge(const LatencyHistogram& other);
+
+
+      /**
+       * Remove all of the values.
+       */
+      void
+      reset();
+
+
+      /**
+       * @return The number of values recorded.
+       */
+      inline std::uint64_t
+      count() const { return this->n_values; }
+
+
+      /**
+       * @return The mean latency (s), or zero if nothing has been recorded.
+       */
+      double
+      mean() const;
+
+
+      /**
+       * @return The largest latency recorded (s).
+       */
+      inline double
+      max() const { return this->max_ns * 1e-9; }
+
+
+      /**
+       * @param q The quantile, between 0 and 1 (e.g. 0.99 for the p99).
+       *
+       * @return The upper bound of the bucket holding the quantile (s), capped
+       *         at the largest latency recorded, or zero if nothing has been
+       *         recorded.
+       */
+      double
+      percentile(const double q) const;
+
+    private:
+
+      /**
+       * The number of values in each bucket.
+       */
+      std::array<std::uint64_t,n_buckets> counts;
+
+
+      /**
+       * The number of values recorded.
+       */
+      std::uint64_t n_values;
+
+
+      /**
+       * The sum of the values recorded (ns).
+       */
+      double sum_ns;
+
+
+      /**
+       * The largest value recorded (ns).
+       */
+      std::uint64_t max_ns;
+
+
+      /**
+       * @return The bucket holding a value (ns).
+       */
+      static size_t
+      bucket(const std::uint64_t ns);
+
+
+      /**
+       * @return The largest value (ns) held by a bucket.
+       */
+      static std::uint64_t
+      bucket_upper_bound(const size_t idx);
+  };
+
+
+
+  /**
+   * Statistics aggregated over many minimizations.
+   */
+  struct SolverStats
+  {
+    /**
+     * The number of minimizations, including those taken from a cache.
+     */
+    size_t n_calls = 0;
+
+    /**
+     * The number of minimizations taken from a cache.
+     */
+    size_t n_cache_hits = 0;
+
+    /**
+     * The work done by the solver, summed over every minimization that was
+     * solved.
+     */
+    size_t lp_iterations = 0;
+    size_t reopt_iterations = 0;
+    size_t n_static_compounds = 0;
+    size_t n_dynamic_compounds = 0;
+
+    /**
+     * The latencies of every minimization, of those taken from a cache and of
+     * those that were solved.
+     */
+    LatencyHistogram latency;
+    LatencyHistogram hit_latency;
+    LatencyHistogram solve_latency;
+
+    /**
+     * The hardware counts of the minimizations taken from a cache and of those
+     * that were solved (see Wrapper::set_hardware_counting).
+     */
+    HardwareCounters hit_hardware = HardwareCounters();
+    HardwareCounters solve_hardware = HardwareCounters();
+
+
+    /**
+     * Record a minimization.
+     *
+     * @param counters The counters of its result.
+     * @param seconds  Its latency (s).
+     */
+    void
+    record(const SolveCounters& counters, const double seconds);
+
+
+    /**
+     * Add the statistics of other minimizations.
+     */
+    SolverStats&
+    operator+=(const SolverStats& other);
+
+
+    /**
+     * @return The number of minimizations that were solved.
+     */
+    inline size_t
+    n_solves() const { return this->n_calls - this->n_cache_hits; }
+
+
+    /**
+     * @return The statistics as human-readable text.
+     */
+    std::string
+    to_text() const;
+
+
+    /**
+     * @return The statistics as a JSON object.
+     */
+    std::string
+    to_json() const;
+  };
+}
+
+
+#endif
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_TABLEFILE_H
+#define PERPLEXCPP_TABLEFILE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace perplexcpp
+{
+  /**
+   * The types of the arrays stored in a table file.
+   */
+  enum class TableDataType : std::uint32_t
+  {
+    float64 = 1,
+    uint32 = 2,
+
+    /**
+     * Characters, used to store lists of names as null-terminated strings.
+     */
+    text = 3
+  };
+
+
+
+  /**
+   * A regularly spaced axis of a table.
+   */
+  struct TableAxis
+  {
+    std::string name;
+
+    std::string units;
+
+    /**
+     * The number of points along the axis.
+     */
+    size_t size;
+
+    double min;
+
+    double max;
+  };
+
+
+
+  /**
+   * An array stored in a table file.
+   */
+  struct TableArray
+  {
+    std::string name;
+
+    std::string units;
+
+    TableDataType type;
+
+    /**
+     * The number of elements.
+     */
+    size_t size;
+
+    /**
+     * The elements.
+     */
+    const void* data;
+  };
+
+
+
+  /**
+   * Write a table file.
+   *
+   * A table file is a versioned binary format for tables of properties computed
+   * with Perple_X. It consists of a header identifying the kind of table and the
+   * hash of the problem definition file, descriptions of the axes and arrays
+   * (each with a name and units), and then the arrays themselves, each aligned
+   * to 64 bytes. Values are stored in the native byte order. The file can be
+   * mapped into memory by TableReader without being parsed or copied.
+   */
+  class TableWriter
+  {
+    public:
+
+      /**
+       * Constructor.
+       *
+       * @param kind         The kind of table (e.g. "ThermoTable"), at most 31
+       *                     characters.
+       * @param problem_hash The hash of the problem definition file (see
+       *                     Wrapper::problem_file_hash).
+       */
+      TableWriter(const std::string& kind, const std::uint64_t problem_hash);
+
+
+      /**
+       * Add an axis.
+       */
+      void
+      add_axis(const std::string& name,
+	       const std::string& units,
+	       const size_t size,
+	       const double min,
+	       const double max);
+
+
+      /**
+       * Add an array. The data is not copied and must remain valid until the file
+       * is written.
+       */
+      void
+      add_array(const std::string& name,
+		const std::string& units,
+		const double* data,
+		const size_t size);
+
+
+      /**
+       * Add an array. The data is not copied and must remain valid until the file
+       * is written.
+       */
+      void
+      add_array(const std::string& name,
+		const std::string& units,
+		const std::uint32_t* data,
+		const size_t size);
+
+
+      /**
+       * Add a list of strings, stored as a text array of null-terminated strings.
+       * The strings are copied.
+       */
+      void
+      add_strings(const std::string& name, const std::vector<std::string>& strings);
+
+
+      /**
+       * Write the file. It is written to a temporary file that is then renamed so
+       * that readers never see a partially written table.
+       */
+      void
+      write(const std::string& filename) const;
+
+    private:
+
+      const std::string kind;
+
+      const std::uint64_t problem_hash;
+
+      std::vector<TableAxis> axes;
+
+      std::vector<TableArray> arrays;
+
+
+      /**
+       * The contents of the text arrays, kept so that they outlive the arrays.
+       */
+      std::vector<std::unique_ptr<std::string>> texts;
+
+
+      void
+      add_array(const std::string& name,
+		const std::string& units,
+		const TableDataType type,
+		const void* data,
+		const size_t size);
+  };
+
+
+
+  /**
+   * Read a table file written by TableWriter.
+   *
+   * The file is mapped into memory read-only so opening it is fast regardless of
+   * its size, the arrays are read directly from the mapping, and processes
+   * reading the same file share a single copy in the page cache.
+   */
+  class TableReader
+  {
+    public:
+
+      /**
+       * Open a table file. Throws an exception if the file is not a table of the
+       * given kind or was written with an unsupported version of the format.
+       *
+       * @param filename The file.
+       * @param kind     The expected kind of table.
+       */
+      TableReader(const std::string& filename, const std::string& kind);
+
+
+      ~TableReader();
+
+
+      /**
+       * The version of the format.
+       */
+      static const std::uint32_t version = 1;
+
+
+      /**
+       * @return The hash of the problem definition file.
+       */
+      inline std::uint64_t
+      get_problem_hash() const { return this->problem_hash; }
+
+
+      /**
+       * @return The axes.
+       */
+      inline const std::vector<TableAxis>&
+      get_axes() const { return this->axes; }
+
+
+      /**
+       * @return The axis with the given name. Throws an exception if it is missing.
+       */
+      const TableAxis&
+      get_axis(const std::string& name) const;
+
+
+      /**
+       * @return The arrays.
+       */
+      inline const std::vector<TableArray>&
+      get_arrays() const { return this->arrays; }
+
+
+      /**
+       * @return The array with the given name. Throws an exception if it is missing.
+       */
+      const TableArray&
+      get_array(const std::string& name) const;
+
+
+      /**
+       * @return The array with the given name. Throws an exception if it is missing
+       *         or does not have the given type and size.
+       */
+      const TableArray&
+      get_array(const std::string& name,
+		const TableDataType type,
+		const size_t size) const;
+
+
+      /**
+       * @return The elements of a float64 array of the given size.
+       */
+      inline const double*
+      get_doubles(const std::string& name, const size_t size) const
+      {
+	return static_cast<const double*>(
+	  this->get_array(name, TableDataType::float64, size).data);
+      }
+
+
+      /**
+       * @return The elements of a uint32 array of the given size.
+       */
+      inline const std::uint32_t*
+      get_uint32s(const std::string& name, const size_t size) const
+      {
+	return static_cast<const std::uint32_t*>(
+	  this->get_array(name, TableDataType::uint32, size).data);
+      }
+
+
+      /**
+       * @return The strings stored in a text array (see TableWriter::add_strings).
+       */
+      std::vector<std::string>
+      get_strings(const std::string& name) const;
+
+
+      TableReader(TableReader const&) = delete;
+      void operator=(TableReader const&) = delete;
+
+    private:
+
+      const std::string filename;
+
+      void* memory = nullptr;
+
+      size_t length = 0;
+
+      std::uint64_t problem_hash;
+
+      std::vector<TableAxis> axes;
+
+      std::vector<TableArray> arrays;
+  };
+}
+
+
+#endif
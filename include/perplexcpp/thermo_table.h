@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERPLEXCPP_THERMOTABLE_H
+#define PERPLEXCPP_THERMOTABLE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/table_file.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * The properties stored in a ThermoTable.
+   */
+  enum class ThermoProperty
+  {
+    density,
+    expansivity,
+    molar_heat_capacity,
+    molar_entropy,
+
+    /**
+     * The weight fraction of the melt phases.
+     */
+    melt_fraction
+  };
+
+
+  /**
+   * The number of properties stored in a ThermoTable.
+   */
+  const size_t n_thermo_properties = 5;
+
+
+
+  /**
+   * The values of every ThermoProperty at a point.
+   */
+  struct ThermoProperties
+  {
+    double density;
+    double expansivity;
+    double molar_heat_capacity;
+    double molar_entropy;
+    double melt_fraction;
+  };
+
+
+
+  /**
+   * The ways in which a ThermoTable may interpolate between grid points.
+   */
+  enum class Interpolation
+  {
+    bilinear,
+
+    /**
+     * Cubic convolution (Catmull-Rom) using the surrounding 4x4 points. This
+     * reproduces the grid values and has a continuous first derivative but may
+     * overshoot near sharp changes, so the melt fraction is limited to [0, 1].
+     */
+    bicubic
+  };
+
+
+
+  /**
+   * A table of system properties on a regular pressure-temperature grid for a
+   * fixed bulk composition.
+   *
+   * The table is built once by running the solver at every grid point (in
+   * parallel, see prewarm()) after which properties are found by interpolation,
+   * which is many orders of magnitude cheaper than a minimization. Each property
+   * is stored as its own contiguous array ordered by pressure and then
+   * temperature.
+   *
+   * Tables are saved as table files (see TableWriter). A loaded table reads its
+   * property columns directly from the memory mapped file; only the interleaved
+   * copy used for batched AVX2 interpolation is built in memory, the first time
+   * it is needed.
+   */
+  class ThermoTable
+  {
+    public:
+
+      /**
+       * Build the table covering the pressure and temperature bounds of the
+       * problem.
+       *
+       * @param wrapper        The initialized wrapper.
+       * @param n_pressures    The number of grid pressures (at least 2).
+       * @param n_temperatures The number of grid temperatures (at least 2).
+       * @param composition    The bulk composition (empty for the initial bulk
+       *                       composition).
+       * @param melt_phases    The standard or abbreviated names of the phases
+       *                       counted as melt. If empty any phase with "melt" or
+       *                       "liq" in its standard or full name is used.
+       * @param n_workers      The number of worker processes used to build the
+       *                       table (zero for the number of hardware threads).
+       */
+      ThermoTable(const Wrapper& wrapper,
+	          const size_t n_pressures,
+		  const size_t n_temperatures,
+		  const std::vector<double>& composition=std::vector<double>(),
+		  const std::vector<std::string>& melt_phases=std::vector<std::string>(),
+		  const unsigned int n_workers=0);
+
+
+      ThermoTable(ThermoTable&&) = default;
+
+
+      /**
+       * Load a table written by save(). The file is mapped into memory rather
+       * than read.
+       */
+      static ThermoTable
+      load(const std::string& filename);
+
+
+      /**
+       * Write the table to a file.
+       */
+      void
+      save(const std::string& filename) const;
+
+
+      /**
+       * Interpolate a single property. Throws an exception if the point lies
+       * outside of the table.
+       *
+       * @param property    The property.
+       * @param pressure    The pressure (Pa).
+       * @param temperature The temperature (K).
+       */
+      double
+      interpolate(const ThermoProperty property,
+		  const double pressure,
+		  const double temperature) const;
+
+
+      /**
+       * Interpolate every property. Throws an exception if the point lies outside
+       * of the table.
+       *
+       * @param pressure    The pressure (Pa).
+       * @param temperature The temperature (K).
+       */
+      ThermoProperties
+      interpolate(const double pressure, const double temperature) const;
+
+
+      /**
+       * Interpolate several properties at many points. With bilinear
+       * interpolation this is considerably faster than interpolating each point
+       * separately: the points are processed four at a time with AVX2 gathers if
+       * the CPU supports them, reading the properties from a copy of the table in
+       * which the values at each grid point share a cache line. The copy is made
+       * by the first such call. Throws an exception if any point lies outside of
+       * the table.
+       *
+       * @param n            The number of points.
+       * @param pressures    The pressures (Pa).
+       * @param temperatures The temperatures (K).
+       * @param out          For each ThermoProperty, an array of n values to
+       *                     write or null to skip the property.
+       */
+      void
+      interpolate(const size_t n,
+		  const double* pressures,
+		  const double* temperatures,
+		  double* const out[n_thermo_properties]) const;
+
+
+      /**
+       * @return The value of a property at grid point (i, j).
+       */
+      inline double
+      get(const ThermoProperty property, const size_t i, const size_t j) const
+      { return this->column(property)[i * this->n_temperatures + j]; }
+
+
+      inline void
+      set_interpolation(const Interpolation interpolation) 
+      { this->interpolation = interpolation; }
+
+
+      inline Interpolation
+      get_interpolation() const { return this->interpolation; }
+
+
+      /**
+       * The hash of the problem definition file used to build the table.
+       */
+      const std::uint64_t problem_hash;
+
+
+      /**
+       * The number of grid pressures.
+       */
+      const size_t n_pressures;
+
+
+      /**
+       * The number of grid temperatures.
+       */
+      const size_t n_temperatures;
+
+
+      /**
+       * The lowest grid pressure (Pa).
+       */
+      const double min_pressure;
+
+
+      /**
+       * The highest grid pressure (Pa).
+       */
+      const double max_pressure;
+
+
+      /**
+       * The lowest grid temperature (K).
+       */
+      const double min_temperature;
+
+
+      /**
+       * The highest grid temperature (K).
+       */
+      const double max_temperature;
+
+
+      /**
+       * The bulk composition.
+       */
+      const std::vector<double> composition;
+
+
+      ThermoTable(ThermoTable const&) = delete;
+      void operator=(ThermoTable const&) = delete;
+
+    private:
+
+      /**
+       * Construct a table from an open table file.
+       */
+      ThermoTable(const std::shared_ptr<const TableReader>& file,
+		  const TableAxis& pressures,
+		  const TableAxis& temperatures,
+		  const std::vector<double>& composition);
+
+
+      /**
+       * The interpolation scheme.
+       */
+      Interpolation interpolation = Interpolation::bilinear;
+
+
+      /**
+       * The property values of a built table. Property k at grid point (i, j) is
+       * stored at index (k * n_pressures + i) * n_temperatures + j.
+       */
+      std::vector<double> values;
+
+
+      /**
+       * The file holding the property values of a loaded table.
+       */
+      std::shared_ptr<const TableReader> file;
+
+
+      /**
+       * The start of the values of each property, in either values or file.
+       */
+      const double* columns[n_thermo_properties];
+
+
+      /**
+       * The property values interleaved by grid point for batched AVX2
+       * interpolation, or empty if they have not been needed yet. The values at
+       * grid point (i, j) start at index
+       * node_offset + (i * n_temperatures + j) * node_stride.
+       */
+      mutable std::vector<double> nodes;
+
+
+      /**
+       * The offset into nodes of the first grid point, chosen so that every grid
+       * point is aligned to a cache line.
+       */
+      mutable size_t node_offset;
+
+
+      /**
+       * Ensures that nodes is only filled once when several threads interpolate
+       * at the same time. It is held by pointer so that the table can be moved.
+       */
+      std::unique_ptr<std::once_flag> nodes_once;
+
+
+      /**
+       * @return The first grid point of nodes, filling nodes from the property
+       *         columns if necessary.
+       */
+      const double*
+      interleave() const;
+
+
+      /**
+       * @return The start of the values of a property.
+       */
+      inline const double*
+      column(const ThermoProperty property) const
+      { return this->columns[static_cast<size_t>(property)]; }
+
+
+      /**
+       * Find the grid cell containing a point.
+       *
+       * @param i  Set to the pressure index of the lower corner.
+       * @param j  Set to the temperature index of the lower corner.
+       * @param u  Set to the position within the cell along the pressure axis.
+       * @param v  Set to the position within the cell along the temperature axis.
+       */
+      void
+      locate(const double pressure,
+	     const double temperature,
+	     size_t& i,
+	     size_t& j,
+	     double& u,
+	     double& v) const;
+
+
+      /**
+       * Interpolate a property within a located cell.
+       */
+      double
+      interpolate(const double* column,
+		  const size_t i,
+		  const size_t j,
+		  const double u,
+		  const double v) const;
+  };
+}
+
+
+#endif
@@ -22,6 +22,9 @@
 #define PERPLEXCPP_UTILS_H
 
 
+#include <cstdint>
+#include <string>
+
 namespace perplexcpp
 {
   namespace utils
@@ -48,6 +51,21 @@ namespace perplexcpp
      * @param stdout_descriptor The file descriptor pointing to stdout.
      */
     void enable_stdout(const int stdout_descriptor);
+
+    /**
+     * @param filename The file to hash.
+     * @return         A 64-bit FNV-1a hash of the file contents.
+     */
+    std::uint64_t hash_file(const std::string& filename);
+
+    /**
+     * @param x    The reference value.
+     * @param y    The value to compare.
+     * @param rtol The tolerance relative to x.
+     * @return     True if y lies within the tolerance of x or, if x is zero, y
+     *             is negligible. This is the comparison used by the result caches.
+     */
+    bool is_near_enough(const double x, const double y, const double rtol);
   }
 }
 
@@ -23,16 +23,23 @@
 
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include <perplexcpp/base.h>
+#include <perplexcpp/cache_backend.h>
 #include <perplexcpp/result_cache.h>
+#include <perplexcpp/solver_stats.h>
 
 
 namespace perplexcpp
 {
+  class TraceRecorder;
+
+
   /**
    * A class that controls the access to the underlying Perple_X calculations
    * and results. It utilises the singleton design pattern (only a single
@@ -62,6 +69,12 @@ namespace perplexcpp
       static Wrapper& get_instance();
 
 
+      /**
+       * A hash of the contents of the problem definition file.
+       */
+      const std::uint64_t problem_file_hash;
+
+
       /**
        * The number of composition components.
        */
@@ -145,6 +158,132 @@ namespace perplexcpp
       minimize(const double pressure, const double temperature) const;
 
 
+      /**
+       * Perform the minimization using MEEMUM, writing the result into an
+       * existing MinimizeResult. The storage of the result (its composition,
+       * phases, names and composition ratios) is reused, so once a result has
+       * been through one call, later calls make no heap allocations unless a
+       * result is added to a cache.
+       *
+       * @param pressure    The pressure (Pa).
+       * @param temperature The temperature (K).
+       * @param composition The bulk composition. 
+       * @param out         The result.
+       */
+      void
+      minimize_into(const double pressure,
+		    const double temperature,
+		    const DoubleSpan composition,
+		    MinimizeResult& out) const;
+
+
+      /**
+       * Perform the minimization using MEEMUM with the initial composition,
+       * writing the result into an existing MinimizeResult (see above).
+       */
+      void
+      minimize_into(const double pressure,
+		    const double temperature,
+		    MinimizeResult& out) const;
+
+
+      /**
+       * Perform the minimization using MEEMUM without consulting or updating the
+       * caches.
+       *
+       * @param pressure    The pressure (Pa).
+       * @param temperature The temperature (K).
+       * @param composition The bulk composition. 
+       */
+      MinimizeResult 
+      solve(const double pressure, 
+	    const double temperature,
+	    const std::vector<double>& composition) const;
+
+
+      /**
+       * Enable or disable the Perple_X stage timers. When enabled the timings of
+       * each solved minimization are available from get_last_profile() and the
+       * totals are accumulated in the wrapper. When disabled the timers cost
+       * nothing.
+       */
+      void
+      set_profiling(const bool enabled);
+
+
+      inline bool
+      is_profiling() const { return this->profiling; }
+
+
+      /**
+       * Enable or disable the hardware performance counters (cycles,
+       * instructions, cache misses and branch misses). When enabled the
+       * counts of each minimize call are held in its SolveCounters and
+       * aggregated in the statistics, and the counts of each stage of a solved
+       * minimization are held in its SolveProfile, along with the stage
+       * timings.
+       *
+       * The counters are read with the Linux perf_event_open system call so
+       * only the calling thread is counted. Enabling them throws an exception
+       * if they are not available.
+       */
+      void
+      set_hardware_counting(const bool enabled);
+
+
+      inline bool
+      is_hardware_counting() const { return this->hardware_counting; }
+
+
+      /**
+       * @return The work done by the last call to minimize(), minimize_into() or
+       *         solve(), including whether its result was taken from a cache.
+       */
+      inline const SolveCounters&
+      get_last_counters() const { return this->last_counters; }
+
+
+      /**
+       * @return The stage timings of the last call to minimize(),
+       *         minimize_into() or solve(). These are zero unless profiling or
+       *         hardware counting is enabled and the result was solved rather
+       *         than taken from a cache.
+       */
+      inline const SolveProfile&
+      get_last_profile() const { return this->last_profile; }
+
+
+      /**
+       * @return The stage timings accumulated over every profiled minimization.
+       */
+      inline const SolveProfile&
+      get_profile() const { return this->profile; }
+
+
+      /**
+       * Set the accumulated stage timings to zero.
+       */
+      void
+      reset_profile();
+
+
+      /**
+       * @return The statistics of every minimization since the wrapper was
+       *         constructed or the statistics were last reset. Minimizations
+       *         done by worker processes (e.g. by minimize_batch) are not
+       *         included.
+       */
+      inline const SolverStats&
+      get_stats() const { return this->stats; }
+
+
+      /**
+       * Set the statistics to zero.
+       */
+      void
+      reset_stats();
+
+
       inline const ResultCache&
       get_cache() const { return this->cache; }
 
@@ -153,6 +292,37 @@ namespace perplexcpp
       get_cache() { return this->cache; }
 
 
+      /**
+       * Set an additional cache to consult if the result is not found in the
+       * LRU cache (e.g. an InterpolatingCache). Solved results are added to both.
+       *
+       * @param backend The cache. Passing a null pointer removes it.
+       */
+      inline void
+      set_cache_backend(const std::shared_ptr<CacheBackend>& backend) 
+      { this->cache_backend = backend; }
+
+
+      inline std::shared_ptr<CacheBackend>
+      get_cache_backend() const { return this->cache_backend; }
+
+
+      /**
+       * Record every call to minimize() and minimize_into() (the point, whether
+       * the result came from a cache and the latency) in a trace, e.g. to replay
+       * production traffic with the perplexcpp-replay-trace tool.
+       *
+       * @param recorder The recorder. Passing a null pointer stops recording.
+       */
+      inline void
+      set_trace_recorder(const std::shared_ptr<TraceRecorder>& recorder)
+      { this->trace_recorder = recorder; }
+
+
+      inline std::shared_ptr<TraceRecorder>
+      get_trace_recorder() const { return this->trace_recorder; }
+
+
       // Disable copy constructors because the object is a singleton. 
       // These are public to improve error messages.
       // (source: https://stackoverflow.com/questions/1008019/c-singleton-design-pattern)
@@ -167,6 +337,12 @@ namespace perplexcpp
       static bool initialized;
 
 
+      /**
+       * The hash of the problem definition file.
+       */
+      static std::uint64_t problem_hash;
+
+
       /**
        * The max number of results stored by the cache.
        */
@@ -186,12 +362,121 @@ namespace perplexcpp
       mutable ResultCache cache;
 
 
+      /**
+       * An optional secondary cache.
+       */
+      std::shared_ptr<CacheBackend> cache_backend;
+
+
+      /**
+       * An optional recorder of the minimize calls.
+       */
+      std::shared_ptr<TraceRecorder> trace_recorder;
+
+
+      /**
+       * Whether or not the stage timers are enabled.
+       */
+      bool profiling;
+
+
+      /**
+       * Whether or not the hardware performance counters are enabled.
+       */
+      bool hardware_counting;
+
+
+      /**
+       * The accumulated stage timings.
+       */
+      mutable SolveProfile profile;
+
+
+      /**
+       * The work counters of the last minimization.
+       */
+      mutable SolveCounters last_counters;
+
+
+      /**
+       * The stage timings of the last minimization.
+       */
+      mutable SolveProfile last_profile;
+
+
+      /**
+       * The statistics of the minimizations.
+       */
+      mutable SolverStats stats;
+
+
+      /**
+       * The composition of the current query as a vector, as required by the
+       * caches. Its storage is reused between queries.
+       */
+      mutable std::vector<double> query_composition;
+
+
+      /**
+       * The buffer into which the result of a minimization is exported from
+       * Perple_X. It is allocated once so reading a result needs no calls to
+       * Perple_X per value.
+       */
+      mutable std::vector<double> export_values;
+
+
+      /**
+       * The solution phase index of each exported result phase.
+       */
+      mutable std::vector<int> export_ids;
+
+
       /**
        * Construct the class.
        *
        * @remark This constructor is private to enforce the singleton pattern.
        */
       Wrapper();
+
+
+      /**
+       * Throw an exception if the arguments to minimize() are invalid.
+       */
+      void
+      check_arguments(const double pressure, 
+		      const double temperature,
+		      const DoubleSpan composition) const;
+
+
+      /**
+       * Run MEEMUM and extract the result into out, reusing its storage. The
+       * work counters and stage timings are stored in last_counters and
+       * last_profile.
+       */
+      void
+      compute(const double pressure,
+	      const double temperature,
+	      const DoubleSpan composition,
+	      MinimizeResult& out) const;
+
+
+      /**
+       * Copy the properties of the last minimization into a result, reusing its
+       * storage. The pressure, temperature and composition are not set.
+       */
+      void
+      read_result(MinimizeResult& out) const;
+
+
+      /**
+       * Add a minimize call to the statistics and the trace.
+       */
+      void
+      record(const double pressure,
+	     const double temperature,
+	     const DoubleSpan composition,
+	     const SolveCounters& counters,
+	     const double latency) const;
   };
 }
 
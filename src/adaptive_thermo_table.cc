@@ -0,0 +1,489 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/adaptive_thermo_table.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <perplexcpp/table_file.h>
+
+#include "thermo_grid.h"
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * The kind of table recorded in table files.
+ */
+const char table_kind[] = "AdaptiveThermoTable";
+
+
+/**
+ * The number of integers stored per node in table files.
+ */
+const size_t node_size = 5;
+
+
+/**
+ * The deepest tree supported. The lattice coordinates of the points must fit in
+ * 32 bits.
+ */
+const size_t max_supported_depth = 30;
+
+
+/**
+ * A cell waiting to be considered for refinement.
+ */
+struct Cell
+{
+  std::uint32_t node;
+  std::uint32_t x;
+  std::uint32_t y;
+  std::uint32_t size;
+  size_t depth;
+};
+
+
+/**
+ * The points of the tree during construction. They are identified by their
+ * coordinates on a lattice spanning the range with 2^max_depth intervals along
+ * each axis.
+ */
+class PointSet
+{
+  public:
+
+    PointSet(const Wrapper& wrapper,
+             const std::vector<double>& composition,
+	     const std::vector<bool>& is_melt_phase,
+	     const size_t max_depth,
+	     const unsigned int n_workers)
+      : wrapper(wrapper),
+        composition(composition),
+	is_melt_phase(is_melt_phase),
+	resolution(std::uint64_t(1) << max_depth),
+	n_workers(n_workers)
+    {}
+
+
+    /**
+     * @return The index of a point, adding it to the set to be solved if necessary.
+     */
+    std::uint32_t
+    request(const std::uint32_t x, const std::uint32_t y)
+    {
+      const std::uint64_t key = x * (this->resolution + 1) + y;
+      auto it = this->indices.find(key);
+      if (it != this->indices.end())
+	return it->second;
+
+      const std::uint32_t idx = this->properties.size() + this->pending.size();
+      this->indices.emplace(key, idx);
+      this->pending.push_back(QueryPoint { 
+	this->wrapper.min_pressure + (this->wrapper.max_pressure - this->wrapper.min_pressure) 
+				     * x / this->resolution,
+	this->wrapper.min_temperature + (this->wrapper.max_temperature - this->wrapper.min_temperature) 
+					* y / this->resolution,
+	this->composition
+      });
+      return idx;
+    }
+
+
+    /**
+     * Solve the requested points.
+     */
+    void
+    solve()
+    {
+      if (this->pending.empty())
+	return;
+
+      std::vector<double> values;
+      std::vector<std::vector<bool>> assemblages;
+      solve_thermo_properties(this->wrapper, this->pending, this->is_melt_phase,
+			      this->n_workers, values, &assemblages);
+
+      const size_t n = this->pending.size();
+      for (size_t i = 0; i < n; ++i) {
+	std::array<double,n_thermo_properties> point;
+	for (size_t k = 0; k < n_thermo_properties; ++k)
+	  point[k] = values[k * n + i];
+	this->properties.push_back(point);
+	this->assemblages.push_back(std::move(assemblages[i]));
+      }
+      this->pending.clear();
+    }
+
+
+    /**
+     * @return True if the properties at a point are predicted well enough by
+     *         bilinear interpolation from the corners of a cell.
+     */
+    bool
+    is_predicted(const std::uint32_t point,
+                 const std::uint32_t* corners,
+		 const double u,
+		 const double v,
+		 const double rtol) const
+    {
+      for (size_t k = 0; k < n_thermo_properties; ++k) {
+	const double predicted = 
+	  (1-u) * ((1-v) * this->properties[corners[0]][k] + v * this->properties[corners[1]][k]) + 
+	  u * ((1-v) * this->properties[corners[2]][k] + v * this->properties[corners[3]][k]);
+	const double actual = this->properties[point][k];
+
+	const double error = 
+	  k == static_cast<size_t>(ThermoProperty::melt_fraction) || actual == 0.0 ?
+	  std::abs(predicted - actual) : std::abs((predicted - actual) / actual);
+	if (error > rtol)
+	  return false;
+      }
+      return true;
+    }
+
+
+    /**
+     * @return The property values in columns.
+     */
+    std::vector<double>
+    make_columns() const
+    {
+      const size_t n = this->properties.size();
+      std::vector<double> values(n_thermo_properties * n);
+      for (size_t i = 0; i < n; ++i)
+	for (size_t k = 0; k < n_thermo_properties; ++k)
+	  values[k * n + i] = this->properties[i][k];
+      return values;
+    }
+
+
+    std::vector<std::array<double,n_thermo_properties>> properties;
+
+    std::vector<std::vector<bool>> assemblages;
+
+  private:
+
+    const Wrapper& wrapper;
+
+    const std::vector<double>& composition;
+
+    const std::vector<bool> is_melt_phase;
+
+    const std::uint64_t resolution;
+
+    const unsigned int n_workers;
+
+    std::unordered_map<std::uint64_t,std::uint32_t> indices;
+
+    std::vector<QueryPoint> pending;
+};
+
+}  // namespace
+
+
+AdaptiveThermoTable::AdaptiveThermoTable(const Wrapper& wrapper,
+                                         const size_t max_depth,
+					 const double rtol,
+					 const size_t min_depth,
+					 const std::vector<double>& composition,
+					 const std::vector<std::string>& melt_phases,
+					 const unsigned int n_workers)
+  : problem_hash(wrapper.problem_file_hash),
+    max_depth(max_depth),
+    min_pressure(wrapper.min_pressure),
+    max_pressure(wrapper.max_pressure),
+    min_temperature(wrapper.min_temperature),
+    max_temperature(wrapper.max_temperature),
+    composition(composition.empty() ? wrapper.initial_bulk_composition : composition)
+{
+  if (max_depth > max_supported_depth)
+    throw std::invalid_argument("The maximum depth is too large");
+  if (rtol < 0.0)
+    throw std::invalid_argument("The tolerance must be non-negative");
+
+  PointSet points(wrapper, this->composition, find_melt_phases(wrapper, melt_phases),
+		  max_depth, n_workers);
+
+  const std::uint32_t size = std::uint32_t(1) << max_depth;
+  Node root;
+  root.children = 0;
+  root.corners[0] = points.request(0, 0);
+  root.corners[1] = points.request(0, size);
+  root.corners[2] = points.request(size, 0);
+  root.corners[3] = points.request(size, size);
+  this->nodes.push_back(root);
+
+  std::vector<Cell> cells { Cell { 0, 0, 0, size, 0 } };
+  while (!cells.empty()) {
+    // Request the centres and edge midpoints of every cell that may be refined
+    // and solve them together.
+    for (const Cell& cell : cells) {
+      if (cell.depth == max_depth)
+	continue;
+      const std::uint32_t h = cell.size / 2;
+      points.request(cell.x + h, cell.y);
+      points.request(cell.x, cell.y + h);
+      points.request(cell.x + h, cell.y + h);
+      points.request(cell.x + h, cell.y + cell.size);
+      points.request(cell.x + cell.size, cell.y + h);
+    }
+    points.solve();
+
+    std::vector<Cell> next_cells;
+    for (const Cell& cell : cells) {
+      if (cell.depth == max_depth)
+	continue;
+
+      const std::uint32_t h = cell.size / 2;
+      const std::uint32_t x[3] = { cell.x, cell.x + h, cell.x + cell.size };
+      const std::uint32_t y[3] = { cell.y, cell.y + h, cell.y + cell.size };
+
+      std::uint32_t grid[3][3];
+      for (int a = 0; a < 3; ++a)
+	for (int b = 0; b < 3; ++b)
+	  grid[a][b] = points.request(x[a], y[b]);
+
+      bool refine = cell.depth < min_depth;
+      const std::uint32_t* corners = this->nodes[cell.node].corners;
+      for (int a = 0; a < 3 && !refine; ++a)
+	for (int b = 0; b < 3 && !refine; ++b)
+	  refine = points.assemblages[grid[a][b]] != points.assemblages[corners[0]] ||
+		   !points.is_predicted(grid[a][b], corners, 0.5*a, 0.5*b, rtol);
+      if (!refine)
+	continue;
+
+      const std::uint32_t first_child = this->nodes.size();
+      this->nodes[cell.node].children = first_child;
+      for (int a = 0; a < 2; ++a)
+	for (int b = 0; b < 2; ++b) {
+	  Node child;
+	  child.children = 0;
+	  child.corners[0] = grid[a][b];
+	  child.corners[1] = grid[a][b+1];
+	  child.corners[2] = grid[a+1][b];
+	  child.corners[3] = grid[a+1][b+1];
+	  this->nodes.push_back(child);
+
+	  next_cells.push_back(Cell { first_child + 2*a + b, x[a], y[b], h, cell.depth + 1 });
+	}
+    }
+    cells.swap(next_cells);
+  }
+
+  // Only keep the points that are corners of the tree. The probes of cells that
+  // were not refined are not needed.
+  std::vector<std::uint32_t> new_indices(points.properties.size(), UINT32_MAX);
+  std::uint32_t n_used = 0;
+  for (Node& node : this->nodes)
+    for (std::uint32_t& corner : node.corners) {
+      if (new_indices[corner] == UINT32_MAX)
+	new_indices[corner] = n_used++;
+      corner = new_indices[corner];
+    }
+
+  const std::vector<double> all_values = points.make_columns();
+  const size_t n_all = points.properties.size();
+  this->values.resize(n_thermo_properties * n_used);
+  for (size_t i = 0; i < n_all; ++i)
+    if (new_indices[i] != UINT32_MAX)
+      for (size_t k = 0; k < n_thermo_properties; ++k)
+	this->values[k * n_used + new_indices[i]] = all_values[k * n_all + i];
+}
+
+
+AdaptiveThermoTable::AdaptiveThermoTable(const std::uint64_t problem_hash,
+                                         const size_t max_depth,
+					 const double min_pressure,
+					 const double max_pressure,
+					 const double min_temperature,
+					 const double max_temperature,
+					 const std::vector<double>& composition,
+					 std::vector<Node>&& nodes,
+					 std::vector<double>&& values)
+  : problem_hash(problem_hash),
+    max_depth(max_depth),
+    min_pressure(min_pressure),
+    max_pressure(max_pressure),
+    min_temperature(min_temperature),
+    max_temperature(max_temperature),
+    composition(composition),
+    nodes(std::move(nodes)),
+    values(std::move(values))
+{}
+
+
+AdaptiveThermoTable
+AdaptiveThermoTable::load(const std::string& filename)
+{
+  const TableReader file(filename, table_kind);
+
+  // The axes record the finest lattice of the tree.
+  const TableAxis& pressures = file.get_axis("pressure");
+  const TableAxis& temperatures = file.get_axis("temperature");
+  size_t max_depth = 0;
+  while (max_depth < max_supported_depth && (size_t(1) << max_depth) + 1 < pressures.size)
+    max_depth++;
+  if ((size_t(1) << max_depth) + 1 != pressures.size || temperatures.size != pressures.size)
+    throw std::runtime_error("'" + filename + "' is corrupt.");
+
+  const size_t n_components = file.get_array("composition").size;
+  const double* c = file.get_doubles("composition", n_components);
+  std::vector<double> composition(c, c + n_components);
+
+  const size_t n_nodes = file.get_array("nodes").size / node_size;
+  const std::uint32_t* node_data = file.get_uint32s("nodes", n_nodes * node_size);
+  std::vector<Node> nodes(n_nodes);
+  for (size_t n = 0; n < n_nodes; ++n) {
+    nodes[n].children = node_data[n * node_size];
+    std::copy(node_data + n * node_size + 1, node_data + (n+1) * node_size, 
+	      nodes[n].corners);
+  }
+
+  const size_t n_points = file.get_array(thermo_property_names[0]).size;
+  std::vector<double> values(n_thermo_properties * n_points);
+  for (size_t k = 0; k < n_thermo_properties; ++k) {
+    const double* column = file.get_doubles(thermo_property_names[k], n_points);
+    std::copy(column, column + n_points, values.begin() + k * n_points);
+  }
+
+  // Children are always stored after their parent so a lookup cannot loop.
+  for (size_t n = 0; n < n_nodes; ++n) {
+    const size_t children = nodes[n].children;
+    if (children != 0 && (children <= n || children + 4 > n_nodes))
+      throw std::runtime_error("'" + filename + "' is corrupt.");
+    for (std::uint32_t corner : nodes[n].corners)
+      if (corner >= n_points)
+	throw std::runtime_error("'" + filename + "' is corrupt.");
+  }
+
+  return AdaptiveThermoTable(file.get_problem_hash(), max_depth, 
+			     pressures.min, pressures.max, 
+			     temperatures.min, temperatures.max, composition, 
+			     std::move(nodes), std::move(values));
+}
+
+
+void
+AdaptiveThermoTable::save(const std::string& filename) const
+{
+  std::vector<std::uint32_t> node_data;
+  node_data.reserve(this->nodes.size() * node_size);
+  for (const Node& node : this->nodes) {
+    node_data.push_back(node.children);
+    node_data.insert(node_data.end(), node.corners, node.corners + 4);
+  }
+
+  const size_t n_lattice = (size_t(1) << this->max_depth) + 1;
+
+  TableWriter writer(table_kind, this->problem_hash);
+  writer.add_axis("pressure", "Pa", n_lattice, this->min_pressure, this->max_pressure);
+  writer.add_axis("temperature", "K", n_lattice, 
+		  this->min_temperature, this->max_temperature);
+  writer.add_array("composition", "", this->composition.data(), this->composition.size());
+  writer.add_array("nodes", "", node_data.data(), node_data.size());
+  for (size_t k = 0; k < n_thermo_properties; ++k)
+    writer.add_array(thermo_property_names[k], thermo_property_units[k],
+		     this->values.data() + k * this->n_points(), this->n_points());
+  writer.write(filename);
+}
+
+
+double
+AdaptiveThermoTable::interpolate(const ThermoProperty property,
+                                 const double pressure,
+				 const double temperature) const
+{
+  double u, v;
+  size_t depth;
+  const Node& leaf = this->find_leaf(pressure, temperature, u, v, depth);
+  return this->interpolate(property, leaf, u, v);
+}
+
+
+ThermoProperties
+AdaptiveThermoTable::interpolate(const double pressure, const double temperature) const
+{
+  double u, v;
+  size_t depth;
+  const Node& leaf = this->find_leaf(pressure, temperature, u, v, depth);
+
+  return ThermoProperties {
+    this->interpolate(ThermoProperty::density, leaf, u, v),
+    this->interpolate(ThermoProperty::expansivity, leaf, u, v),
+    this->interpolate(ThermoProperty::molar_heat_capacity, leaf, u, v),
+    this->interpolate(ThermoProperty::molar_entropy, leaf, u, v),
+    this->interpolate(ThermoProperty::melt_fraction, leaf, u, v)
+  };
+}
+
+
+size_t
+AdaptiveThermoTable::depth(const double pressure, const double temperature) const
+{
+  double u, v;
+  size_t depth;
+  this->find_leaf(pressure, temperature, u, v, depth);
+  return depth;
+}
+
+
+const AdaptiveThermoTable::Node&
+AdaptiveThermoTable::find_leaf(const double pressure,
+                               const double temperature,
+			       double& u,
+			       double& v,
+			       size_t& depth) const
+{
+  if (pressure < this->min_pressure || pressure > this->max_pressure)
+    throw std::invalid_argument("The pressure lies outside of the table");
+  if (temperature < this->min_temperature || temperature > this->max_temperature)
+    throw std::invalid_argument("The temperature lies outside of the table");
+
+  // Work in coordinates where the table spans [0, 1] along each axis.
+  u = (pressure - this->min_pressure) / (this->max_pressure - this->min_pressure);
+  v = (temperature - this->min_temperature) / 
+      (this->max_temperature - this->min_temperature);
+
+  const Node* node = &this->nodes[0];
+  depth = 0;
+  while (node->children != 0) {
+    // Rescale the coordinates to the child containing the point.
+    u *= 2;
+    v *= 2;
+    const int a = u >= 1.0;
+    const int b = v >= 1.0;
+    u -= a;
+    v -= b;
+
+    node = &this->nodes[node->children + 2*a + b];
+    depth++;
+  }
+  return *node;
+}
+
+}  // namespace
@@ -25,13 +25,22 @@
 
 namespace perplexcpp
 {
-  Phase find_phase(const std::vector<Phase> phases, const std::string name)
+  Phase
+  find_phase(const std::vector<Phase>& phases, const std::string& name)
   {
-    for (auto phase : phases) {
+    return phases[find_phase_index(phases, name)];
+  }
+
+
+  size_t
+  find_phase_index(const std::vector<Phase>& phases, const std::string& name)
+  {
+    for (size_t i = 0; i < phases.size(); i++) {
+      const Phase& phase = phases[i];
       if (name == phase.name.standard ||
 	  name == phase.name.abbreviated ||
 	  name == phase.name.full)
-	return phase;
+	return i;
     }
     throw std::invalid_argument("The name '"+name+"' could not be found.");
   }
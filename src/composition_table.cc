@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/composition_table.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include <perplexcpp/table_file.h>
+
+#include "thermo_grid.h"
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * The kind of table recorded in table files.
+ */
+const char table_kind[] = "CompositionTable";
+
+
+/**
+ * The finest level supported.
+ */
+const size_t max_supported_level = 20;
+
+
+/**
+ * @return The indices of the components whose bounds differ. Throws an exception
+ *         if the bounds are invalid.
+ */
+std::vector<size_t>
+find_varying_components(const std::vector<double>& min_composition,
+                        const std::vector<double>& max_composition)
+{
+  if (min_composition.size() != max_composition.size())
+    throw std::invalid_argument("The composition bounds differ in size");
+
+  std::vector<size_t> varying;
+  for (size_t c = 0; c < min_composition.size(); ++c) {
+    if (min_composition[c] < 0 || max_composition[c] < min_composition[c])
+      throw std::invalid_argument("The composition bounds are invalid");
+    if (max_composition[c] > min_composition[c])
+      varying.push_back(c);
+  }
+  return varying;
+}
+
+
+/**
+ * @return The number of points along a dimension of a subspace with the given
+ *         level. Level zero holds the two boundary points and level l > 0 the
+ *         points at odd multiples of 1/2^l.
+ */
+inline size_t
+n_level_points(const size_t level)
+{
+  return level == 0 ? 2 : size_t(1) << (level - 1);
+}
+
+
+/**
+ * @return The position of point m along a dimension of a subspace with the given
+ *         level.
+ */
+inline double
+level_position(const size_t level, const size_t m)
+{
+  return level == 0 ? m : (2.0 * m + 1) / (size_t(1) << level);
+}
+
+
+/**
+ * Append every level vector with n_dims entries summing to total.
+ */
+void
+add_level_vectors(const size_t n_dims,
+                  const size_t total,
+		  std::vector<std::uint8_t>& prefix,
+		  std::vector<std::uint8_t>& levels)
+{
+  if (prefix.size() == n_dims - 1) {
+    levels.insert(levels.end(), prefix.begin(), prefix.end());
+    levels.push_back(total);
+    return;
+  }
+  for (size_t l = 0; l <= total; ++l) {
+    prefix.push_back(l);
+    add_level_vectors(n_dims, total - l, prefix, levels);
+    prefix.pop_back();
+  }
+}
+
+
+/**
+ * @return The relative error of an approximation, or the absolute error if the
+ *         exact value is zero.
+ */
+double
+relative_error(const double approximation, const double exact)
+{
+  const double error = std::abs(approximation - exact);
+  return exact == 0 ? error : error / std::abs(exact);
+}
+
+}  // namespace
+
+
+CompositionTable::CompositionTable(const Wrapper& wrapper,
+                                   const size_t level,
+				   const std::vector<double>& min_composition,
+				   const std::vector<double>& max_composition,
+				   const std::vector<std::string>& melt_phases,
+				   const unsigned int n_workers)
+  : problem_hash(wrapper.problem_file_hash),
+    level(level),
+    min_pressure(wrapper.min_pressure),
+    max_pressure(wrapper.max_pressure),
+    min_temperature(wrapper.min_temperature),
+    max_temperature(wrapper.max_temperature),
+    min_composition(min_composition),
+    max_composition(max_composition),
+    varying_components(find_varying_components(min_composition, max_composition)),
+    is_melt_phase(find_melt_phases(wrapper, melt_phases))
+{
+  if (min_composition.size() != wrapper.n_composition_components)
+    throw std::invalid_argument("The composition bounds are the wrong size");
+  if (level > max_supported_level)
+    throw std::invalid_argument("The level is too large");
+
+  const size_t n_points = this->make_subspaces();
+  const size_t n_dims = this->n_dimensions();
+
+  // Generate the points of each subspace in turn.
+  std::vector<QueryPoint> points;
+  std::vector<double> positions;
+  points.reserve(n_points);
+  positions.reserve(n_points * n_dims);
+  for (size_t s = 0; s < this->subspace_offsets.size(); ++s) {
+    const std::uint8_t* levels = this->subspace_levels.data() + s * n_dims;
+    const size_t n_subspace_points = 
+      (s+1 < this->subspace_offsets.size() ? this->subspace_offsets[s+1] : n_points) 
+      - this->subspace_offsets[s];
+
+    std::vector<double> x(n_dims);
+    for (size_t p = 0; p < n_subspace_points; ++p) {
+      size_t remainder = p;
+      for (size_t d = n_dims; d-- > 0;) {
+	x[d] = level_position(levels[d], remainder % n_level_points(levels[d]));
+	remainder /= n_level_points(levels[d]);
+      }
+      points.push_back(this->unscale(x));
+      positions.insert(positions.end(), x.begin(), x.end());
+    }
+  }
+
+  std::vector<double> values;
+  solve_thermo_properties(wrapper, points, this->is_melt_phase, n_workers, values);
+
+  // Hierarchize. The basis functions of a subspace vanish at the points of every
+  // subspace with the same or a lower level sum (other than at their own point)
+  // so processing the points in order and subtracting the interpolant of the
+  // surpluses found so far leaves the surplus of each point.
+  this->surpluses.assign(values.size(), 0.0);
+  std::vector<double> x(n_dims);
+  double interpolated[n_thermo_properties];
+  for (size_t i = 0; i < n_points; ++i) {
+    x.assign(positions.begin() + i * n_dims, positions.begin() + (i+1) * n_dims);
+    this->evaluate(x, interpolated);
+    for (size_t k = 0; k < n_thermo_properties; ++k)
+      this->surpluses[k * n_points + i] = values[k * n_points + i] - interpolated[k];
+  }
+}
+
+
+CompositionTable::CompositionTable(const std::uint64_t problem_hash,
+                                   const size_t level,
+				   const double min_pressure,
+				   const double max_pressure,
+				   const double min_temperature,
+				   const double max_temperature,
+				   const std::vector<double>& min_composition,
+				   const std::vector<double>& max_composition,
+				   const std::vector<bool>& is_melt_phase,
+				   std::vector<double>&& surpluses)
+  : problem_hash(problem_hash),
+    level(level),
+    min_pressure(min_pressure),
+    max_pressure(max_pressure),
+    min_temperature(min_temperature),
+    max_temperature(max_temperature),
+    min_composition(min_composition),
+    max_composition(max_composition),
+    varying_components(find_varying_components(min_composition, max_composition)),
+    is_melt_phase(is_melt_phase),
+    surpluses(std::move(surpluses))
+{
+  if (this->make_subspaces() * n_thermo_properties != this->surpluses.size())
+    throw std::runtime_error("The table has the wrong number of points.");
+}
+
+
+CompositionTable
+CompositionTable::load(const std::string& filename)
+{
+  const TableReader file(filename, table_kind);
+
+  // The axes record the finest resolution of the grid.
+  const TableAxis& pressures = file.get_axis("pressure");
+  const TableAxis& temperatures = file.get_axis("temperature");
+  size_t level = 0;
+  while (level < max_supported_level && (size_t(1) << level) + 1 < pressures.size)
+    level++;
+  if ((size_t(1) << level) + 1 != pressures.size || temperatures.size != pressures.size)
+    throw std::runtime_error("'" + filename + "' is corrupt.");
+
+  const size_t n_components = file.get_array("min_composition").size;
+  const double* min_c = file.get_doubles("min_composition", n_components);
+  const double* max_c = file.get_doubles("max_composition", n_components);
+
+  const size_t n_points = file.get_array(thermo_property_names[0]).size;
+  std::vector<double> surpluses(n_thermo_properties * n_points);
+  for (size_t k = 0; k < n_thermo_properties; ++k) {
+    const double* column = file.get_doubles(thermo_property_names[k], n_points);
+    std::copy(column, column + n_points, surpluses.begin() + k * n_points);
+  }
+
+  const size_t n_phases = file.get_array("melt_phases").size;
+  const std::uint32_t* melt = file.get_uint32s("melt_phases", n_phases);
+  const std::vector<bool> is_melt_phase(melt, melt + n_phases);
+
+  return CompositionTable(file.get_problem_hash(), level,
+			  pressures.min, pressures.max,
+			  temperatures.min, temperatures.max,
+			  std::vector<double>(min_c, min_c + n_components),
+			  std::vector<double>(max_c, max_c + n_components),
+			  is_melt_phase, std::move(surpluses));
+}
+
+
+void
+CompositionTable::save(const std::string& filename) const
+{
+  const size_t n_lattice = (size_t(1) << this->level) + 1;
+
+  TableWriter writer(table_kind, this->problem_hash);
+  writer.add_axis("pressure", "Pa", n_lattice, this->min_pressure, this->max_pressure);
+  writer.add_axis("temperature", "K", n_lattice, 
+		  this->min_temperature, this->max_temperature);
+  writer.add_array("min_composition", "", this->min_composition.data(), 
+		   this->min_composition.size());
+  writer.add_array("max_composition", "", this->max_composition.data(), 
+		   this->max_composition.size());
+
+  // The format has no boolean arrays.
+  const std::vector<std::uint32_t> melt_phases(this->is_melt_phase.begin(), 
+					       this->is_melt_phase.end());
+  writer.add_array("melt_phases", "", melt_phases.data(), melt_phases.size());
+  for (size_t k = 0; k < n_thermo_properties; ++k)
+    writer.add_array(thermo_property_names[k], thermo_property_units[k],
+		     this->surpluses.data() + k * this->n_points(), this->n_points());
+  writer.write(filename);
+}
+
+
+double
+CompositionTable::interpolate(const ThermoProperty property,
+                              const double pressure,
+			      const double temperature,
+			      const std::vector<double>& composition) const
+{
+  double values[n_thermo_properties];
+  this->evaluate(this->scale(pressure, temperature, composition), values);
+
+  const double value = values[static_cast<size_t>(property)];
+  return property == ThermoProperty::melt_fraction ? 
+	 std::min(std::max(value, 0.0), 1.0) : value;
+}
+
+
+ThermoProperties
+CompositionTable::interpolate(const double pressure,
+                              const double temperature,
+			      const std::vector<double>& composition) const
+{
+  double values[n_thermo_properties];
+  this->evaluate(this->scale(pressure, temperature, composition), values);
+
+  return ThermoProperties {
+    values[static_cast<size_t>(ThermoProperty::density)],
+    values[static_cast<size_t>(ThermoProperty::expansivity)],
+    values[static_cast<size_t>(ThermoProperty::molar_heat_capacity)],
+    values[static_cast<size_t>(ThermoProperty::molar_entropy)],
+    std::min(std::max(values[static_cast<size_t>(ThermoProperty::melt_fraction)], 0.0), 1.0)
+  };
+}
+
+
+ThermoProperties
+CompositionTable::validate(const Wrapper& wrapper,
+                           const size_t n_samples,
+			   const unsigned int n_workers,
+			   const unsigned int seed) const
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+
+  std::vector<QueryPoint> points;
+  std::vector<double> x(this->n_dimensions());
+  for (size_t n = 0; n < n_samples; ++n) {
+    for (double& xi : x)
+      xi = distribution(generator);
+    points.push_back(this->unscale(x));
+  }
+
+  if (this->is_melt_phase.size() != wrapper.n_phases)
+    throw std::invalid_argument("The table was built for a different problem");
+
+  std::vector<double> values;
+  solve_thermo_properties(wrapper, points, this->is_melt_phase, n_workers, values);
+
+  double errors[n_thermo_properties] = {};
+  for (size_t n = 0; n < n_samples; ++n) {
+    const QueryPoint& point = points[n];
+    for (size_t k = 0; k < n_thermo_properties; ++k) {
+      const ThermoProperty property = static_cast<ThermoProperty>(k);
+      const double approximation = 
+	this->interpolate(property, point.pressure, point.temperature, point.composition);
+      const double exact = values[k * n_samples + n];
+      errors[k] = std::max(errors[k], property == ThermoProperty::melt_fraction ?
+			   std::abs(approximation - exact) : 
+			   relative_error(approximation, exact));
+    }
+  }
+
+  return ThermoProperties { errors[0], errors[1], errors[2], errors[3], errors[4] };
+}
+
+
+size_t
+CompositionTable::make_subspaces()
+{
+  const size_t n_dims = this->n_dimensions();
+
+  std::vector<std::uint8_t> prefix;
+  for (size_t total = 0; total <= this->level; ++total)
+    add_level_vectors(n_dims, total, prefix, this->subspace_levels);
+
+  size_t n_points = 0;
+  for (size_t s = 0; s < this->subspace_levels.size() / n_dims; ++s) {
+    this->subspace_offsets.push_back(n_points);
+
+    size_t n_subspace_points = 1;
+    for (size_t d = 0; d < n_dims; ++d)
+      n_subspace_points *= n_level_points(this->subspace_levels[s * n_dims + d]);
+    n_points += n_subspace_points;
+  }
+  return n_points;
+}
+
+
+std::vector<double>
+CompositionTable::scale(const double pressure,
+                        const double temperature,
+			const std::vector<double>& composition) const
+{
+  if (!(pressure >= this->min_pressure && pressure <= this->max_pressure))
+    throw std::invalid_argument("The pressure lies outside of the table");
+  if (!(temperature >= this->min_temperature && temperature <= this->max_temperature))
+    throw std::invalid_argument("The temperature lies outside of the table");
+  if (composition.size() != this->min_composition.size())
+    throw std::invalid_argument("The bulk composition is the wrong size");
+
+  std::vector<double> x;
+  x.reserve(this->n_dimensions());
+  x.push_back((pressure - this->min_pressure) / (this->max_pressure - this->min_pressure));
+  x.push_back((temperature - this->min_temperature) / 
+	      (this->max_temperature - this->min_temperature));
+  for (size_t c : this->varying_components) {
+    if (!(composition[c] >= this->min_composition[c] && 
+	  composition[c] <= this->max_composition[c]))
+      throw std::invalid_argument("The bulk composition lies outside of the table");
+    x.push_back((composition[c] - this->min_composition[c]) / 
+		(this->max_composition[c] - this->min_composition[c]));
+  }
+  return x;
+}
+
+
+QueryPoint
+CompositionTable::unscale(const std::vector<double>& x) const
+{
+  QueryPoint point;
+  point.pressure = this->min_pressure + x[0] * (this->max_pressure - this->min_pressure);
+  point.temperature = this->min_temperature + 
+		      x[1] * (this->max_temperature - this->min_temperature);
+  point.composition = this->min_composition;
+  for (size_t v = 0; v < this->varying_components.size(); ++v) {
+    const size_t c = this->varying_components[v];
+    point.composition[c] += x[2+v] * (this->max_composition[c] - this->min_composition[c]);
+  }
+  return point;
+}
+
+
+void
+CompositionTable::evaluate(const std::vector<double>& x, double* out) const
+{
+  const size_t n_dims = this->n_dimensions();
+  const size_t n_points = this->n_points();
+
+  // The index and value of the single basis function of each level (above zero)
+  // along each dimension that may be nonzero at x.
+  std::vector<size_t> indices(n_dims * (this->level + 1), 0);
+  std::vector<double> weights(n_dims * (this->level + 1), 0.0);
+  for (size_t d = 0; d < n_dims; ++d)
+    for (size_t l = 1; l <= this->level; ++l) {
+      const size_t n = n_level_points(l);
+      const size_t m = std::min(static_cast<size_t>(x[d] * n), n - 1);
+      indices[d * (this->level + 1) + l] = m;
+      weights[d * (this->level + 1) + l] = 
+	std::max(0.0, 1.0 - std::abs(x[d] - level_position(l, m)) * (size_t(1) << l));
+    }
+
+  std::fill(out, out + n_thermo_properties, 0.0);
+
+  std::vector<size_t> zero_dims(n_dims), zero_strides(n_dims);
+  for (size_t s = 0; s < this->subspace_offsets.size(); ++s) {
+    const std::uint8_t* levels = this->subspace_levels.data() + s * n_dims;
+
+    // Combine the basis functions of the dimensions with nonzero level and
+    // record the dimensions at level zero, which have two basis functions.
+    size_t offset = 0, stride = 1, n_zero = 0;
+    double weight = 1.0;
+    for (size_t d = n_dims; d-- > 0;) {
+      const size_t l = levels[d];
+      if (l == 0) {
+	zero_dims[n_zero] = d;
+	zero_strides[n_zero] = stride;
+	n_zero++;
+      } else {
+	offset += indices[d * (this->level + 1) + l] * stride;
+	weight *= weights[d * (this->level + 1) + l];
+      }
+      stride *= n_level_points(l);
+    }
+    if (weight == 0.0)
+      continue;
+
+    for (size_t combination = 0; combination < (size_t(1) << n_zero); ++combination) {
+      double w = weight;
+      size_t idx = this->subspace_offsets[s] + offset;
+      for (size_t z = 0; z < n_zero; ++z) {
+	if (combination & (size_t(1) << z)) {
+	  w *= x[zero_dims[z]];
+	  idx += zero_strides[z];
+	} else
+	  w *= 1.0 - x[zero_dims[z]];
+      }
+      if (w == 0.0)
+	continue;
+
+      for (size_t k = 0; k < n_thermo_properties; ++k)
+	out[k] += w * this->surpluses[k * n_points + idx];
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/concurrent_result_cache.h>
+
+#include <algorithm>
+#include <functional>
+#include <pthread.h>
+#include <stdexcept>
+
+#include <perplexcpp/result_view.h>
+#include <perplexcpp/utils.h>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * Hold a shared lock for the lifetime of the object.
+ */
+class ReadLock
+{
+  public:
+    explicit ReadLock(pthread_rwlock_t& lock) : lock(lock) { pthread_rwlock_rdlock(&lock); }
+
+    ~ReadLock() { pthread_rwlock_unlock(&this->lock); }
+
+  private:
+    pthread_rwlock_t& lock;
+};
+
+
+/**
+ * Hold an exclusive lock for the lifetime of the object.
+ */
+class WriteLock
+{
+  public:
+    explicit WriteLock(pthread_rwlock_t& lock) : lock(lock) { pthread_rwlock_wrlock(&lock); }
+
+    ~WriteLock() { pthread_rwlock_unlock(&this->lock); }
+
+  private:
+    pthread_rwlock_t& lock;
+};
+
+}  // namespace
+
+
+struct ConcurrentResultCache::Shard
+{
+  /**
+   * An item along with its CLOCK reference bit.
+   */
+  struct Slot
+  {
+    Slot() : referenced(false) {}
+
+    std::unique_ptr<ResultView> item;
+
+    std::atomic<bool> referenced;
+  };
+
+
+  explicit Shard(const size_t capacity)
+    : slots(capacity),
+      n_items(0),
+      names(std::make_shared<PhaseNameTable>())
+  {
+    pthread_rwlock_init(&this->lock, nullptr);
+  }
+
+
+  ~Shard()
+  {
+    pthread_rwlock_destroy(&this->lock);
+  }
+
+
+  pthread_rwlock_t lock;
+
+  /**
+   * The slots. The first n_items are filled.
+   */
+  std::vector<Slot> slots;
+
+  std::atomic<size_t> n_items;
+
+  /**
+   * The position of the CLOCK hand.
+   */
+  size_t hand = 0;
+
+  /**
+   * The phase names of the items in this shard. Each shard has its own table so
+   * that it is only ever modified under the shard's exclusive lock.
+   */
+  std::shared_ptr<PhaseNameTable> names;
+};
+
+
+ConcurrentResultCache::ConcurrentResultCache(const size_t capacity,
+                                             const double rtol,
+					     const size_t n_shards)
+  : capacity(capacity),
+    n_shards(std::max<size_t>(1, std::min(n_shards, capacity))),
+    rtol(rtol),
+    n_hits(0),
+    n_misses(0)
+{
+  if (rtol < 0.0 || rtol > 1.0)
+    throw std::invalid_argument("The tolerance must be between 0 and 1");
+
+  // Divide the capacity as evenly as possible.
+  for (size_t i = 0; i < this->n_shards; ++i) {
+    const size_t shard_capacity = capacity / this->n_shards
+				  + (i < capacity % this->n_shards ? 1 : 0);
+    this->shards.emplace_back(new Shard(shard_capacity));
+  }
+}
+
+
+ConcurrentResultCache::~ConcurrentResultCache() = default;
+
+
+int
+ConcurrentResultCache::get(const double pressure,
+                           const double temperature,
+			   const std::vector<double> &composition,
+			   MinimizeResult &out)
+{
+  const size_t home = this->home_shard(pressure, temperature, composition);
+
+  bool found = this->find_in_shard(*this->shards[home], pressure, temperature,
+				   composition, out);
+
+  // Near matches may be stored in any shard.
+  if (this->rtol > 0.0)
+    for (size_t i = 0; i < this->n_shards && !found; ++i)
+      if (i != home)
+	found = this->find_in_shard(*this->shards[i], pressure, temperature,
+				    composition, out);
+
+  if (found) {
+    this->n_hits.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+  this->n_misses.fetch_add(1, std::memory_order_relaxed);
+  return -1;
+}
+
+
+void
+ConcurrentResultCache::put(const MinimizeResult& result)
+{
+  Shard& shard =
+    *this->shards[this->home_shard(result.pressure, result.temperature,
+				   result.composition)];
+  if (shard.slots.empty())
+    return;
+
+  WriteLock lock(shard.lock);
+
+  const size_t n_items = shard.n_items.load(std::memory_order_relaxed);
+  if (n_items < shard.slots.size()) {
+    shard.slots[n_items].item.reset(new ResultView(result, shard.names));
+    shard.slots[n_items].referenced.store(false, std::memory_order_relaxed);
+    shard.n_items.store(n_items+1, std::memory_order_relaxed);
+    return;
+  }
+
+  // Advance the hand, giving a second chance to recently used items, until an
+  // unreferenced item is found and evict it.
+  while (shard.slots[shard.hand].referenced.exchange(false, std::memory_order_relaxed))
+    shard.hand = (shard.hand + 1) % shard.slots.size();
+
+  shard.slots[shard.hand].item.reset(new ResultView(result, shard.names));
+  shard.hand = (shard.hand + 1) % shard.slots.size();
+}
+
+
+size_t
+ConcurrentResultCache::size() const
+{
+  size_t size = 0;
+  for (const auto& shard : this->shards)
+    size += shard->n_items.load(std::memory_order_relaxed);
+  return size;
+}
+
+
+void
+ConcurrentResultCache::reset_counters()
+{
+  this->n_hits.store(0);
+  this->n_misses.store(0);
+}
+
+
+size_t
+ConcurrentResultCache::home_shard(const double pressure,
+                                  const double temperature,
+				  const std::vector<double>& composition) const
+{
+  std::hash<double> hasher;
+  size_t hash = hasher(pressure);
+  auto combine = [&hash, &hasher](const double x) {
+    hash ^= hasher(x) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  };
+
+  combine(temperature);
+  for (double c : composition)
+    combine(c);
+  return hash % this->n_shards;
+}
+
+
+bool
+ConcurrentResultCache::find_in_shard(Shard& shard,
+                                     const double pressure,
+				     const double temperature,
+				     const std::vector<double>& composition,
+				     MinimizeResult& out) const
+{
+  ReadLock lock(shard.lock);
+
+  const size_t n_items = shard.n_items.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < n_items; ++i) {
+    const ResultView& item = *shard.slots[i].item;
+
+    if (!utils::is_near_enough(pressure, item.pressure(), this->rtol) ||
+	!utils::is_near_enough(temperature, item.temperature(), this->rtol) ||
+	item.n_components() != composition.size())
+      continue;
+
+    bool match = true;
+    for (size_t c = 0; c < composition.size() && match; ++c)
+      match = utils::is_near_enough(composition[c], item.composition()[c], this->rtol);
+
+    if (match) {
+      // Only the reference bit is written so a shared lock is sufficient.
+      shard.slots[i].referenced.store(true, std::memory_order_relaxed);
+      item.copy_to(out);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+}  // namespace
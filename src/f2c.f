@@ -116,6 +116,58 @@
           v(2) = temperature
         end subroutine
 
+        subroutine solver_set_profiling(enabled) bind(c)
+          ! enable or disable the Perple_X stage timers (lopt(28))
+          logical(c_bool), intent(in), value :: enabled
+
+          lopt(28) = enabled
+        end subroutine
+
+        subroutine solver_get_times(values) bind(c)
+          ! copy the accumulated stage times (s), see begtim/endtim
+          real(c_double), intent(out) :: values(30)
+
+          integer i
+
+          do i = 1, 30
+            values(i) = times(i)
+          end do
+        end subroutine
+
+        subroutine solver_reset_times() bind(c)
+          integer i
+
+          do i = 1, 30
+            times(i) = 0d0
+          end do
+        end subroutine
+
+        subroutine solver_get_counters(values) bind(c)
+          ! copy the work counters: lp iterations, reopt iterations, static
+          ! and dynamic compounds
+          integer(c_int), intent(out) :: values(4)
+
+          ! Source: nlib.f, resub.f
+          integer lpitr, reitr, nstcpd, ndycpd
+          common / cxtcpp / lpitr, reitr, nstcpd, ndycpd
+
+          values(1) = lpitr
+          values(2) = reitr
+          values(3) = nstcpd
+          values(4) = ndycpd
+        end subroutine
+
+        subroutine solver_reset_counters() bind(c)
+          ! Source: nlib.f, resub.f
+          integer lpitr, reitr, nstcpd, ndycpd
+          common / cxtcpp / lpitr, reitr, nstcpd, ndycpd
+
+          lpitr = 0
+          reitr = 0
+          nstcpd = 0
+          ndycpd = 0
+        end subroutine
+
 
         function get_min_pressure() bind(c) result(res)
           real(c_double) :: res
@@ -391,6 +443,105 @@
         end function
 
 
+        function res_props_get_max_n() bind(c) result(res)
+          integer(c_size_t) :: res
+
+          res = k5
+        end function
+
+
+
+        !> Copy the system properties and the properties of every result
+        !! phase into caller-provided buffers. This replaces many calls to
+        !! the individual getters and resolves each result phase to its
+        !! solution model by integer id rather than by name.
+        !! @param values Set to the system density, expansivity, molar
+        !!               entropy and molar heat capacity followed, for each
+        !!               result phase, by its weight, volume and molar
+        !!               fractions, molar amount, density and composition
+        !!               ratio (one value per component).
+        !! @param ids    Set to the zero-based solution model index of each
+        !!               result phase, or -1 if it is not a solution model.
+        !! @param n      Set to the number of result phases.
+        subroutine res_props_export(values, ids, n) bind(c)
+          real(c_double), intent(out) :: values(*)
+          integer(c_int), intent(out) :: ids(*)
+          integer(c_size_t), intent(out) :: n
+
+          integer i, c, pos
+
+          ! source: olib.f
+          double precision props, psys, psys1, pgeo, pgeo1
+          common / cxt22 / props(i8,k5), psys(i8), psys1(i8),
+     >    pgeo(i8), pgeo1(i8)
+
+          ! source: olib.f
+          double precision pcomp
+          common / cst324 / pcomp(k0,k5)
+
+          ! source: resub.f
+          integer kkp, np, ncpd, ntot
+          double precision cp3, amt
+          common / cxt15 / cp3(k0,k19), amt(k19), kkp(k19), 
+     >    np, ncpd, ntot
+
+          ! source: olib.f
+          integer icomp,istct,iphct,icp
+          common / cst6  / icomp, istct, iphct, icp
+
+          values(1) = psys(10)
+          values(2) = psys(13)
+          values(3) = psys(15)
+          values(4) = psys(12)
+
+          pos = 4
+          do i = 1, ntot
+            values(pos+1) = props(17,i) * props(16,i) / psys(17)
+            values(pos+2) = props(1,i) * props(16,i) / psys(1)
+            values(pos+3) = props(16,i) / psys(16)
+            values(pos+4) = props(16,i)
+            values(pos+5) = props(10,i)
+            pos = pos + 5
+            do c = 1, icomp
+              values(pos+c) = pcomp(c,i)
+            end do
+            pos = pos + icomp
+
+            ! The first np phases are solutions, the rest are compounds.
+            if (i.le.np) then
+              ids(i) = kkp(i) - 1
+            else
+              ids(i) = -1
+            end if
+          end do
+
+          n = ntot
+        end subroutine
+
+
+
+        !> Copy the name of a result phase into a caller-provided buffer
+        !! without allocating.
+        !! @param buffer The buffer, at least 15 characters long.
+        subroutine res_phase_props_copy_name(res_phase_idx, buffer) 
+     >      bind(c)
+          integer(c_size_t), intent(in), value :: res_phase_idx
+          character(c_char), dimension(*), intent(out) :: buffer
+
+          integer i, length
+
+          ! source: olib.f
+          character pname*14
+          common / cxt21a / pname(k5)
+
+          length = len_trim(pname(res_phase_idx+1))
+          do i = 1, length
+            buffer(i) = pname(res_phase_idx+1)(i:i)
+          end do
+          buffer(length+1) = c_null_char
+        end subroutine
+
+
         ! -----------------------------------------------------------
         ! -------------------- SYSTEM PROPERTIES --------------------
         ! -----------------------------------------------------------
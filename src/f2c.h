@@ -52,6 +52,38 @@ void solver_set_pressure(const double pressure);
  */
 void solver_set_temperature(const double temperature);
 
+/**
+ * Enable or disable the timers around the stages of the minimization.
+ */
+void solver_set_profiling(const bool enabled);
+
+/**
+ * @param values Set to the CPU time (s) accumulated by each of the 30 stage
+ *               timers since they were last reset. The timers used are 1
+ *               (static G calculation), 2 (static LP), 5 and 6 (first and
+ *               later resubstitution), 8 (dynamic LP),
+ *               9 (derivative properties) and 30 (whole optimization).
+ */
+void solver_get_times(double* values);
+
+/**
+ * Set the stage timers to zero.
+ */
+void solver_reset_times();
+
+/**
+ * @param values Set to the work done since the counters were last reset: the
+ *               number of LP iterations, the number of resubstitution
+ *               iterations and the number of static and dynamic
+ *               pseudocompounds passed to the LP.
+ */
+void solver_get_counters(int* values);
+
+/**
+ * Set the work counters to zero.
+ */
+void solver_reset_counters();
+
 
 /**
  * @return The minimum pressure (bar).
@@ -202,6 +234,35 @@ double
 get_endmember_density(const size_t endmember_idx);
 
 
+/**
+ * @return The maximum number of result phases.
+ */
+size_t res_props_get_max_n();
+
+
+/**
+ * Copy the system properties and the properties of every result phase into
+ * caller-provided buffers.
+ *
+ * @param values Set to the system density, expansivity, molar entropy and
+ *               molar heat capacity followed, for each result phase, by its
+ *               weight, volume and molar fractions, molar amount, density and
+ *               composition ratio. Must hold 
+ *               4 + res_props_get_max_n() * (5 + n_components) values.
+ * @param ids    Set to the solution phase index of each result phase, or -1 if
+ *               it is not a solution phase. Must hold res_props_get_max_n()
+ *               values.
+ * @param n      Set to the number of result phases.
+ */
+void res_props_export(double* values, int* ids, size_t* n);
+
+
+/**
+ * Copy the name of a result phase into a buffer of at least 15 characters.
+ */
+void res_phase_props_copy_name(size_t res_phase_idx, char* buffer);
+
+
 /* ----------------------------------------------------------- */
 /* -------------------- SYSTEM PROPERTIES -------------------- */
 /* ----------------------------------------------------------- */
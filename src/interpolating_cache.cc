@@ -0,0 +1,414 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/interpolating_cache.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * @return The squared Euclidean distance between two points.
+ */
+double distance_squared(const std::vector<double>& xs, const std::vector<double>& ys)
+{
+  assert(xs.size() == ys.size());
+
+  double sum = 0.0;
+  for (size_t i = 0; i < xs.size(); ++i)
+    sum += (xs[i] - ys[i]) * (xs[i] - ys[i]);
+  return sum;
+}
+
+
+/**
+ * @return The (sorted) ids of the phases that are present in the result.
+ */
+std::vector<size_t> make_assemblage(const MinimizeResult& result)
+{
+  std::vector<size_t> assemblage;
+  for (const Phase& phase : result.phases)
+    if (phase.molar_frac > 0.0)
+      assemblage.push_back(phase.id);
+  std::sort(assemblage.begin(), assemblage.end());
+  return assemblage;
+}
+
+
+/**
+ * @return True if the two results have the same phases in the same order.
+ */
+bool have_same_phases(const MinimizeResult& a, const MinimizeResult& b)
+{
+  if (a.phases.size() != b.phases.size())
+    return false;
+
+  for (size_t p = 0; p < a.phases.size(); ++p)
+    if (a.phases[p].id != b.phases[p].id ||
+	a.phases[p].composition_ratio.size() != b.phases[p].composition_ratio.size())
+      return false;
+  return true;
+}
+
+}  // namespace
+
+
+InterpolatingCache::InterpolatingCache(const size_t capacity,
+                                       const size_t n_neighbours,
+				       const double max_distance,
+				       const double pressure_scale,
+				       const double temperature_scale,
+				       const double composition_scale)
+  : capacity(capacity),
+    n_neighbours(n_neighbours),
+    max_distance(max_distance),
+    pressure_scale(pressure_scale),
+    temperature_scale(temperature_scale),
+    composition_scale(composition_scale)
+{
+  if (n_neighbours == 0)
+    throw std::invalid_argument("At least one neighbour is required");
+
+  if (max_distance < 0.0)
+    throw std::invalid_argument("The maximum distance must be a non-negative number");
+
+  if (pressure_scale <= 0.0 || temperature_scale <= 0.0 || composition_scale <= 0.0)
+    throw std::invalid_argument("The scales must be positive numbers");
+}
+
+
+int
+InterpolatingCache::get(const double pressure,
+		        const double temperature,
+		        const std::vector<double> &composition,
+		        MinimizeResult &out)
+{
+  double error_estimate;
+  return this->get(pressure, temperature, composition, out, error_estimate);
+}
+
+
+int
+InterpolatingCache::get(const double pressure,
+		        const double temperature,
+		        const std::vector<double> &composition,
+		        MinimizeResult &out,
+			double &error_estimate)
+{
+  if (this->items.size() < this->n_neighbours) {
+    this->n_misses++;
+    return -1;
+  }
+
+  const std::vector<double> point = make_point(pressure, temperature, composition);
+
+  std::vector<std::pair<double,size_t>> neighbours;
+  neighbours.reserve(this->n_neighbours);
+  this->search(0, point, neighbours);
+
+  if (neighbours.size() < this->n_neighbours) {
+    this->n_misses++;
+    return -1;
+  }
+
+  // Only interpolate between results with the same stable assemblage.
+  std::sort_heap(neighbours.begin(), neighbours.end());
+  const Item& nearest = this->items[neighbours.front().second];
+  for (const auto& neighbour : neighbours) {
+    const Item& item = this->items[neighbour.second];
+    if (item.assemblage != nearest.assemblage ||
+	!have_same_phases(item.result, nearest.result)) {
+      this->n_misses++;
+      return -1;
+    }
+  }
+
+  // The nearest result is used as a template so that the phase names and ids are
+  // carried across.
+  out = nearest.result;
+  out.pressure = pressure;
+  out.temperature = temperature;
+  out.composition = composition;
+
+  // Exact matches need not be interpolated.
+  if (neighbours.front().first == 0.0) {
+    this->last_error_estimate = error_estimate = 0.0;
+    this->n_hits++;
+    return 0;
+  }
+
+  // Inverse distance weighting.
+  std::vector<double> weights;
+  double weight_sum = 0.0;
+  for (const auto& neighbour : neighbours) {
+    weights.push_back(1.0 / neighbour.first);
+    weight_sum += weights.back();
+  }
+  for (double& w : weights)
+    w /= weight_sum;
+
+  out.density = 0.0;
+  out.expansivity = 0.0;
+  out.molar_entropy = 0.0;
+  out.molar_heat_capacity = 0.0;
+  for (Phase& phase : out.phases) {
+    phase.weight_frac = 0.0;
+    phase.volume_frac = 0.0;
+    phase.molar_frac = 0.0;
+    phase.n_moles = 0.0;
+    phase.density = 0.0;
+    std::fill(phase.composition_ratio.begin(), phase.composition_ratio.end(), 0.0);
+  }
+
+  for (size_t i = 0; i < neighbours.size(); ++i) {
+    const MinimizeResult& result = this->items[neighbours[i].second].result;
+    const double w = weights[i];
+
+    out.density += w * result.density;
+    out.expansivity += w * result.expansivity;
+    out.molar_entropy += w * result.molar_entropy;
+    out.molar_heat_capacity += w * result.molar_heat_capacity;
+
+    for (size_t p = 0; p < out.phases.size(); ++p) {
+      Phase& phase = out.phases[p];
+      const Phase& other = result.phases[p];
+
+      phase.weight_frac += w * other.weight_frac;
+      phase.volume_frac += w * other.volume_frac;
+      phase.molar_frac += w * other.molar_frac;
+      phase.n_moles += w * other.n_moles;
+      phase.density += w * other.density;
+      for (size_t c = 0; c < phase.composition_ratio.size(); ++c)
+	phase.composition_ratio[c] += w * other.composition_ratio[c];
+    }
+  }
+
+  // Estimate the error from the spread of the neighbours about the interpolant.
+  error_estimate = 0.0;
+  for (const auto& neighbour : neighbours) {
+    const MinimizeResult& result = this->items[neighbour.second].result;
+
+    if (out.density != 0.0)
+      error_estimate = std::max(error_estimate,
+				std::abs(result.density - out.density) / out.density);
+
+    for (size_t p = 0; p < out.phases.size(); ++p)
+      error_estimate = std::max(error_estimate,
+				std::abs(result.phases[p].molar_frac -
+					 out.phases[p].molar_frac));
+  }
+  this->last_error_estimate = error_estimate;
+
+  this->n_hits++;
+  return 0;
+}
+
+
+void
+InterpolatingCache::put(const MinimizeResult& result)
+{
+  if (this->capacity == 0)
+    return;
+
+  // Discard the oldest quarter of the items when full. The tree must be rebuilt
+  // afterwards anyway so it is cheaper to evict in bulk.
+  if (this->items.size() >= this->capacity) {
+    const size_t n_evict = std::max<size_t>(1, this->capacity / 4);
+    this->items.erase(this->items.begin(), this->items.begin() + n_evict);
+    this->rebuild_tree();
+  }
+
+  this->items.push_back(Item {
+    make_point(result.pressure, result.temperature, result.composition),
+    make_assemblage(result),
+    result
+  });
+
+  // Repeated insertion degrades the balance of the tree so rebuild it once
+  // enough items have been added. This keeps the amortized cost logarithmic.
+  if (++this->n_unbalanced_inserts > std::max<size_t>(16, this->items.size() / 2))
+    this->rebuild_tree();
+  else
+    this->insert_into_tree(this->items.size() - 1);
+}
+
+
+size_t
+InterpolatingCache::size() const
+{
+  return this->items.size();
+}
+
+
+void
+InterpolatingCache::reset_counters()
+{
+  this->n_hits = 0;
+  this->n_misses = 0;
+}
+
+
+void
+InterpolatingCache::set_max_distance(const double max_distance)
+{
+  if (max_distance < 0.0)
+    throw std::invalid_argument("The maximum distance must be a non-negative number");
+
+  this->max_distance = max_distance;
+}
+
+
+std::vector<double>
+InterpolatingCache::make_point(const double pressure,
+                               const double temperature,
+			       const std::vector<double>& composition) const
+{
+  std::vector<double> point;
+  point.reserve(2 + composition.size());
+
+  point.push_back(pressure / this->pressure_scale);
+  point.push_back(temperature / this->temperature_scale);
+  for (double c : composition)
+    point.push_back(c / this->composition_scale);
+  return point;
+}
+
+
+void
+InterpolatingCache::rebuild_tree()
+{
+  this->nodes.clear();
+  this->n_unbalanced_inserts = 0;
+
+  std::vector<size_t> item_idxs(this->items.size());
+  for (size_t i = 0; i < item_idxs.size(); ++i)
+    item_idxs[i] = i;
+
+  this->build_subtree(item_idxs, 0, item_idxs.size(), 0);
+}
+
+
+long
+InterpolatingCache::build_subtree(std::vector<size_t>& item_idxs,
+                                  const size_t begin,
+				  const size_t end,
+				  const size_t depth)
+{
+  if (begin == end)
+    return -1;
+
+  const size_t axis = depth % this->items[item_idxs[begin]].point.size();
+  const size_t mid = begin + (end - begin) / 2;
+
+  std::nth_element(item_idxs.begin() + begin,
+		   item_idxs.begin() + mid,
+		   item_idxs.begin() + end,
+		   [this, axis](const size_t a, const size_t b) {
+		     return this->items[a].point[axis] < this->items[b].point[axis];
+		   });
+
+  const long node_idx = this->nodes.size();
+  this->nodes.push_back(Node { item_idxs[mid], axis, -1, -1 });
+
+  const long left = build_subtree(item_idxs, begin, mid, depth+1);
+  const long right = build_subtree(item_idxs, mid+1, end, depth+1);
+  this->nodes[node_idx].left = left;
+  this->nodes[node_idx].right = right;
+
+  return node_idx;
+}
+
+
+void
+InterpolatingCache::insert_into_tree(const size_t item_idx)
+{
+  const std::vector<double>& point = this->items[item_idx].point;
+
+  if (this->nodes.empty()) {
+    this->nodes.push_back(Node { item_idx, 0, -1, -1 });
+    return;
+  }
+
+  size_t node_idx = 0;
+  size_t depth = 0;
+  while (true) {
+    Node& node = this->nodes[node_idx];
+    const double split = this->items[node.item].point[node.axis];
+    long& child = point[node.axis] < split ? node.left : node.right;
+
+    ++depth;
+    if (child < 0) {
+      child = this->nodes.size();
+      // The reference may be invalidated by the push so it must happen last.
+      this->nodes.push_back(Node { item_idx, depth % point.size(), -1, -1 });
+      return;
+    }
+    node_idx = child;
+  }
+}
+
+
+void
+InterpolatingCache::search(const long node_idx,
+                           const std::vector<double>& point,
+			   std::vector<std::pair<double,size_t>>& heap) const
+{
+  if (node_idx < 0 || static_cast<size_t>(node_idx) >= this->nodes.size())
+    return;
+
+  const Node& node = this->nodes[node_idx];
+  const std::vector<double>& other = this->items[node.item].point;
+  const double max_distance_squared = this->max_distance * this->max_distance;
+
+  const double d2 = distance_squared(point, other);
+  if (d2 <= max_distance_squared) {
+    if (heap.size() < this->n_neighbours) {
+      heap.push_back(std::make_pair(d2, node.item));
+      std::push_heap(heap.begin(), heap.end());
+    }
+    else if (d2 < heap.front().first) {
+      std::pop_heap(heap.begin(), heap.end());
+      heap.back() = std::make_pair(d2, node.item);
+      std::push_heap(heap.begin(), heap.end());
+    }
+  }
+
+  const double diff = point[node.axis] - other[node.axis];
+  const long near = diff < 0 ? node.left : node.right;
+  const long far = diff < 0 ? node.right : node.left;
+
+  search(near, point, heap);
+
+  // Only descend the far branch if it could contain a closer point.
+  const double bound = heap.size() < this->n_neighbours
+		       ? max_distance_squared
+		       : std::min(max_distance_squared, heap.front().first);
+  if (diff * diff <= bound)
+    search(far, point, heap);
+}
+
+}  // namespace
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/mapped_cache.h>
+
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "mapped_result_table.h"
+
+
+namespace perplexcpp
+{
+
+MappedCache::MappedCache(const int fd,
+                         const std::string& name,
+			 const std::uint64_t problem_hash,
+			 const size_t n_components,
+			 const std::vector<PhaseName>& phase_names,
+			 const size_t n_slots)
+{
+  try {
+    if (n_slots == 0)
+      throw std::invalid_argument("The cache must have at least one slot");
+
+    this->memory = MappedResultTable::map(fd, name, problem_hash, n_components,
+					  phase_names.size(), n_slots, this->length);
+  }
+  catch (...) {
+    close(fd);
+    throw;
+  }
+
+  // The mapping remains valid once the descriptor is closed.
+  close(fd);
+
+  try {
+    this->table.reset(new MappedResultTable(this->memory, this->length, problem_hash,
+					    n_components, phase_names));
+  }
+  catch (...) {
+    munmap(this->memory, this->length);
+    throw;
+  }
+}
+
+
+MappedCache::~MappedCache()
+{
+  munmap(this->memory, this->length);
+}
+
+
+int
+MappedCache::get(const double pressure,
+                 const double temperature,
+		 const std::vector<double> &composition,
+		 MinimizeResult &out)
+{
+  if (this->table->find(pressure, temperature, composition, out)) {
+    this->n_hits++;
+    return 0;
+  }
+  this->n_misses++;
+  return -1;
+}
+
+
+void
+MappedCache::put(const MinimizeResult& result)
+{
+  this->table->insert(result);
+}
+
+
+size_t
+MappedCache::size() const
+{
+  return this->table->size();
+}
+
+
+void
+MappedCache::reset_counters()
+{
+  this->n_hits = 0;
+  this->n_misses = 0;
+}
+
+}  // namespace
@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "mapped_result_table.h"
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+const char magic[8] = "PXCACHE";
+
+const std::uint32_t version = 1;
+
+/**
+ * The number of bytes reserved for the header.
+ */
+const size_t header_size = 64;
+
+/**
+ * The slot states.
+ */
+const std::uint32_t empty = 0;
+const std::uint32_t writing = 1;
+const std::uint32_t published = 2;
+
+/**
+ * The fraction of slots that may be filled. Keeping some slots empty bounds the
+ * length of the probe sequences.
+ */
+const double max_load = 0.9;
+
+
+/**
+ * The start of each slot.
+ */
+struct SlotHeader
+{
+  std::atomic<std::uint32_t> state;
+
+  std::uint32_t padding;
+
+  std::uint64_t key_hash;
+};
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+	      "Lock-free atomics are required to share memory between processes");
+
+
+size_t n_values(const size_t n_components, const size_t n_phases)
+{
+  return 2 + n_components + 4 + n_phases * (5 + n_components);
+}
+
+
+size_t slot_size(const size_t n_components, const size_t n_phases)
+{
+  return sizeof(SlotHeader) + sizeof(double) * n_values(n_components, n_phases);
+}
+
+
+std::uint64_t hash_key(const double pressure,
+                       const double temperature,
+		       const std::vector<double>& composition)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  auto add = [&hash](const double value) {
+    unsigned char bytes[sizeof(double)];
+    std::memcpy(bytes, &value, sizeof(double));
+    for (unsigned char byte : bytes) {
+      hash ^= byte;
+      hash *= 1099511628211ULL;
+    }
+  };
+
+  add(pressure);
+  add(temperature);
+  for (double c : composition)
+    add(c);
+  return hash;
+}
+
+}  // namespace
+
+
+struct MappedResultTable::Header
+{
+  char magic[8];
+
+  std::uint32_t version;
+
+  std::uint32_t n_components;
+
+  std::uint32_t n_phases;
+
+  std::uint32_t slot_size;
+
+  std::uint64_t problem_hash;
+
+  std::uint64_t n_slots;
+
+  std::atomic<std::uint64_t> n_records;
+};
+
+
+size_t
+MappedResultTable::compute_size(const size_t n_components,
+                                const size_t n_phases,
+				const size_t n_slots)
+{
+  static_assert(sizeof(Header) <= header_size, "The table header is too large");
+
+  return header_size + n_slots * slot_size(n_components, n_phases);
+}
+
+
+void
+MappedResultTable::format(void* memory,
+                          const std::uint64_t problem_hash,
+			  const size_t n_components,
+			  const size_t n_phases,
+			  const size_t n_slots)
+{
+  Header* header = static_cast<Header*>(memory);
+
+  header->version = version;
+  header->n_components = n_components;
+  header->n_phases = n_phases;
+  header->slot_size = slot_size(n_components, n_phases);
+  header->problem_hash = problem_hash;
+  header->n_slots = n_slots;
+  header->n_records.store(0);
+
+  // The magic string is written last to mark the header as complete.
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, magic, sizeof(magic));
+}
+
+
+void*
+MappedResultTable::map(const int fd,
+                       const std::string& name,
+		       const std::uint64_t problem_hash,
+		       const size_t n_components,
+		       const size_t n_phases,
+		       const size_t n_slots,
+		       size_t& length)
+{
+  if (flock(fd, LOCK_EX) != 0)
+    throw std::runtime_error("Could not lock '" + name + "'.");
+
+  struct stat status;
+  if (fstat(fd, &status) != 0) {
+    flock(fd, LOCK_UN);
+    throw std::runtime_error("Could not stat '" + name + "'.");
+  }
+
+  const bool is_new = status.st_size == 0;
+  if (is_new) {
+    length = compute_size(n_components, n_phases, n_slots);
+
+    // Extending the object fills it with zeroes, which marks every slot as empty.
+    if (ftruncate(fd, length) != 0) {
+      flock(fd, LOCK_UN);
+      throw std::runtime_error("Could not resize '" + name + "'.");
+    }
+  }
+  else
+    length = status.st_size;
+
+  void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (memory == MAP_FAILED) {
+    flock(fd, LOCK_UN);
+    throw std::runtime_error("Could not map '" + name + "'.");
+  }
+
+  if (is_new)
+    format(memory, problem_hash, n_components, n_phases, n_slots);
+
+  // The mapping keeps the open file description alive so the lock must be
+  // released explicitly.
+  flock(fd, LOCK_UN);
+
+  return memory;
+}
+
+
+MappedResultTable::MappedResultTable(void* memory,
+                                     const size_t length,
+				     const std::uint64_t problem_hash,
+				     const size_t n_components,
+				     const std::vector<PhaseName>& phase_names)
+  : memory(static_cast<unsigned char*>(memory)),
+    header(static_cast<Header*>(memory)),
+    phase_names(phase_names),
+    n_components(n_components)
+{
+  if (length < header_size ||
+      std::memcmp(this->header->magic, magic, sizeof(magic)) != 0)
+    throw std::runtime_error("The cache is not a valid result table.");
+
+  if (this->header->version != version)
+    throw std::runtime_error("The cache was written by an incompatible version.");
+
+  if (this->header->problem_hash != problem_hash)
+    throw std::runtime_error("The cache was created for a different problem file.");
+
+  if (this->header->n_components != n_components ||
+      this->header->n_phases != phase_names.size())
+    throw std::runtime_error("The cache dimensions do not match the problem.");
+
+  if (length < compute_size(n_components, phase_names.size(), this->header->n_slots))
+    throw std::runtime_error("The cache is truncated.");
+}
+
+
+bool
+MappedResultTable::find(const double pressure,
+                        const double temperature,
+			const std::vector<double>& composition,
+			MinimizeResult& out) const
+{
+  if (composition.size() != this->n_components)
+    return false;
+
+  const std::uint64_t key_hash = hash_key(pressure, temperature, composition);
+  const size_t n_slots = this->n_slots();
+
+  for (size_t i = 0; i < n_slots; ++i) {
+    const size_t idx = (key_hash + i) % n_slots;
+    const SlotHeader* slot_header = reinterpret_cast<SlotHeader*>(this->slot(idx));
+
+    const std::uint32_t state = slot_header->state.load(std::memory_order_acquire);
+    if (state == empty)
+      return false;
+
+    if (state == published &&
+	slot_header->key_hash == key_hash &&
+	this->matches(idx, pressure, temperature, composition))
+      return this->read_slot(idx, out);
+  }
+  return false;
+}
+
+
+bool
+MappedResultTable::insert(const MinimizeResult& result)
+{
+  if (result.composition.size() != this->n_components ||
+      result.phases.size() != this->phase_names.size())
+    throw std::invalid_argument("The result does not match the cache dimensions.");
+
+  const size_t n_slots = this->n_slots();
+  if (this->size() >= max_load * n_slots)
+    return false;
+
+  const std::uint64_t key_hash =
+    hash_key(result.pressure, result.temperature, result.composition);
+
+  for (size_t i = 0; i < n_slots; ++i) {
+    const size_t idx = (key_hash + i) % n_slots;
+    SlotHeader* slot_header = reinterpret_cast<SlotHeader*>(this->slot(idx));
+
+    std::uint32_t state = empty;
+    if (slot_header->state.compare_exchange_strong(state, writing,
+						   std::memory_order_acq_rel)) {
+      slot_header->key_hash = key_hash;
+
+      double* values = reinterpret_cast<double*>(this->slot(idx) + sizeof(SlotHeader));
+      *values++ = result.pressure;
+      *values++ = result.temperature;
+      for (double c : result.composition)
+	*values++ = c;
+      *values++ = result.density;
+      *values++ = result.expansivity;
+      *values++ = result.molar_entropy;
+      *values++ = result.molar_heat_capacity;
+      for (const Phase& phase : result.phases) {
+	*values++ = phase.weight_frac;
+	*values++ = phase.volume_frac;
+	*values++ = phase.molar_frac;
+	*values++ = phase.n_moles;
+	*values++ = phase.density;
+	for (size_t c = 0; c < this->n_components; ++c)
+	  *values++ = phase.composition_ratio[c];
+      }
+
+      // Publish the slot.
+      slot_header->state.store(published, std::memory_order_release);
+      this->header->n_records.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    // The slot is taken. Stop if it already contains this result.
+    if (state == published &&
+	slot_header->key_hash == key_hash &&
+	this->matches(idx, result.pressure, result.temperature, result.composition))
+      return true;
+  }
+  return false;
+}
+
+
+size_t
+MappedResultTable::size() const
+{
+  return this->header->n_records.load(std::memory_order_relaxed);
+}
+
+
+size_t
+MappedResultTable::n_slots() const
+{
+  return this->header->n_slots;
+}
+
+
+unsigned char*
+MappedResultTable::slot(const size_t idx) const
+{
+  return this->memory + header_size + idx * this->header->slot_size;
+}
+
+
+bool
+MappedResultTable::read_slot(const size_t idx, MinimizeResult& out) const
+{
+  const SlotHeader* slot_header = reinterpret_cast<SlotHeader*>(this->slot(idx));
+  if (slot_header->state.load(std::memory_order_acquire) != published)
+    return false;
+
+  const double* values =
+    reinterpret_cast<const double*>(this->slot(idx) + sizeof(SlotHeader));
+
+  out.pressure = *values++;
+  out.temperature = *values++;
+  out.composition.assign(values, values + this->n_components);
+  values += this->n_components;
+  out.density = *values++;
+  out.expansivity = *values++;
+  out.molar_entropy = *values++;
+  out.molar_heat_capacity = *values++;
+
+  out.phases.resize(this->phase_names.size());
+  for (size_t p = 0; p < out.phases.size(); ++p) {
+    Phase& phase = out.phases[p];
+    phase.id = p;
+    phase.name = this->phase_names[p];
+    phase.weight_frac = *values++;
+    phase.volume_frac = *values++;
+    phase.molar_frac = *values++;
+    phase.n_moles = *values++;
+    phase.density = *values++;
+    phase.composition_ratio.assign(values, values + this->n_components);
+    values += this->n_components;
+  }
+  return true;
+}
+
+
+bool
+MappedResultTable::matches(const size_t idx,
+                           const double pressure,
+			   const double temperature,
+			   const std::vector<double>& composition) const
+{
+  const double* values =
+    reinterpret_cast<const double*>(this->slot(idx) + sizeof(SlotHeader));
+
+  if (values[0] != pressure || values[1] != temperature)
+    return false;
+
+  for (size_t c = 0; c < this->n_components; ++c)
+    if (values[2+c] != composition[c])
+      return false;
+  return true;
+}
+
+}  // namespace
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _perplexcpp_mapped_result_table_h
+#define _perplexcpp_mapped_result_table_h
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/base.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * An open addressing hash table of minimization results that lives in a
+   * block of (possibly shared) memory. It is the storage used by the memory
+   * mapped caches.
+   *
+   * The memory starts with a header recording the problem file hash and the
+   * table dimensions, followed by an array of fixed-size slots. Each slot holds
+   * a state flag, the key hash and the result flattened to doubles:
+   *
+   *     P, T, composition[n_components],
+   *     density, expansivity, molar_entropy, molar_heat_capacity,
+   *     for each phase: weight_frac, volume_frac, molar_frac, n_moles, density,
+   *                     composition_ratio[n_components]
+   *
+   * Slots are claimed with an atomic compare-and-swap and only become visible to
+   * readers once fully written, so any number of processes may read and insert
+   * concurrently without locking. Keys must match exactly. Items are never
+   * removed; once the table is full further insertions are ignored.
+   */
+  class MappedResultTable
+  {
+    public:
+
+      /**
+       * @return The number of bytes required to store a table.
+       */
+      static size_t
+      compute_size(const size_t n_components,
+	           const size_t n_phases,
+		   const size_t n_slots);
+
+
+      /**
+       * Write the header for a new table into zero-initialized memory.
+       */
+      static void
+      format(void* memory,
+	     const std::uint64_t problem_hash,
+	     const size_t n_components,
+	     const size_t n_phases,
+	     const size_t n_slots);
+
+
+      /**
+       * Map a table stored in a file or shared memory object into memory. If the
+       * object is empty it is resized and a new table is formatted. An exclusive
+       * lock is held throughout so that only one process can create the table.
+       *
+       * @param fd     The open file descriptor. It may be closed afterwards.
+       * @param name   The name of the object (used in error messages).
+       * @param length Set to the length of the mapping.
+       *
+       * @return The start of the mapping.
+       */
+      static void*
+      map(const int fd,
+	  const std::string& name,
+	  const std::uint64_t problem_hash,
+	  const size_t n_components,
+	  const size_t n_phases,
+	  const size_t n_slots,
+	  size_t& length);
+
+
+      /**
+       * Attach to a table that has already been formatted. Throws an exception if
+       * the table is incompatible with the given problem.
+       *
+       * @param memory       The start of the table.
+       * @param length       The number of bytes available.
+       * @param problem_hash The hash of the Perple_X problem definition file.
+       * @param n_components The number of composition components.
+       * @param phase_names  The names of the phases, used to reconstruct results.
+       */
+      MappedResultTable(void* memory,
+	                const size_t length,
+			const std::uint64_t problem_hash,
+			const size_t n_components,
+			const std::vector<PhaseName>& phase_names);
+
+
+      /**
+       * Look up a result. Returns true if it was found.
+       */
+      bool
+      find(const double pressure,
+	   const double temperature,
+	   const std::vector<double>& composition,
+	   MinimizeResult& out) const;
+
+
+      /**
+       * Insert a result. Returns false if the table is full.
+       */
+      bool
+      insert(const MinimizeResult& result);
+
+
+      /**
+       * @return The number of published results.
+       */
+      size_t
+      size() const;
+
+
+      /**
+       * @return The maximum number of results that can be stored.
+       */
+      size_t
+      n_slots() const;
+
+
+      /**
+       * Call a function for every published result.
+       */
+      template <typename Function>
+      void
+      for_each(Function function) const
+      {
+	MinimizeResult result;
+	for (size_t i = 0; i < this->n_slots(); ++i)
+	  if (this->read_slot(i, result))
+	    function(result);
+      }
+
+    private:
+
+      struct Header;
+
+      /**
+       * The start of the table.
+       */
+      unsigned char* const memory;
+
+
+      /**
+       * The table header.
+       */
+      Header* const header;
+
+
+      /**
+       * The phase names.
+       */
+      const std::vector<PhaseName> phase_names;
+
+
+      /**
+       * The number of composition components.
+       */
+      const size_t n_components;
+
+
+      /**
+       * @return The start of a slot.
+       */
+      unsigned char*
+      slot(const size_t idx) const;
+
+
+      /**
+       * Copy a slot into a result if it has been published. Returns true if it
+       * has.
+       */
+      bool
+      read_slot(const size_t idx, MinimizeResult& out) const;
+
+
+      /**
+       * @return True if the key stored in a slot matches exactly.
+       */
+      bool
+      matches(const size_t idx,
+	      const double pressure,
+	      const double temperature,
+	      const std::vector<double>& composition) const;
+  };
+}
+
+#endif
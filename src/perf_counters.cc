@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "perf_counters.h"
+
+#include <array>
+#include <cstdint>
+
+#ifdef PERPLEXCPP_PERF_COUNTERS
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace perplexcpp
+{
+namespace perf
+{
+namespace
+{
+
+/**
+ * The number of Perple_X stage timers.
+ */
+const size_t n_timers = 30;
+
+
+/**
+ * The number of counters in the group.
+ */
+const size_t n_counters = 4;
+
+
+/**
+ * The file descriptors of the counters. The first is the group leader.
+ */
+std::array<int,n_counters> fds = {{ -1, -1, -1, -1 }};
+
+
+/**
+ * The counts when each stage timer was started and the counts accumulated by
+ * each stage timer.
+ */
+std::array<HardwareCounters,n_timers> stage_starts;
+std::array<HardwareCounters,n_timers> stage_totals;
+
+
+#ifdef PERPLEXCPP_PERF_COUNTERS
+/**
+ * @return The file descriptor of the counter or -1 if it cannot be opened.
+ */
+int
+open_counter(const std::uint64_t config, const int group_fd)
+{
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+}  // namespace
+
+
+bool
+open()
+{
+#ifdef PERPLEXCPP_PERF_COUNTERS
+  if (is_open())
+    return true;
+
+  const std::uint64_t configs[n_counters] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+  };
+
+  // The counters are opened as a group so they are always scheduled together.
+  for (size_t i = 0; i < n_counters; ++i) {
+    fds[i] = open_counter(configs[i], i == 0 ? -1 : fds[0]);
+    if (fds[i] == -1) {
+      close();
+      return false;
+    }
+  }
+  reset_stages();
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+void
+close()
+{
+#ifdef PERPLEXCPP_PERF_COUNTERS
+  for (int& fd : fds) {
+    if (fd != -1)
+      ::close(fd);
+    fd = -1;
+  }
+#endif
+}
+
+
+bool
+is_open()
+{
+  return fds[0] != -1;
+}
+
+
+HardwareCounters
+read()
+{
+  HardwareCounters counts = HardwareCounters();
+
+#ifdef PERPLEXCPP_PERF_COUNTERS
+  // With PERF_FORMAT_GROUP the leader reads the number of counters followed by
+  // their values.
+  std::uint64_t values[1 + n_counters];
+  if (is_open() && ::read(fds[0], values, sizeof(values)) == sizeof(values)) {
+    counts.cycles = values[1];
+    counts.instructions = values[2];
+    counts.cache_misses = values[3];
+    counts.branch_misses = values[4];
+  }
+#endif
+
+  return counts;
+}
+
+
+HardwareCounters
+get_stage(const size_t timer)
+{
+  if (timer < 1 || timer > n_timers)
+    return HardwareCounters();
+  return stage_totals[timer-1];
+}
+
+
+void
+reset_stages()
+{
+  stage_totals.fill(HardwareCounters());
+}
+
+}
+}
+
+
+void 
+perplexcpp_perf_begin(const int* timer)
+{
+  using namespace perplexcpp::perf;
+
+  if (is_open() && *timer >= 1 && static_cast<size_t>(*timer) <= n_timers)
+    stage_starts[*timer-1] = read();
+}
+
+
+void 
+perplexcpp_perf_end(const int* timer)
+{
+  using namespace perplexcpp::perf;
+
+  if (is_open() && *timer >= 1 && static_cast<size_t>(*timer) <= n_timers) {
+    perplexcpp::HardwareCounters elapsed = read();
+    elapsed -= stage_starts[*timer-1];
+    stage_totals[*timer-1] += elapsed;
+  }
+}
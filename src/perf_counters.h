@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _perplexcpp_perf_counters_h
+#define _perplexcpp_perf_counters_h
+
+
+#include <cstddef>
+
+#include <perplexcpp/base.h>
+
+
+namespace perplexcpp
+{
+namespace perf
+{
+  /**
+   * Open the hardware performance counters (cycles, instructions, cache misses
+   * and branch misses) of the calling thread with perf_event_open. Once open
+   * the Perple_X stage timers also accumulate the counts of each stage.
+   *
+   * @return False if the counters are not available, e.g. because the build
+   *         does not support them, the CPU does not expose them (as in many
+   *         virtual machines) or perf_event_paranoid forbids them.
+   */
+  bool
+  open();
+
+
+  /**
+   * Close the counters.
+   */
+  void
+  close();
+
+
+  bool
+  is_open();
+
+
+  /**
+   * @return The counts since the counters were opened, or zeros if they are
+   *         not open.
+   */
+  HardwareCounters
+  read();
+
+
+  /**
+   * @param timer The index of a Perple_X stage timer (counting from one).
+   *
+   * @return The counts accumulated while the timer was running since the
+   *         stages were last reset, or zeros if there is no such timer.
+   */
+  HardwareCounters
+  get_stage(const size_t timer);
+
+
+  /**
+   * Set the counts of every stage to zero.
+   */
+  void
+  reset_stages();
+}
+}
+
+
+extern "C"
+{
+
+/**
+ * Called by the Perple_X routine begtim when a stage timer starts.
+ */
+void perplexcpp_perf_begin(const int* timer);
+
+/**
+ * Called by the Perple_X routine endtim when a stage timer stops.
+ */
+void perplexcpp_perf_end(const int* timer);
+
+}
+
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/persistent_cache.h>
+
+#include <fcntl.h>
+#include <stdexcept>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * @return A descriptor of the file, which is created if it does not exist.
+ */
+int
+open_file(const std::string& filename)
+{
+  const int fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    throw std::runtime_error("Could not open '" + filename + "'.");
+  return fd;
+}
+
+}  // namespace
+
+
+PersistentCache::PersistentCache(const std::string& filename,
+                                 const std::uint64_t problem_hash,
+				 const size_t n_components,
+				 const std::vector<PhaseName>& phase_names,
+				 const size_t n_slots)
+  : MappedCache(open_file(filename), filename, problem_hash, n_components,
+		phase_names, n_slots)
+{}
+
+}  // namespace
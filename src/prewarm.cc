@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/prewarm.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <thread>
+
+#include "mapped_result_table.h"
+#include "workers.h"
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * Solve every n_workers-th point starting from the given one and insert the
+ * results into the table.
+ */
+void
+solve_points(const Wrapper& wrapper,
+             const std::vector<QueryPoint>& points,
+	     MappedResultTable& table,
+	     const size_t first,
+	     const size_t stride)
+{
+  for (size_t i = first; i < points.size(); i += stride) {
+    const QueryPoint& point = points[i];
+    try {
+      // Bypass the caches as near matches would be stored under the wrong key.
+      table.insert(wrapper.solve(point.pressure, point.temperature,
+				 point.composition.empty() ? 
+				 wrapper.initial_bulk_composition : point.composition));
+    }
+    catch (const std::invalid_argument&) {
+      // Skip points that cannot be solved.
+    }
+  }
+}
+
+}  // namespace
+
+
+std::vector<QueryPoint>
+make_query_grid(const double min_pressure,
+                const double max_pressure,
+		const size_t n_pressures,
+		const double min_temperature,
+		const double max_temperature,
+		const size_t n_temperatures,
+		const std::vector<double>& composition)
+{
+  if (n_pressures == 0 || n_temperatures == 0)
+    throw std::invalid_argument("The grid must have at least one point");
+
+  const double dp = n_pressures > 1 ? 
+    (max_pressure - min_pressure) / (n_pressures - 1) : 0.0;
+  const double dt = n_temperatures > 1 ?
+    (max_temperature - min_temperature) / (n_temperatures - 1) : 0.0;
+
+  // The last point may otherwise round to just above the maximum and so lie
+  // outside of the problem bounds.
+  std::vector<QueryPoint> points;
+  points.reserve(n_pressures * n_temperatures);
+  for (size_t i = 0; i < n_pressures; ++i)
+    for (size_t j = 0; j < n_temperatures; ++j)
+      points.push_back(QueryPoint { std::min(min_pressure + i * dp, max_pressure), 
+				    std::min(min_temperature + j * dt, max_temperature), 
+				    composition });
+  return points;
+}
+
+
+std::vector<QueryPoint>
+read_query_points(const std::string& filename)
+{
+  std::ifstream file(filename);
+  if (!file)
+    throw std::runtime_error("Could not open '" + filename + "'.");
+
+  std::vector<QueryPoint> points;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+
+    QueryPoint point;
+    if (!(stream >> point.pressure)) {
+      // Allow blank lines and comments.
+      stream.clear();
+      std::string word;
+      if (stream >> word && word[0] != '#')
+	throw std::runtime_error("Could not read '" + filename + "': bad line '" 
+				 + line + "'.");
+      continue;
+    }
+    if (!(stream >> point.temperature))
+      throw std::runtime_error("Could not read '" + filename + "': bad line '" 
+			       + line + "'.");
+
+    double c;
+    while (stream >> c)
+      point.composition.push_back(c);
+
+    points.push_back(point);
+  }
+  return points;
+}
+
+
+size_t
+prewarm(const Wrapper& wrapper,
+        const std::vector<QueryPoint>& points,
+	CacheBackend& cache,
+	const unsigned int n_workers)
+{
+  if (points.empty())
+    return 0;
+
+  size_t n_procs = n_workers > 0 ? n_workers : std::thread::hardware_concurrency();
+  n_procs = std::max<size_t>(1, std::min(n_procs, points.size()));
+
+  // Leave room for the maximum load of the table.
+  const size_t n_slots = points.size() * 10 / 9 + 2;
+  const size_t length = 
+    MappedResultTable::compute_size(wrapper.n_composition_components,
+				    wrapper.n_phases, n_slots);
+
+  void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED)
+    throw std::runtime_error("Could not allocate the prewarming table.");
+
+  size_t n_added = 0;
+  try {
+    MappedResultTable::format(memory, wrapper.problem_file_hash,
+			      wrapper.n_composition_components, wrapper.n_phases,
+			      n_slots);
+    MappedResultTable table(memory, length, wrapper.problem_file_hash,
+			    wrapper.n_composition_components, wrapper.phase_names);
+
+    run_workers(n_procs, [&wrapper, &points, &table](const size_t w, const size_t n) {
+      solve_points(wrapper, points, table, w, n);
+    });
+
+    table.for_each([&cache, &n_added](const MinimizeResult& result) {
+      cache.put(result);
+      n_added++;
+    });
+  }
+  catch (...) {
+    munmap(memory, length);
+    throw;
+  }
+
+  munmap(memory, length);
+  return n_added;
+}
+
+}  // namespace
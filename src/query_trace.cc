@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/query_trace.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+const char magic[8] = "PXTRACE";
+
+const std::uint32_t version = 1;
+
+/**
+ * The record flags.
+ */
+const std::uint8_t hit_flag = 1;
+const std::uint8_t composition_flag = 2;
+
+/**
+ * The size of a record without its composition (flags, pressure, temperature and
+ * latency).
+ */
+const size_t record_size = 1 + 2 * sizeof(double) + sizeof(float);
+
+
+struct Header
+{
+  char magic[8];
+
+  std::uint32_t version;
+
+  std::uint32_t n_components;
+
+  std::uint64_t problem_hash;
+};
+
+
+/**
+ * Read the header of a trace file.
+ */
+Header
+read_header(std::istream& is, const std::string& filename)
+{
+  Header header;
+  is.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!is || std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+    throw std::runtime_error("'" + filename + "' is not a valid trace.");
+
+  if (header.version != version)
+    throw std::runtime_error("'" + filename + "' was written by an incompatible version.");
+  return header;
+}
+
+
+/**
+ * Read the next record of a trace, updating the composition of the previous
+ * record if it is stored.
+ *
+ * @return False if there is no complete record left.
+ */
+bool
+read_record(std::istream& is,
+            const std::string& filename,
+	    const size_t n_components,
+	    std::vector<double>& composition,
+	    TraceRecord& record)
+{
+  char buffer[record_size];
+  if (!is.read(buffer, record_size))
+    return false;
+
+  std::uint8_t flags;
+  float latency;
+  std::memcpy(&flags, buffer, 1);
+  std::memcpy(&record.pressure, buffer + 1, sizeof(double));
+  std::memcpy(&record.temperature, buffer + 1 + sizeof(double), sizeof(double));
+  std::memcpy(&latency, buffer + 1 + 2 * sizeof(double), sizeof(float));
+  record.cache_hit = flags & hit_flag;
+  record.latency = latency;
+
+  if (flags & composition_flag) {
+    std::vector<double> values(n_components);
+    if (!is.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(double)))
+      return false;
+    composition.swap(values);
+  }
+  else if (composition.empty())
+    throw std::runtime_error("'" + filename + "' is corrupt.");
+
+  record.composition = composition;
+  return true;
+}
+
+}  // namespace
+
+
+QueryTrace
+QueryTrace::load(const std::string& filename)
+{
+  std::ifstream file(filename, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("Could not open '" + filename + "'.");
+
+  const Header header = read_header(file, filename);
+
+  QueryTrace trace { header.problem_hash, header.n_components, std::vector<TraceRecord>() };
+
+  std::vector<double> composition;
+  TraceRecord record;
+  while (read_record(file, filename, trace.n_components, composition, record))
+    trace.records.push_back(record);
+  return trace;
+}
+
+
+size_t
+QueryTrace::n_cache_hits() const
+{
+  return std::count_if(this->records.begin(), this->records.end(),
+		       [](const TraceRecord& record) { return record.cache_hit; });
+}
+
+
+std::vector<QueryPoint>
+QueryTrace::to_query_points() const
+{
+  std::vector<QueryPoint> points;
+  points.reserve(this->records.size());
+  for (const TraceRecord& record : this->records)
+    points.push_back(QueryPoint { record.pressure, record.temperature, record.composition });
+  return points;
+}
+
+
+
+TraceRecorder::TraceRecorder(const std::string& filename,
+                             const std::uint64_t problem_hash,
+			     const size_t n_components)
+  : n_components(n_components),
+    n_records(0)
+{
+  // Check the header of an existing trace before appending to it.
+  std::ifstream existing(filename, std::ios::binary | std::ios::ate);
+  const std::streamoff size = existing ? static_cast<std::streamoff>(existing.tellg()) : 0;
+  const bool is_new = size == 0;
+  if (!is_new) {
+    existing.seekg(0);
+    const Header header = read_header(existing, filename);
+    if (header.problem_hash != problem_hash)
+      throw std::runtime_error("'" + filename + "' was recorded for a different problem file.");
+    if (header.n_components != n_components)
+      throw std::runtime_error("'" + filename + "' has the wrong number of components.");
+
+    // Drop a partial record left by a recording process that was killed, as the
+    // new records would otherwise be misaligned.
+    std::vector<double> composition;
+    TraceRecord record;
+    std::streamoff end = existing.tellg();
+    while (read_record(existing, filename, n_components, composition, record))
+      end = existing.tellg();
+
+    if (end < size && truncate(filename.c_str(), end) != 0)
+      throw std::runtime_error("Could not truncate '" + filename + "'.");
+  }
+  existing.close();
+
+  this->file.open(filename, std::ios::binary | std::ios::app);
+  if (!this->file)
+    throw std::runtime_error("Could not open '" + filename + "'.");
+
+  if (is_new) {
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.n_components = n_components;
+    header.problem_hash = problem_hash;
+    this->file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+}
+
+
+void
+TraceRecorder::record(const double pressure,
+                      const double temperature,
+		      const DoubleSpan composition,
+		      const bool cache_hit,
+		      const double latency)
+{
+  if (composition.size() != this->n_components)
+    throw std::invalid_argument("The bulk composition is the wrong size");
+
+  // The first record of each recorder always holds its composition so that
+  // traces may be appended to.
+  const bool is_new_composition = this->n_records == 0 ||
+    !std::equal(composition.begin(), composition.end(), this->last_composition.begin());
+
+  const std::uint8_t flags = (cache_hit ? hit_flag : 0) | 
+			     (is_new_composition ? composition_flag : 0);
+  const float latency_f = latency;
+
+  char buffer[record_size];
+  std::memcpy(buffer, &flags, 1);
+  std::memcpy(buffer + 1, &pressure, sizeof(double));
+  std::memcpy(buffer + 1 + sizeof(double), &temperature, sizeof(double));
+  std::memcpy(buffer + 1 + 2 * sizeof(double), &latency_f, sizeof(float));
+  this->file.write(buffer, record_size);
+
+  if (is_new_composition) {
+    this->file.write(reinterpret_cast<const char*>(composition.data()), 
+		     composition.size() * sizeof(double));
+    this->last_composition.assign(composition.begin(), composition.end());
+  }
+
+  if (!this->file)
+    throw std::runtime_error("Could not write to the trace.");
+  this->n_records++;
+}
+
+
+void
+TraceRecorder::flush()
+{
+  this->file.flush();
+}
+
+}  // namespace
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/result_batch.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <thread>
+
+#include <perplexcpp/table_file.h>
+
+#include "workers.h"
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * The names and units of the arrays storing the system scalars.
+ */
+const char* const scalar_names[] = {
+  "pressure", "temperature", "density", "expansivity", "molar_entropy", 
+  "molar_heat_capacity"
+};
+
+
+const char* const scalar_units[] = { "Pa", "K", "kg/m3", "1/K", "J/K", "J/K" };
+
+
+/**
+ * The names and units of the arrays storing the phase scalars.
+ */
+const char* const phase_scalar_names[] = {
+  "phase_weight_frac", "phase_volume_frac", "phase_molar_frac", "phase_n_moles", 
+  "phase_density"
+};
+
+
+const char* const phase_scalar_units[] = { "", "", "", "mol", "kg/m3" };
+
+
+/**
+ * Solve every stride-th point starting from the given one and store the
+ * results in the batch.
+ */
+void
+solve_points(const Wrapper& wrapper,
+             const std::vector<QueryPoint>& points,
+	     ResultBatch& batch,
+	     const size_t first,
+	     const size_t stride)
+{
+  for (size_t i = first; i < points.size(); i += stride) {
+    const QueryPoint& point = points[i];
+    try {
+      batch.set(i, wrapper.solve(point.pressure, point.temperature,
+				 point.composition.empty() ? 
+				 wrapper.initial_bulk_composition : point.composition));
+    }
+    catch (const std::invalid_argument&) {
+      // Leave points that cannot be solved marked as unsolved.
+    }
+  }
+}
+
+}  // namespace
+
+
+ResultBatch::ResultBatch(const size_t n_points,
+                         const std::vector<std::string>& component_names,
+			 const std::vector<PhaseName>& phase_names,
+			 const std::uint64_t problem_hash)
+  : n_points(n_points),
+    component_names(component_names),
+    phase_names(phase_names),
+    problem_hash(problem_hash)
+{
+  const size_t n_values = this->n_columns() * n_points;
+  this->length = std::max<size_t>(1, n_values * sizeof(double) + n_points);
+
+  // Anonymous mappings are zero-initialized and are shared with forked workers.
+  this->memory = mmap(nullptr, this->length, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (this->memory == MAP_FAILED)
+    throw std::runtime_error("Could not allocate the result batch.");
+
+  this->values = static_cast<double*>(this->memory);
+  this->flags = reinterpret_cast<std::uint8_t*>(this->values + n_values);
+}
+
+
+ResultBatch::ResultBatch(const Wrapper& wrapper, const size_t n_points)
+  : ResultBatch(n_points, wrapper.composition_component_names, wrapper.phase_names,
+		wrapper.problem_file_hash)
+{}
+
+
+ResultBatch::ResultBatch(ResultBatch&& other)
+  : n_points(other.n_points),
+    component_names(std::move(other.component_names)),
+    phase_names(std::move(other.phase_names)),
+    problem_hash(other.problem_hash),
+    memory(other.memory),
+    length(other.length),
+    values(other.values),
+    flags(other.flags)
+{
+  other.n_points = 0;
+  other.memory = nullptr;
+  other.length = 0;
+  other.values = nullptr;
+  other.flags = nullptr;
+}
+
+
+ResultBatch::~ResultBatch()
+{
+  if (this->memory)
+    munmap(this->memory, this->length);
+}
+
+
+ResultBatch
+ResultBatch::load(const std::string& filename)
+{
+  const TableReader file(filename, "ResultBatch");
+
+  const size_t n_points = file.get_axis("point").size;
+
+  std::vector<PhaseName> phase_names;
+  const std::vector<std::string> names = file.get_strings("phase_names");
+  if (names.size() % 3 != 0)
+    throw std::runtime_error("'" + filename + "' has malformed phase names.");
+  for (size_t i = 0; i < names.size(); i += 3)
+    phase_names.push_back(PhaseName { names[i], names[i+1], names[i+2] });
+
+  ResultBatch batch(n_points, file.get_strings("component_names"), phase_names, 
+		    file.get_problem_hash());
+
+  const size_t n_comps = batch.n_components();
+  const size_t n_phases = batch.n_phases();
+
+  for (size_t k = 0; k < n_scalars; ++k)
+    std::copy_n(file.get_doubles(scalar_names[k], n_points), n_points, batch.column(k));
+  std::copy_n(file.get_doubles("composition", n_comps * n_points), n_comps * n_points, 
+	      batch.column(n_scalars));
+  for (size_t k = 0; k < n_phase_scalars; ++k)
+    std::copy_n(file.get_doubles(phase_scalar_names[k], n_phases * n_points), 
+		n_phases * n_points, batch.phase_column(k, 0));
+  std::copy_n(file.get_doubles("phase_composition_ratio", 
+			       n_comps * n_phases * n_points),
+	      n_comps * n_phases * n_points, batch.phase_column(n_phase_scalars, 0));
+
+  const std::uint32_t* solved = file.get_uint32s("solved", n_points);
+  std::copy_n(solved, n_points, batch.flags);
+  return batch;
+}
+
+
+void
+ResultBatch::save(const std::string& filename) const
+{
+  const size_t n_comps = this->n_components();
+  const size_t n_phases = this->n_phases();
+
+  std::vector<std::string> names;
+  for (const PhaseName& name : this->phase_names) {
+    names.push_back(name.standard);
+    names.push_back(name.abbreviated);
+    names.push_back(name.full);
+  }
+
+  // The format has no byte arrays.
+  const std::vector<std::uint32_t> solved(this->flags, this->flags + this->n_points);
+
+  TableWriter writer("ResultBatch", this->problem_hash);
+  writer.add_axis("point", "", this->n_points, 0, 
+		  this->n_points > 0 ? this->n_points - 1 : 0);
+  writer.add_strings("component_names", this->component_names);
+  writer.add_strings("phase_names", names);
+  writer.add_array("solved", "", solved.data(), this->n_points);
+  for (size_t k = 0; k < n_scalars; ++k)
+    writer.add_array(scalar_names[k], scalar_units[k], this->column(k), this->n_points);
+  writer.add_array("composition", "", this->column(n_scalars), n_comps * this->n_points);
+  for (size_t k = 0; k < n_phase_scalars; ++k)
+    writer.add_array(phase_scalar_names[k], phase_scalar_units[k], 
+		     this->phase_column(k, 0), n_phases * this->n_points);
+  writer.add_array("phase_composition_ratio", "", 
+		   this->phase_column(n_phase_scalars, 0), 
+		   n_comps * n_phases * this->n_points);
+  writer.write(filename);
+}
+
+
+void
+ResultBatch::set(const size_t idx, const MinimizeResult& result)
+{
+  if (idx >= this->n_points)
+    throw std::out_of_range("The point index is out of range");
+  if (result.composition.size() != this->n_components())
+    throw std::invalid_argument("The result has the wrong number of components");
+
+  const double scalars[n_scalars] = {
+    result.pressure, 
+    result.temperature, 
+    result.density, 
+    result.expansivity,
+    result.molar_entropy, 
+    result.molar_heat_capacity
+  };
+  for (size_t k = 0; k < n_scalars; ++k)
+    this->column(k)[idx] = scalars[k];
+  for (size_t c = 0; c < this->n_components(); ++c)
+    this->column(n_scalars + c)[idx] = result.composition[c];
+
+  for (size_t p = 0; p < this->n_phases(); ++p)
+    for (size_t k = 0; k < n_phase_scalars + this->n_components(); ++k)
+      this->phase_column(k, p)[idx] = 0.0;
+
+  for (const Phase& phase : result.phases) {
+    if (phase.id >= this->n_phases() || 
+	phase.composition_ratio.size() != this->n_components())
+      throw std::invalid_argument("The result phases do not match the batch");
+
+    const double phase_scalars[n_phase_scalars] = {
+      phase.weight_frac,
+      phase.volume_frac,
+      phase.molar_frac,
+      phase.n_moles,
+      phase.density
+    };
+    for (size_t k = 0; k < n_phase_scalars; ++k)
+      this->phase_column(k, phase.id)[idx] = phase_scalars[k];
+    for (size_t c = 0; c < this->n_components(); ++c)
+      this->phase_column(n_phase_scalars + c, phase.id)[idx] = 
+	phase.composition_ratio[c];
+  }
+  this->flags[idx] = 1;
+}
+
+
+void
+ResultBatch::get(const size_t idx, MinimizeResult& out) const
+{
+  if (idx >= this->n_points)
+    throw std::out_of_range("The point index is out of range");
+  if (!this->flags[idx])
+    throw std::invalid_argument("The point has not been solved");
+
+  out.pressure = this->pressure()[idx];
+  out.temperature = this->temperature()[idx];
+  out.density = this->density()[idx];
+  out.expansivity = this->expansivity()[idx];
+  out.molar_entropy = this->molar_entropy()[idx];
+  out.molar_heat_capacity = this->molar_heat_capacity()[idx];
+
+  out.composition.resize(this->n_components());
+  for (size_t c = 0; c < this->n_components(); ++c)
+    out.composition[c] = this->composition(c)[idx];
+
+  out.phases.resize(this->n_phases());
+  for (size_t p = 0; p < this->n_phases(); ++p) {
+    Phase& phase = out.phases[p];
+    const PhaseName& name = this->phase_names[p];
+
+    phase.id = p;
+    phase.name.standard.assign(name.standard);
+    phase.name.abbreviated.assign(name.abbreviated);
+    phase.name.full.assign(name.full);
+    phase.weight_frac = this->phase_weight_frac(p)[idx];
+    phase.volume_frac = this->phase_volume_frac(p)[idx];
+    phase.molar_frac = this->phase_molar_frac(p)[idx];
+    phase.n_moles = this->phase_n_moles(p)[idx];
+    phase.density = this->phase_density(p)[idx];
+    phase.composition_ratio.resize(this->n_components());
+    for (size_t c = 0; c < this->n_components(); ++c)
+      phase.composition_ratio[c] = this->phase_composition_ratio(p, c)[idx];
+  }
+}
+
+
+size_t
+ResultBatch::n_solved() const
+{
+  return std::count(this->flags, this->flags + this->n_points, 1);
+}
+
+
+ResultBatch
+minimize_batch(const Wrapper& wrapper,
+               const std::vector<QueryPoint>& points,
+	       const unsigned int n_workers)
+{
+  ResultBatch batch(wrapper, points.size());
+  if (points.empty())
+    return batch;
+
+  size_t n_procs = n_workers > 0 ? n_workers : std::thread::hardware_concurrency();
+  n_procs = std::max<size_t>(1, std::min(n_procs, points.size()));
+
+  run_workers(n_procs, [&wrapper, &points, &batch](const size_t w, const size_t n) {
+    solve_points(wrapper, points, batch, w, n);
+  });
+  return batch;
+}
+
+}  // namespace
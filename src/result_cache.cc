@@ -20,16 +20,102 @@
 
 #include <perplexcpp/result_cache.h>
 
-#include <cassert>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include <perplexcpp/utils.h>
 
 
 namespace perplexcpp
 {
+namespace
+{
+
+/**
+ * @return The difference between x and y relative to x.
+ */
+double
+relative_difference(const double x, const double y)
+{
+  // If x is zero then y matches if it is negligible.
+  if (x == 0)
+    return y < 1e-8 ? 0.0 : std::numeric_limits<double>::infinity();
+  else
+    return std::abs(x - y) / std::abs(x);
+}
+
+
+/**
+ * @return The molar fraction of the phase with the given id (zero if absent).
+ */
+double
+find_molar_frac(const ResultView& view, const size_t id)
+{
+  for (size_t p = 0; p < view.n_phases(); ++p)
+    if (view.phase_id(p) == id)
+      return view.phase_molar_frac(p);
+  return 0.0;
+}
+
+
+/**
+ * @return True if the same phases are present in both results.
+ */
+bool
+has_same_assemblage(const ResultView& a, const ResultView& b)
+{
+  for (size_t p = 0; p < a.n_phases(); ++p)
+    if ((a.phase_molar_frac(p) > 0) != (find_molar_frac(b, a.phase_id(p)) > 0))
+      return false;
+
+  for (size_t p = 0; p < b.n_phases(); ++p)
+    if ((b.phase_molar_frac(p) > 0) != (find_molar_frac(a, b.phase_id(p)) > 0))
+      return false;
+  return true;
+}
+
+
+/**
+ * @return The largest absolute difference between the phase molar fractions.
+ */
+double
+max_molar_frac_change(const ResultView& a, const ResultView& b)
+{
+  double change = 0.0;
+  for (size_t p = 0; p < a.n_phases(); ++p)
+    change = std::max(change, std::abs(a.phase_molar_frac(p) - 
+				       find_molar_frac(b, a.phase_id(p))));
+  for (size_t p = 0; p < b.n_phases(); ++p)
+    change = std::max(change, std::abs(b.phase_molar_frac(p) - 
+				       find_molar_frac(a, b.phase_id(p))));
+  return change;
+}
+
+}  // namespace
+
+
+ResultCache::Item::Item(const MinimizeResult& result,
+			const std::shared_ptr<PhaseNameTable>& names,
+			const ResultEncoding encoding,
+			const double solve_time)
+  : view(result, names, encoding),
+    composition_total(std::accumulate(result.composition.begin(),
+				      result.composition.end(), 0.0)),
+    solve_time(solve_time),
+    // Include the list node links.
+    n_bytes(view.memory_footprint() + sizeof(Item) - sizeof(ResultView) + 2*sizeof(void*))
+{}
+
 
 ResultCache::ResultCache(const size_t capacity, const double rtol)
   : capacity(capacity),
-    rtol(rtol)
+    rtol(rtol),
+    phase_names(std::make_shared<PhaseNameTable>())
 {
     if (capacity < 0)
       throw std::invalid_argument("The capacity must be a non-negative number");
@@ -45,39 +131,145 @@ ResultCache::get(const double pressure,
 		 const std::vector<double> &composition,
 		 MinimizeResult &out)
 {
-  for (auto it = this->items.cbegin(); it != this->items.cend(); ++it)
+  const Item* item = this->find(pressure, temperature, composition);
+  if (item == nullptr)
+    return -1;
+
+  item->view.copy_to(out);
+
+  if (this->normalize_composition)
+  {
+    const double total = std::accumulate(composition.begin(), composition.end(), 0.0);
+    const double scale = total / item->composition_total;
+
+    for (double& c : out.composition)
+      c *= scale;
+    for (Phase& phase : out.phases)
+      phase.n_moles *= scale;
+    out.molar_entropy *= scale;
+    out.molar_heat_capacity *= scale;
+  }
+  return 0;
+}
+
+
+const ResultView*
+ResultCache::lookup(const double pressure, 
+		    const double temperature, 
+		    const std::vector<double> &composition)
+{
+  const Item* item = this->find(pressure, temperature, composition);
+  return item == nullptr ? nullptr : &item->view;
+}
+
+
+ResultCache::Item*
+ResultCache::find(const double pressure, 
+		  const double temperature, 
+		  const std::vector<double> &composition)
+{
+  const double total = this->normalize_composition ? 
+    std::accumulate(composition.begin(), composition.end(), 0.0) : 1.0;
+
+  for (auto it = this->items.begin(); it != this->items.end(); ++it)
   {
-    if (is_near_enough(pressure, (*it).pressure) &&
-	is_near_enough(temperature, (*it).temperature) &&
-	is_near_enough(composition, (*it).composition))
+    const ResultView& view = it->view;
+    const double item_total = this->normalize_composition ? it->composition_total : 1.0;
+
+    const bool match = this->error_tolerance > 0.0 ?
+      this->is_accurate_enough(*it, pressure, temperature, composition, total) :
+      (is_near_enough(pressure, view.pressure()) &&
+       is_near_enough(temperature, view.temperature()) &&
+       view.n_components() == composition.size() &&
+       is_near_enough(composition, view.composition(), total, item_total));
+
+    if (match)
     {
-      MinimizeResult item = *it;
+      // Move the item to the front of the list. Splicing relinks the existing
+      // node rather than copying it.
+      this->items.splice(this->items.begin(), this->items, it);
 
-      // Reorder the cache if it contains more than one item.
-      if (this->items.size() > 1)
-      {
-	this->items.erase(it);
-	this->items.push_front(item);
-      }
+      Item& item = this->items.front();
+      item.priority = this->compute_priority(item);
 
-      out = item;
       this->n_hits++;
-      return 0;
+      this->solve_time_saved += item.solve_time;
+      return &item;
     }
   }
   this->n_misses++;
-  return -1;
+  return nullptr;
 }
 
 
 void
 ResultCache::put(const MinimizeResult& item)
 {
-  // Add the new item to the front of the list and remove the last item.
-  if (items.size() == this->capacity)
-    this->items.pop_back();
+  this->put(item, 0.0);
+}
+
+
+void
+ResultCache::put(const MinimizeResult& result, const double solve_time)
+{
+  if (this->capacity == 0)
+    return;
+
+  // Build the new node separately so that its size is known before evicting.
+  std::list<Item> node;
+  node.emplace_front(result, this->phase_names, this->encoding, solve_time);
+  Item& item = node.front();
 
-  this->items.push_front(item);
+  if (this->max_bytes > 0 && item.n_bytes > this->max_bytes)
+    return;
+
+  while (!this->items.empty() &&
+	 (this->items.size() >= this->capacity ||
+	  (this->max_bytes > 0 && this->n_bytes + item.n_bytes > this->max_bytes)))
+    this->evict();
+
+  if (this->error_tolerance > 0.0)
+    this->measure_sensitivities(item);
+
+  item.priority = this->compute_priority(item);
+  this->n_bytes += item.n_bytes;
+  this->solve_time_spent += solve_time;
+  this->items.splice(this->items.begin(), node);
+}
+
+
+void
+ResultCache::set_phase_names(const std::vector<PhaseName>& names)
+{
+  // Stored results keep a reference to the old table so it is safe to replace.
+  this->phase_names = std::make_shared<PhaseNameTable>(names);
+}
+
+
+void
+ResultCache::set_error_tolerance(const double error_tolerance)
+{
+  if (error_tolerance < 0.0)
+    throw std::invalid_argument("The error tolerance must be non-negative");
+
+  this->error_tolerance = error_tolerance;
+}
+
+
+void
+ResultCache::set_eviction_policy(const EvictionPolicy policy)
+{
+  this->policy = policy;
+}
+
+
+void
+ResultCache::set_max_bytes(const size_t max_bytes)
+{
+  this->max_bytes = max_bytes;
+
+  while (this->max_bytes > 0 && this->n_bytes > this->max_bytes)
+    this->evict();
 }
 
 
@@ -93,29 +285,139 @@ ResultCache::reset_counters()
 {
   this->n_hits = 0;
   this->n_misses = 0;
+  this->solve_time_saved = 0.0;
+  this->solve_time_spent = 0.0;
+}
+
+
+bool
+ResultCache::is_accurate_enough(const Item& item,
+				const double pressure,
+				const double temperature,
+				const std::vector<double>& composition,
+				const double composition_total) const
+{
+  const double distance = this->compute_distance(item, pressure, temperature, 
+						 composition.data(), composition.size(),
+						 composition_total);
+  if (distance == 0.0)
+    return true;
+
+  return distance <= this->rtol &&
+	 distance < item.trust_radius &&
+	 item.sensitivity >= 0.0 &&
+	 item.sensitivity * distance <= this->error_tolerance;
+}
+
+
+void
+ResultCache::measure_sensitivities(Item& item)
+{
+  const ResultView& view = item.view;
+  const double total = this->normalize_composition ? item.composition_total : 1.0;
+
+  for (Item& other : this->items)
+  {
+    const double distance = 
+      this->compute_distance(other, view.pressure(), view.temperature(),
+			     view.composition(), view.n_components(), total);
+    if (distance == 0.0 || distance > 2.0 * this->rtol)
+      continue;
+
+    // A phase boundary lies somewhere between the two items.
+    if (!has_same_assemblage(view, other.view))
+    {
+      item.trust_radius = std::min(item.trust_radius, 0.5 * distance);
+      other.trust_radius = std::min(other.trust_radius, 0.5 * distance);
+      continue;
+    }
+
+    const double change = std::max(relative_difference(view.density(), 
+							other.view.density()),
+				   max_molar_frac_change(view, other.view));
+    item.sensitivity = std::max(item.sensitivity, change / distance);
+    other.sensitivity = std::max(other.sensitivity, change / distance);
+  }
+}
+
+
+double
+ResultCache::compute_distance(const Item& item,
+			      const double pressure,
+			      const double temperature,
+			      const double* composition,
+			      const size_t n_components,
+			      const double composition_total) const
+{
+  const ResultView& view = item.view;
+  if (view.n_components() != n_components)
+    return std::numeric_limits<double>::infinity();
+
+  const double item_total = this->normalize_composition ? item.composition_total : 1.0;
+
+  double distance = std::max(relative_difference(pressure, view.pressure()),
+			     relative_difference(temperature, view.temperature()));
+  for (size_t c = 0; c < n_components; ++c)
+    distance = std::max(distance, 
+			relative_difference(composition[c] / composition_total,
+					    view.composition()[c] / item_total));
+  return distance;
+}
+
+
+void
+ResultCache::evict()
+{
+  // The least recently used item is at the back of the list.
+  auto victim = std::prev(this->items.end());
+
+  if (this->policy == EvictionPolicy::greedy_dual_size)
+  {
+    // Search from the back so that the least recently used item wins ties.
+    for (auto it = this->items.rbegin(); it != this->items.rend(); ++it)
+      if (it->priority < victim->priority)
+	victim = std::prev(it.base());
+
+    // Age the remaining items by raising the priority given to new ones.
+    this->inflation = victim->priority;
+  }
+
+  this->n_bytes -= victim->n_bytes;
+  this->items.erase(victim);
+}
+
+
+double
+ResultCache::compute_priority(const Item& item) const
+{
+  return this->inflation + item.solve_time / item.n_bytes;
 }
 
 
 bool 
 ResultCache::is_near_enough(const double x, const double y) const
 {
-  // If x is zero then return true if y is negligible.
-  if (x == 0)
-    return y < 1e-8;
-  else
-    return std::abs(x - y) / x <= this->rtol;
+  return utils::is_near_enough(x, y, this->rtol);
 }
 
 
 bool 
-ResultCache::is_near_enough(const std::vector<double> xs, 
-			    const std::vector<double> ys) const
+ResultCache::is_near_enough(const std::vector<double>& xs, 
+			    const double* ys,
+			    const double x_total,
+			    const double y_total) const
 {
-  assert(xs.size() == ys.size());
+  // Dividing by the totals introduces rounding errors so always allow for these.
+  const double rtol = std::max(this->rtol, x_total == y_total ? 0.0 : 1e-12);
 
   for (size_t i = 0; i < xs.size(); ++i)
-    if (!is_near_enough(xs[i], ys[i]))
+  {
+    const double x = xs[i] / x_total;
+    const double y = ys[i] / y_total;
+
+    if (!utils::is_near_enough(x, y, rtol))
       return false;
+  }
   return true;
 }
 
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/result_view.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * The largest 16-bit fixed point number.
+ */
+const double fixed_max = std::numeric_limits<std::uint16_t>::max();
+
+
+/**
+ * @return The value, which must lie within [0, 1], as a fixed point number.
+ */
+std::uint16_t
+encode_fixed(const double x)
+{
+  return static_cast<std::uint16_t>(std::lround(std::min(std::max(x, 0.0), 1.0) * fixed_max));
+}
+
+
+/**
+ * @return The phase fraction as a fixed point number. A fraction that is not
+ *         zero is stored as at least one quantum so that a phase present in a
+ *         trace amount is not rounded away, which would change the assemblage.
+ */
+std::uint16_t
+encode_fraction(const double x)
+{
+  return x > 0.0 ? std::max<std::uint16_t>(encode_fixed(x), 1) : 0;
+}
+
+
+/**
+ * @return True if the phase is present.
+ */
+bool
+is_present(const Phase& phase)
+{
+  if (phase.weight_frac != 0.0 || phase.volume_frac != 0.0 || 
+      phase.molar_frac != 0.0 || phase.n_moles != 0.0 || phase.density != 0.0)
+    return true;
+
+  for (double r : phase.composition_ratio)
+    if (r != 0.0)
+      return true;
+  return false;
+}
+
+}  // namespace
+
+
+PhaseNameTable::PhaseNameTable(const std::vector<PhaseName>& names)
+{
+  for (const PhaseName& name : names)
+    this->intern(name);
+}
+
+
+size_t
+PhaseNameTable::intern(const PhaseName& name)
+{
+  auto it = this->indices.find(name.standard);
+  if (it != this->indices.end())
+    return it->second;
+
+  this->names.push_back(name);
+  this->indices.emplace(name.standard, this->names.size()-1);
+  return this->names.size()-1;
+}
+
+
+
+ResultView::ResultView(const MinimizeResult& result,
+                       const std::shared_ptr<PhaseNameTable>& names,
+		       const ResultEncoding encoding)
+  : encoding(encoding),
+    names(names),
+    n_comps(result.composition.size()),
+    n_phase_comps(result.phases.empty() ? 0 : result.phases[0].composition_ratio.size())
+{
+  for (const Phase& phase : result.phases)
+    if (phase.composition_ratio.size() != this->n_phase_comps)
+      throw std::invalid_argument("The phase composition ratios differ in size");
+
+  const bool is_compact = encoding != ResultEncoding::float64;
+
+  this->values.reserve(n_scalars + this->n_comps + (is_compact ? 0 :
+		       result.phases.size() * (n_phase_scalars + this->n_phase_comps)));
+
+  this->values.push_back(result.pressure);
+  this->values.push_back(result.temperature);
+  this->values.push_back(result.density);
+  this->values.push_back(result.expansivity);
+  this->values.push_back(result.molar_entropy);
+  this->values.push_back(result.molar_heat_capacity);
+  this->values.insert(this->values.end(),
+		      result.composition.begin(),
+		      result.composition.end());
+
+  if (!is_compact) {
+    this->phase_ids.reserve(result.phases.size());
+    this->name_ids.reserve(result.phases.size());
+    for (const Phase& phase : result.phases) {
+      this->phase_ids.push_back(phase.id);
+      this->name_ids.push_back(this->names->intern(phase.name));
+
+      this->values.push_back(phase.weight_frac);
+      this->values.push_back(phase.volume_frac);
+      this->values.push_back(phase.molar_frac);
+      this->values.push_back(phase.n_moles);
+      this->values.push_back(phase.density);
+      this->values.insert(this->values.end(),
+			  phase.composition_ratio.begin(),
+			  phase.composition_ratio.end());
+    }
+    return;
+  }
+
+  if (result.phases.size() > std::numeric_limits<std::uint16_t>::max())
+    throw std::invalid_argument("Too many phases for a compact encoding");
+
+  size_t n_present = 0;
+  for (size_t p = 0; p < result.phases.size(); ++p) {
+    const Phase& phase = result.phases[p];
+    if (phase.id != p || this->names->intern(phase.name) != p)
+      throw std::invalid_argument("Compact encodings require the phase ids to match "
+				  "their order and the name table indices");
+    if (is_present(phase))
+      n_present++;
+  }
+
+  this->slots.reserve(result.phases.size());
+  if (encoding == ResultEncoding::float32)
+    this->floats.reserve(n_present * (n_phase_scalars + this->n_phase_comps));
+  else {
+    this->floats.reserve(n_present * 4);
+    this->fixed.reserve(n_present * (n_phase_fracs + this->n_phase_comps));
+  }
+
+  size_t n_stored = 0;
+  for (const Phase& phase : result.phases) {
+    if (!is_present(phase)) {
+      this->slots.push_back(0);
+      continue;
+    }
+    this->slots.push_back(++n_stored);
+
+    if (encoding == ResultEncoding::float32) {
+      this->floats.push_back(phase.weight_frac);
+      this->floats.push_back(phase.volume_frac);
+      this->floats.push_back(phase.molar_frac);
+      this->floats.push_back(phase.n_moles);
+      this->floats.push_back(phase.density);
+      this->floats.insert(this->floats.end(),
+			  phase.composition_ratio.begin(),
+			  phase.composition_ratio.end());
+    } else {
+      double r_min = 0.0, r_max = 0.0;
+      if (!phase.composition_ratio.empty()) {
+	auto range = std::minmax_element(phase.composition_ratio.begin(),
+					 phase.composition_ratio.end());
+	r_min = *range.first;
+	r_max = *range.second;
+      }
+      // Round the offset and scale to floats first so that encoding and decoding
+      // use the same values.
+      const float offset = r_min;
+      const float scale = r_max - r_min;
+
+      this->floats.push_back(phase.n_moles);
+      this->floats.push_back(phase.density);
+      this->floats.push_back(offset);
+      this->floats.push_back(scale);
+
+      this->fixed.push_back(encode_fraction(phase.weight_frac));
+      this->fixed.push_back(encode_fraction(phase.volume_frac));
+      this->fixed.push_back(encode_fraction(phase.molar_frac));
+      for (double r : phase.composition_ratio)
+	this->fixed.push_back(encode_fixed(scale > 0 ? (r - offset) / scale : 0.0));
+    }
+  }
+}
+
+
+void
+ResultView::copy_to(MinimizeResult& out) const
+{
+  out.pressure = this->pressure();
+  out.temperature = this->temperature();
+  out.density = this->density();
+  out.expansivity = this->expansivity();
+  out.molar_entropy = this->molar_entropy();
+  out.molar_heat_capacity = this->molar_heat_capacity();
+  out.composition.assign(this->composition(), this->composition() + this->n_comps);
+
+  out.phases.resize(this->n_phases());
+  for (size_t p = 0; p < this->n_phases(); ++p) {
+    Phase& phase = out.phases[p];
+    const PhaseName& name = this->phase_name(p);
+
+    phase.id = this->phase_id(p);
+    phase.name.standard.assign(name.standard);
+    phase.name.abbreviated.assign(name.abbreviated);
+    phase.name.full.assign(name.full);
+    phase.weight_frac = this->phase_weight_frac(p);
+    phase.volume_frac = this->phase_volume_frac(p);
+    phase.molar_frac = this->phase_molar_frac(p);
+    phase.n_moles = this->phase_n_moles(p);
+    phase.density = this->phase_density(p);
+    phase.composition_ratio.resize(this->n_phase_comps);
+    for (size_t c = 0; c < this->n_phase_comps; ++c)
+      phase.composition_ratio[c] = this->phase_composition_ratio(p, c);
+  }
+}
+
+
+size_t
+ResultView::memory_footprint() const
+{
+  return sizeof(ResultView) +
+	 this->values.capacity() * sizeof(double) +
+	 this->phase_ids.capacity() * sizeof(size_t) +
+	 this->name_ids.capacity() * sizeof(size_t) +
+	 this->slots.capacity() * sizeof(std::uint16_t) +
+	 this->floats.capacity() * sizeof(float) +
+	 this->fixed.capacity() * sizeof(std::uint16_t);
+}
+
+
+double
+ResultView::decode(const size_t slot, const size_t i) const
+{
+  if (this->encoding == ResultEncoding::float32)
+    return this->floats[slot * (n_phase_scalars + this->n_phase_comps) + i];
+
+  const float* floats = this->floats.data() + slot * 4;
+  const std::uint16_t* fixed = 
+    this->fixed.data() + slot * (n_phase_fracs + this->n_phase_comps);
+
+  if (i < n_phase_fracs)
+    return fixed[i] / fixed_max;
+  else if (i < n_phase_scalars)
+    return floats[i - n_phase_fracs];
+  else
+    return floats[2] + floats[3] * (fixed[i - n_phase_scalars + n_phase_fracs] / fixed_max);
+}
+
+}  // namespace
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/shared_memory_cache.h>
+
+#include <cstdio>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * @return A descriptor of the shared memory object, which is created if it
+ *         does not exist.
+ */
+int
+open_shared_memory(const std::string& name)
+{
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    throw std::runtime_error("Could not open shared memory '" + name + "'.");
+  return fd;
+}
+
+}  // namespace
+
+
+SharedMemoryCache::SharedMemoryCache(const std::string& name,
+                                     const std::uint64_t problem_hash,
+				     const size_t n_components,
+				     const std::vector<PhaseName>& phase_names,
+				     const size_t n_slots)
+  : MappedCache(open_shared_memory(name), name, problem_hash, n_components,
+		phase_names, n_slots)
+{}
+
+
+std::string
+SharedMemoryCache::make_name(const std::uint64_t problem_hash)
+{
+  char name[64];
+  std::snprintf(name, sizeof(name), "/perplexcpp-%016llx",
+		static_cast<unsigned long long>(problem_hash));
+  return name;
+}
+
+
+void
+SharedMemoryCache::unlink(const std::string& name)
+{
+  shm_unlink(name.c_str());
+}
+
+}  // namespace
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/solver_stats.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * The percentiles reported by SolverStats.
+ */
+const double reported_quantiles[] = { 0.5, 0.99, 0.999 };
+const char* const reported_names[] = { "p50", "p99", "p999" };
+
+
+/**
+ * Write a line of the latency table (us).
+ */
+void
+write_text_row(std::ostream& os, const char* name, const LatencyHistogram& hist)
+{
+  os << "  " << std::left << std::setw(8) << name << std::right 
+     << std::setw(10) << hist.count()
+     << std::setw(12) << hist.mean() * 1e6;
+  for (double q : reported_quantiles)
+    os << std::setw(12) << hist.percentile(q) * 1e6;
+  os << std::setw(12) << hist.max() * 1e6 << "\n";
+}
+
+
+/**
+ * Write a histogram summary as a JSON object (s).
+ */
+void
+write_json_summary(std::ostream& os, const LatencyHistogram& hist)
+{
+  os << "{\"count\": " << hist.count() 
+     << ", \"mean\": " << hist.mean();
+  for (size_t i = 0; i < 3; ++i)
+    os << ", \"" << reported_names[i] << "\": " << hist.percentile(reported_quantiles[i]);
+  os << ", \"max\": " << hist.max() << "}";
+}
+
+/**
+ * Write a line of the hardware table, averaging the counts over n calls.
+ */
+void
+write_text_row(std::ostream& os, const char* name, const HardwareCounters& counts,
+	       const size_t n)
+{
+  const double scale = n == 0 ? 0.0 : 1.0 / n;
+  os << "  " << std::left << std::setw(8) << name << std::right 
+     << std::setw(16) << counts.cycles * scale
+     << std::setw(14) << counts.instructions * scale
+     << std::setw(8) << (counts.cycles == 0 ? 0.0 : 
+			 static_cast<double>(counts.instructions) / counts.cycles)
+     << std::setw(14) << counts.cache_misses * scale
+     << std::setw(14) << counts.branch_misses * scale << "\n";
+}
+
+
+/**
+ * Write hardware counts as a JSON object.
+ */
+void
+write_json_summary(std::ostream& os, const HardwareCounters& counts)
+{
+  os << "{\"cycles\": " << counts.cycles
+     << ", \"instructions\": " << counts.instructions
+     << ", \"cache_misses\": " << counts.cache_misses
+     << ", \"branch_misses\": " << counts.branch_misses << "}";
+}
+
+}  // namespace
+
+
+LatencyHistogram::LatencyHistogram()
+{
+  this->reset();
+}
+
+
+void
+LatencyHistogram::record(const double seconds)
+{
+  const double ns = std::round(seconds * 1e9);
+  const std::uint64_t value = 
+    ns <= 0.0 ? 0 : 
+    ns >= 1.8e19 ? std::numeric_limits<std::uint64_t>::max() : 
+    static_cast<std::uint64_t>(ns);
+
+  this->counts[bucket(value)]++;
+  this->n_values++;
+  this->sum_ns += value;
+  this->max_ns = std::max(this->max_ns, value);
+}
+
+
+void
+LatencyHistogram::merge(const LatencyHistogram& other)
+{
+  for (size_t i = 0; i < n_buckets; ++i)
+    this->counts[i] += other.counts[i];
+  this->n_values += other.n_values;
+  this->sum_ns += other.sum_ns;
+  this->max_ns = std::max(this->max_ns, other.max_ns);
+}
+
+
+void
+LatencyHistogram::reset()
+{
+  this->counts.fill(0);
+  this->n_values = 0;
+  this->sum_ns = 0.0;
+  this->max_ns = 0;
+}
+
+
+double
+LatencyHistogram::mean() const
+{
+  return this->n_values == 0 ? 0.0 : this->sum_ns / this->n_values * 1e-9;
+}
+
+
+double
+LatencyHistogram::percentile(const double q) const
+{
+  if (this->n_values == 0)
+    return 0.0;
+
+  // The rank of the value, counting from one.
+  const std::uint64_t rank = std::max<std::uint64_t>(1, 
+    static_cast<std::uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * this->n_values)));
+
+  std::uint64_t n_below = 0;
+  for (size_t i = 0; i < n_buckets; ++i) {
+    n_below += this->counts[i];
+    if (n_below >= rank)
+      return std::min(bucket_upper_bound(i), this->max_ns) * 1e-9;
+  }
+  return this->max();
+}
+
+
+size_t
+LatencyHistogram::bucket(const std::uint64_t ns)
+{
+  // Values below 2^sub_bucket_bits each have their own bucket.
+  if (ns < (1u << sub_bucket_bits))
+    return ns;
+
+  // Otherwise use the sub_bucket_bits bits below the leading one.
+  const size_t exponent = 63 - __builtin_clzll(ns);
+  const size_t sub_bucket = 
+    (ns >> (exponent - sub_bucket_bits)) & ((1u << sub_bucket_bits) - 1);
+  return ((exponent - sub_bucket_bits + 1) << sub_bucket_bits) + sub_bucket;
+}
+
+
+std::uint64_t
+LatencyHistogram::bucket_upper_bound(const size_t idx)
+{
+  if (idx < (1u << sub_bucket_bits))
+    return idx;
+
+  const size_t shift = (idx >> sub_bucket_bits) - 1;
+  const std::uint64_t sub_bucket = idx & ((1u << sub_bucket_bits) - 1);
+  const std::uint64_t lower = ((std::uint64_t(1) << sub_bucket_bits) + sub_bucket) << shift;
+  return lower + ((std::uint64_t(1) << shift) - 1);
+}
+
+
+
+void
+SolverStats::record(const SolveCounters& counters, const double seconds)
+{
+  this->n_calls++;
+  this->latency.record(seconds);
+
+  if (counters.cache_hit) {
+    this->n_cache_hits++;
+    this->hit_latency.record(seconds);
+    this->hit_hardware += counters.hardware;
+    return;
+  }
+
+  this->lp_iterations += counters.lp_iterations;
+  this->reopt_iterations += counters.reopt_iterations;
+  this->n_static_compounds += counters.n_static_compounds;
+  this->n_dynamic_compounds += counters.n_dynamic_compounds;
+  this->solve_latency.record(seconds);
+  this->solve_hardware += counters.hardware;
+}
+
+
+SolverStats&
+SolverStats::operator+=(const SolverStats& other)
+{
+  this->n_calls += other.n_calls;
+  this->n_cache_hits += other.n_cache_hits;
+  this->lp_iterations += other.lp_iterations;
+  this->reopt_iterations += other.reopt_iterations;
+  this->n_static_compounds += other.n_static_compounds;
+  this->n_dynamic_compounds += other.n_dynamic_compounds;
+  this->latency.merge(other.latency);
+  this->hit_latency.merge(other.hit_latency);
+  this->solve_latency.merge(other.solve_latency);
+  this->hit_hardware += other.hit_hardware;
+  this->solve_hardware += other.solve_hardware;
+  return *this;
+}
+
+
+std::string
+SolverStats::to_text() const
+{
+  std::ostringstream os;
+  const double hit_rate = this->n_calls == 0 ? 0.0 : 
+    100.0 * this->n_cache_hits / this->n_calls;
+
+  os << "calls                " << this->n_calls << "\n"
+     << "cache hits           " << this->n_cache_hits 
+     << " (" << std::fixed << std::setprecision(1) << hit_rate << "%)\n"
+     << "solves               " << this->n_solves() << "\n"
+     << "lp iterations        " << this->lp_iterations << "\n"
+     << "reopt iterations     " << this->reopt_iterations << "\n"
+     << "static compounds     " << this->n_static_compounds << "\n"
+     << "dynamic compounds    " << this->n_dynamic_compounds << "\n"
+     << "latency (us)" << std::setw(14) << "count" << std::setw(12) << "mean";
+  for (const char* name : reported_names)
+    os << std::setw(12) << name;
+  os << std::setw(12) << "max" << "\n";
+
+  os << std::setprecision(2);
+  write_text_row(os, "all", this->latency);
+  write_text_row(os, "hits", this->hit_latency);
+  write_text_row(os, "solves", this->solve_latency);
+
+  if (this->hit_hardware.cycles > 0 || this->solve_hardware.cycles > 0) {
+    os << "hardware (per call)" << std::setw(7) << "cycles" 
+       << std::setw(14) << "instructions" << std::setw(8) << "IPC"
+       << std::setw(14) << "cache misses" << std::setw(15) << "branch misses\n";
+    write_text_row(os, "hits", this->hit_hardware, this->n_cache_hits);
+    write_text_row(os, "solves", this->solve_hardware, this->n_solves());
+  }
+  return os.str();
+}
+
+
+std::string
+SolverStats::to_json() const
+{
+  std::ostringstream os;
+  os << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+  os << "{\"n_calls\": " << this->n_calls
+     << ", \"n_cache_hits\": " << this->n_cache_hits
+     << ", \"n_solves\": " << this->n_solves()
+     << ", \"lp_iterations\": " << this->lp_iterations
+     << ", \"reopt_iterations\": " << this->reopt_iterations
+     << ", \"n_static_compounds\": " << this->n_static_compounds
+     << ", \"n_dynamic_compounds\": " << this->n_dynamic_compounds
+     << ", \"latency\": ";
+  write_json_summary(os, this->latency);
+  os << ", \"hit_latency\": ";
+  write_json_summary(os, this->hit_latency);
+  os << ", \"solve_latency\": ";
+  write_json_summary(os, this->solve_latency);
+  os << ", \"hit_hardware\": ";
+  write_json_summary(os, this->hit_hardware);
+  os << ", \"solve_hardware\": ";
+  write_json_summary(os, this->solve_hardware);
+  os << "}";
+  return os.str();
+}
+
+}  // namespace
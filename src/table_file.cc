@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/table_file.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * The identifier at the start of a table file.
+ */
+const char magic[8] = "PXTABLE";
+
+
+/**
+ * The alignment of the arrays (bytes).
+ */
+const size_t alignment = 64;
+
+
+struct Header
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t n_axes;
+  char kind[32];
+  std::uint64_t problem_hash;
+  std::uint32_t n_arrays;
+  std::uint32_t reserved;
+  std::uint64_t file_size;
+};
+
+
+struct AxisRecord
+{
+  char name[32];
+  char units[16];
+  std::uint64_t size;
+  double min;
+  double max;
+};
+
+
+struct ArrayRecord
+{
+  char name[32];
+  char units[16];
+  std::uint32_t type;
+  std::uint32_t reserved;
+  std::uint64_t size;
+  std::uint64_t offset;
+};
+
+
+/**
+ * Throw an exception if a string does not fit in a field of the given size.
+ */
+void
+check_length(const std::string& value, const size_t size)
+{
+  if (value.size() >= size)
+    throw std::invalid_argument("'" + value + "' is too long for a table file");
+}
+
+
+/**
+ * Copy a string into a fixed size field.
+ */
+template <size_t N>
+void
+copy_field(char (&field)[N], const std::string& value)
+{
+  check_length(value, N);
+  std::memset(field, 0, N);
+  std::memcpy(field, value.data(), value.size());
+}
+
+
+/**
+ * @return The contents of a fixed size field.
+ */
+template <size_t N>
+std::string
+read_field(const char (&field)[N])
+{
+  return std::string(field, strnlen(field, N));
+}
+
+
+/**
+ * @return The size of an element of the given type.
+ */
+size_t
+element_size(const TableDataType type)
+{
+  switch (type) {
+    case TableDataType::float64:
+      return sizeof(double);
+    case TableDataType::uint32:
+      return sizeof(std::uint32_t);
+    case TableDataType::text:
+      return sizeof(char);
+  }
+  throw std::invalid_argument("Unknown table data type");
+}
+
+
+/**
+ * @return The offset rounded up to the alignment.
+ */
+size_t
+align(const size_t offset)
+{
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+
+TableWriter::TableWriter(const std::string& kind, const std::uint64_t problem_hash)
+  : kind(kind),
+    problem_hash(problem_hash)
+{
+  check_length(kind, sizeof(Header::kind));
+}
+
+
+void
+TableWriter::add_axis(const std::string& name,
+                      const std::string& units,
+		      const size_t size,
+		      const double min,
+		      const double max)
+{
+  check_length(name, sizeof(AxisRecord::name));
+  check_length(units, sizeof(AxisRecord::units));
+
+  this->axes.push_back(TableAxis { name, units, size, min, max });
+}
+
+
+void
+TableWriter::add_array(const std::string& name,
+                       const std::string& units,
+		       const double* data,
+		       const size_t size)
+{
+  this->add_array(name, units, TableDataType::float64, data, size);
+}
+
+
+void
+TableWriter::add_array(const std::string& name,
+                       const std::string& units,
+		       const std::uint32_t* data,
+		       const size_t size)
+{
+  this->add_array(name, units, TableDataType::uint32, data, size);
+}
+
+
+void
+TableWriter::add_strings(const std::string& name, const std::vector<std::string>& strings)
+{
+  std::unique_ptr<std::string> text(new std::string());
+  for (const std::string& s : strings) {
+    if (s.find('\0') != std::string::npos)
+      throw std::invalid_argument("The strings may not contain null characters");
+    text->append(s);
+    text->push_back('\0');
+  }
+
+  this->add_array(name, "", TableDataType::text, text->data(), text->size());
+  this->texts.push_back(std::move(text));
+}
+
+
+void
+TableWriter::add_array(const std::string& name,
+                       const std::string& units,
+		       const TableDataType type,
+		       const void* data,
+		       const size_t size)
+{
+  check_length(name, sizeof(ArrayRecord::name));
+  check_length(units, sizeof(ArrayRecord::units));
+
+  for (const TableArray& array : this->arrays)
+    if (array.name == name)
+      throw std::invalid_argument("The table already has an array named '" + name + "'");
+
+  this->arrays.push_back(TableArray { name, units, type, size, data });
+}
+
+
+void
+TableWriter::write(const std::string& filename) const
+{
+  std::vector<ArrayRecord> array_records(this->arrays.size());
+  size_t offset = align(sizeof(Header) + 
+			this->axes.size() * sizeof(AxisRecord) + 
+			this->arrays.size() * sizeof(ArrayRecord));
+  for (size_t i = 0; i < this->arrays.size(); ++i) {
+    const TableArray& array = this->arrays[i];
+    ArrayRecord& record = array_records[i];
+
+    copy_field(record.name, array.name);
+    copy_field(record.units, array.units);
+    record.type = static_cast<std::uint32_t>(array.type);
+    record.reserved = 0;
+    record.size = array.size;
+    record.offset = offset;
+    offset = align(offset + array.size * element_size(array.type));
+  }
+
+  Header header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = TableReader::version;
+  header.n_axes = this->axes.size();
+  copy_field(header.kind, this->kind);
+  header.problem_hash = this->problem_hash;
+  header.n_arrays = this->arrays.size();
+  header.reserved = 0;
+  header.file_size = offset;
+
+  const std::string tmp_filename = filename + ".tmp";
+  {
+    std::ofstream file(tmp_filename, std::ios::binary | std::ios::trunc);
+    if (!file)
+      throw std::runtime_error("Could not open '" + tmp_filename + "'.");
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const TableAxis& axis : this->axes) {
+      AxisRecord record;
+      copy_field(record.name, axis.name);
+      copy_field(record.units, axis.units);
+      record.size = axis.size;
+      record.min = axis.min;
+      record.max = axis.max;
+      file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    file.write(reinterpret_cast<const char*>(array_records.data()), 
+	       array_records.size() * sizeof(ArrayRecord));
+
+    const std::vector<char> padding(alignment, 0);
+    for (size_t i = 0; i < this->arrays.size(); ++i) {
+      const size_t position = file.tellp();
+      file.write(padding.data(), array_records[i].offset - position);
+      file.write(static_cast<const char*>(this->arrays[i].data),
+		 this->arrays[i].size * element_size(this->arrays[i].type));
+    }
+    const size_t position = file.tellp();
+    file.write(padding.data(), offset - position);
+
+    if (!file)
+      throw std::runtime_error("Could not write '" + tmp_filename + "'.");
+  }
+
+  if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    std::remove(tmp_filename.c_str());
+    throw std::runtime_error("Could not write '" + filename + "'.");
+  }
+}
+
+
+
+TableReader::TableReader(const std::string& filename, const std::string& kind)
+  : filename(filename)
+{
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Could not open '" + filename + "'.");
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("Could not stat '" + filename + "'.");
+  }
+  this->length = st.st_size;
+
+  if (this->length < sizeof(Header)) {
+    close(fd);
+    throw std::runtime_error("'" + filename + "' is not a table file.");
+  }
+
+  this->memory = mmap(nullptr, this->length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (this->memory == MAP_FAILED) {
+    this->memory = nullptr;
+    throw std::runtime_error("Could not map '" + filename + "'.");
+  }
+
+  try {
+    const unsigned char* bytes = static_cast<const unsigned char*>(this->memory);
+
+    Header header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+      throw std::runtime_error("'" + filename + "' is not a table file.");
+    if (header.version != version)
+      throw std::runtime_error("'" + filename + "' has unsupported version " 
+			       + std::to_string(header.version) + ".");
+    if (read_field(header.kind) != kind)
+      throw std::runtime_error("'" + filename + "' holds a " + read_field(header.kind) 
+			       + " rather than a " + kind + ".");
+    if (header.file_size != this->length ||
+	sizeof(Header) + header.n_axes * sizeof(AxisRecord) + 
+	header.n_arrays * sizeof(ArrayRecord) > this->length)
+      throw std::runtime_error("'" + filename + "' is truncated.");
+
+    this->problem_hash = header.problem_hash;
+
+    const unsigned char* position = bytes + sizeof(Header);
+    for (std::uint32_t i = 0; i < header.n_axes; ++i) {
+      AxisRecord record;
+      std::memcpy(&record, position, sizeof(record));
+      position += sizeof(record);
+
+      this->axes.push_back(TableAxis { 
+	read_field(record.name), read_field(record.units), 
+	static_cast<size_t>(record.size), record.min, record.max 
+      });
+    }
+
+    for (std::uint32_t i = 0; i < header.n_arrays; ++i) {
+      ArrayRecord record;
+      std::memcpy(&record, position, sizeof(record));
+      position += sizeof(record);
+
+      const TableDataType type = static_cast<TableDataType>(record.type);
+      if (record.offset % alignment != 0 || 
+	  record.offset + record.size * element_size(type) > this->length)
+	throw std::runtime_error("'" + filename + "' is corrupt.");
+
+      this->arrays.push_back(TableArray { 
+	read_field(record.name), read_field(record.units), type, 
+	static_cast<size_t>(record.size), bytes + record.offset
+      });
+    }
+  }
+  catch (...) {
+    munmap(this->memory, this->length);
+    throw;
+  }
+}
+
+
+TableReader::~TableReader()
+{
+  munmap(this->memory, this->length);
+}
+
+
+const TableAxis&
+TableReader::get_axis(const std::string& name) const
+{
+  for (const TableAxis& axis : this->axes)
+    if (axis.name == name)
+      return axis;
+  throw std::runtime_error("'" + this->filename + "' has no axis named '" + name + "'.");
+}
+
+
+const TableArray&
+TableReader::get_array(const std::string& name) const
+{
+  for (const TableArray& array : this->arrays)
+    if (array.name == name)
+      return array;
+  throw std::runtime_error("'" + this->filename + "' has no array named '" + name + "'.");
+}
+
+
+const TableArray&
+TableReader::get_array(const std::string& name,
+                       const TableDataType type,
+		       const size_t size) const
+{
+  const TableArray& array = this->get_array(name);
+  if (array.type != type || array.size != size)
+    throw std::runtime_error("The array '" + name + "' in '" + this->filename 
+			     + "' has the wrong type or size.");
+  return array;
+}
+
+
+std::vector<std::string>
+TableReader::get_strings(const std::string& name) const
+{
+  const TableArray& array = this->get_array(name);
+  if (array.type != TableDataType::text)
+    throw std::runtime_error("The array '" + name + "' in '" + this->filename 
+			     + "' is not a text array.");
+
+  const char* text = static_cast<const char*>(array.data);
+  if (array.size > 0 && text[array.size-1] != '\0')
+    throw std::runtime_error("The array '" + name + "' in '" + this->filename 
+			     + "' is not null-terminated.");
+
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < array.size; i += strings.back().size() + 1)
+    strings.emplace_back(text + i);
+  return strings;
+}
+
+}  // namespace
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "thermo_grid.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#include <perplexcpp/result_batch.h>
+#include <perplexcpp/thermo_table.h>
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * @return The lower case version of a string.
+ */
+std::string
+to_lower(std::string s)
+{
+  std::transform(s.begin(), s.end(), s.begin(), 
+		 [](unsigned char c) { return std::tolower(c); });
+  return s;
+}
+
+
+/**
+ * @return True if the phase should be counted as melt.
+ */
+bool
+is_melt(const PhaseName& name, const std::vector<std::string>& melt_phases)
+{
+  if (melt_phases.empty()) {
+    for (const std::string& s : { to_lower(name.standard), to_lower(name.full) })
+      if (s.find("melt") != std::string::npos || s.find("liq") != std::string::npos)
+	return true;
+    return false;
+  }
+
+  for (const std::string& melt : melt_phases)
+    if (melt == name.standard || melt == name.abbreviated)
+      return true;
+  return false;
+}
+
+}  // namespace
+
+
+const char* const thermo_property_names[n_thermo_properties] = {
+  "density", "expansivity", "molar_heat_capacity", "molar_entropy", "melt_fraction"
+};
+
+
+const char* const thermo_property_units[n_thermo_properties] = {
+  "kg/m3", "1/K", "J/K", "J/K", ""
+};
+
+
+std::vector<bool>
+find_melt_phases(const Wrapper& wrapper, const std::vector<std::string>& melt_phases)
+{
+  std::vector<bool> is_melt_phase;
+  for (const PhaseName& name : wrapper.phase_names)
+    is_melt_phase.push_back(is_melt(name, melt_phases));
+  return is_melt_phase;
+}
+
+
+void
+solve_thermo_properties(const Wrapper& wrapper,
+                        const std::vector<QueryPoint>& points,
+			const std::vector<bool>& is_melt_phase,
+			const unsigned int n_workers,
+			std::vector<double>& values,
+			std::vector<std::vector<bool>>* assemblages)
+{
+  const ResultBatch batch = minimize_batch(wrapper, points, n_workers);
+  if (batch.n_solved() != points.size())
+    throw std::runtime_error("Perple_X could not solve every point in the table.");
+
+  const size_t n_points = points.size();
+  values.resize(n_thermo_properties * n_points);
+
+  const double* const columns[] = {
+    batch.density(),
+    batch.expansivity(),
+    batch.molar_heat_capacity(),
+    batch.molar_entropy()
+  };
+  const size_t melt_idx = static_cast<size_t>(ThermoProperty::melt_fraction);
+  for (size_t k = 0; k < melt_idx; ++k)
+    std::copy_n(columns[k], n_points, values.begin() + k * n_points);
+
+  // The melt fraction is the sum of the weight fractions of the melt phases.
+  double* melt_fraction = values.data() + melt_idx * n_points;
+  std::fill_n(melt_fraction, n_points, 0.0);
+  for (size_t p = 0; p < batch.n_phases(); ++p)
+    if (is_melt_phase[p]) {
+      const double* weight_frac = batch.phase_weight_frac(p);
+      for (size_t i = 0; i < n_points; ++i)
+	melt_fraction[i] += weight_frac[i];
+    }
+
+  if (assemblages) {
+    assemblages->assign(n_points, std::vector<bool>(batch.n_phases(), false));
+    for (size_t p = 0; p < batch.n_phases(); ++p) {
+      const double* molar_frac = batch.phase_molar_frac(p);
+      for (size_t i = 0; i < n_points; ++i)
+	(*assemblages)[i][p] = molar_frac[i] > 0;
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _perplexcpp_thermo_grid_h
+#define _perplexcpp_thermo_grid_h
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/prewarm.h>
+#include <perplexcpp/thermo_table.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace perplexcpp
+{
+  /**
+   * The names of the ThermoProperty values as stored in table files.
+   */
+  extern const char* const thermo_property_names[n_thermo_properties];
+
+
+  /**
+   * The units of the ThermoProperty values as stored in table files.
+   */
+  extern const char* const thermo_property_units[n_thermo_properties];
+
+
+  /**
+   * @return For each phase, whether or not it is counted as melt.
+   *
+   * @param melt_phases The standard or abbreviated names of the melt phases. If
+   *                    empty any phase with "melt" or "liq" in its standard or
+   *                    full name is used.
+   */
+  std::vector<bool>
+  find_melt_phases(const Wrapper& wrapper, 
+                   const std::vector<std::string>& melt_phases);
+
+
+  /**
+   * Solve a set of points in parallel (see minimize_batch()) and compute the table
+   * properties at each. Throws an exception if any point could not be solved.
+   *
+   * @param is_melt_phase Whether or not each phase is counted as melt.
+   * @param values        Set to the properties. Property k of point i is stored
+   *                      at index k * points.size() + i.
+   * @param assemblages   If not null, set to whether or not each phase is
+   *                      present at each point.
+   */
+  void
+  solve_thermo_properties(const Wrapper& wrapper,
+                          const std::vector<QueryPoint>& points,
+			  const std::vector<bool>& is_melt_phase,
+			  const unsigned int n_workers,
+			  std::vector<double>& values,
+			  std::vector<std::vector<bool>>* assemblages=nullptr);
+}
+
+
+#endif
@@ -0,0 +1,502 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/thermo_table.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define PERPLEXCPP_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#include <perplexcpp/table_file.h>
+
+#include "thermo_grid.h"
+
+
+namespace perplexcpp
+{
+namespace
+{
+
+/**
+ * The kind of table recorded in table files.
+ */
+const char table_kind[] = "ThermoTable";
+
+
+/**
+ * @return The value limited to [0, 1]. Bicubic interpolation overshoots near
+ *         sharp changes such as the solidus, which could give impossible
+ *         fractions.
+ */
+inline double
+clamp_fraction(const double x)
+{
+  return std::min(std::max(x, 0.0), 1.0);
+}
+
+
+/**
+ * @return The Catmull-Rom weights for a position t within [0, 1].
+ */
+inline void
+catmull_rom_weights(const double t, double* w)
+{
+  const double t2 = t * t;
+  const double t3 = t2 * t;
+  w[0] = 0.5 * (-t3 + 2*t2 - t);
+  w[1] = 0.5 * (3*t3 - 5*t2 + 2);
+  w[2] = 0.5 * (-3*t3 + 4*t2 + t);
+  w[3] = 0.5 * (t3 - t2);
+}
+
+
+/**
+ * The number of doubles stored per grid point in the interleaved table. This is
+ * one 64 byte cache line.
+ */
+const size_t node_stride = 8;
+
+
+static_assert(n_thermo_properties <= node_stride, 
+	      "The properties at a grid point must fit in a cache line");
+
+
+/**
+ * Throw an exception if a pressure or temperature lies outside of the table.
+ * The negated comparisons also reject NaN.
+ */
+inline void
+check_in_table(const double value, 
+               const double min, 
+	       const double max, 
+	       const char* message)
+{
+  if (!(value >= min && value <= max))
+    throw std::invalid_argument(message);
+}
+
+
+#ifdef PERPLEXCPP_HAVE_AVX2
+/**
+ * The interleaved table and the mapping from pressure and temperature to grid
+ * coordinates used by the bilinear batch kernels.
+ */
+struct BilinearGrid
+{
+  const double* nodes;
+  size_t n_temperatures;
+  double min_pressure;
+  double min_temperature;
+  double pressure_scale;
+  double temperature_scale;
+  size_t max_i;
+  size_t max_j;
+};
+
+
+/**
+ * Interpolate points [begin, end) of a batch one at a time.
+ */
+void
+interpolate_bilinear_scalar(const BilinearGrid& grid,
+                            const size_t begin,
+			    const size_t end,
+			    const double* pressures,
+			    const double* temperatures,
+			    double* const out[n_thermo_properties])
+{
+  for (size_t n = begin; n < end; ++n) {
+    const double x = (pressures[n] - grid.min_pressure) * grid.pressure_scale;
+    const double y = (temperatures[n] - grid.min_temperature) * grid.temperature_scale;
+    const size_t i = std::min(static_cast<size_t>(x), grid.max_i);
+    const size_t j = std::min(static_cast<size_t>(y), grid.max_j);
+    const double u = x - i;
+    const double v = y - j;
+
+    const double* n00 = grid.nodes + (i * grid.n_temperatures + j) * node_stride;
+    const double* n01 = n00 + node_stride;
+    const double* n10 = n00 + grid.n_temperatures * node_stride;
+    const double* n11 = n10 + node_stride;
+    for (size_t k = 0; k < n_thermo_properties; ++k) {
+      if (!out[k])
+	continue;
+      const double low = n00[k] + v * (n01[k] - n00[k]);
+      const double high = n10[k] + v * (n11[k] - n10[k]);
+      out[k][n] = low + u * (high - low);
+    }
+  }
+
+  const size_t melt = static_cast<size_t>(ThermoProperty::melt_fraction);
+  if (out[melt])
+    for (size_t n = begin; n < end; ++n)
+      out[melt][n] = clamp_fraction(out[melt][n]);
+}
+
+
+/**
+ * @return The four doubles at base[idx]. The masked gather with a zero source is
+ *         used because the unmasked form leaves its source uninitialized.
+ */
+__attribute__((target("avx2,fma")))
+inline __m256d
+gather(const double* base, const __m128i idx)
+{
+  const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, idx, all, 8);
+}
+
+
+/**
+ * Interpolate a batch four points at a time using AVX2 gathers.
+ */
+__attribute__((target("avx2,fma")))
+void
+interpolate_bilinear_avx2(const BilinearGrid& grid,
+                          const size_t n,
+			  const double* pressures,
+			  const double* temperatures,
+			  double* const out[n_thermo_properties])
+{
+  const __m256d min_pressure = _mm256_set1_pd(grid.min_pressure);
+  const __m256d min_temperature = _mm256_set1_pd(grid.min_temperature);
+  const __m256d pressure_scale = _mm256_set1_pd(grid.pressure_scale);
+  const __m256d temperature_scale = _mm256_set1_pd(grid.temperature_scale);
+  const __m128i max_i = _mm_set1_epi32(grid.max_i);
+  const __m128i max_j = _mm_set1_epi32(grid.max_j);
+  const __m128i n_temperatures = _mm_set1_epi32(grid.n_temperatures);
+  const __m128i next_j = _mm_set1_epi32(node_stride);
+  const __m128i next_i = _mm_set1_epi32(grid.n_temperatures * node_stride);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d one = _mm256_set1_pd(1.0);
+
+  size_t begin = 0;
+  for (; begin + 4 <= n; begin += 4) {
+    const __m256d x = _mm256_mul_pd(
+      _mm256_sub_pd(_mm256_loadu_pd(pressures + begin), min_pressure), pressure_scale);
+    const __m256d y = _mm256_mul_pd(
+      _mm256_sub_pd(_mm256_loadu_pd(temperatures + begin), min_temperature), 
+      temperature_scale);
+
+    // Points on the upper boundaries belong to the last cell.
+    const __m128i i = _mm_min_epi32(_mm256_cvttpd_epi32(x), max_i);
+    const __m128i j = _mm_min_epi32(_mm256_cvttpd_epi32(y), max_j);
+    const __m256d u = _mm256_sub_pd(x, _mm256_cvtepi32_pd(i));
+    const __m256d v = _mm256_sub_pd(y, _mm256_cvtepi32_pd(j));
+
+    const __m128i idx00 = _mm_mullo_epi32(
+      _mm_add_epi32(_mm_mullo_epi32(i, n_temperatures), j), next_j);
+    const __m128i idx01 = _mm_add_epi32(idx00, next_j);
+    const __m128i idx10 = _mm_add_epi32(idx00, next_i);
+    const __m128i idx11 = _mm_add_epi32(idx10, next_j);
+
+    for (size_t k = 0; k < n_thermo_properties; ++k) {
+      if (!out[k])
+	continue;
+      const double* base = grid.nodes + k;
+      const __m256d v00 = gather(base, idx00);
+      const __m256d v01 = gather(base, idx01);
+      const __m256d v10 = gather(base, idx10);
+      const __m256d v11 = gather(base, idx11);
+
+      const __m256d low = _mm256_fmadd_pd(v, _mm256_sub_pd(v01, v00), v00);
+      const __m256d high = _mm256_fmadd_pd(v, _mm256_sub_pd(v11, v10), v10);
+      __m256d result = _mm256_fmadd_pd(u, _mm256_sub_pd(high, low), low);
+      if (k == static_cast<size_t>(ThermoProperty::melt_fraction))
+	result = _mm256_min_pd(_mm256_max_pd(result, zero), one);
+      _mm256_storeu_pd(out[k] + begin, result);
+    }
+  }
+
+  interpolate_bilinear_scalar(grid, begin, n, pressures, temperatures, out);
+}
+
+
+/**
+ * @return True if the CPU supports the AVX2 kernel.
+ */
+bool
+cpu_has_avx2()
+{
+  static const bool result = 
+    __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  return result;
+}
+#endif
+
+}  // namespace
+
+
+ThermoTable::ThermoTable(const Wrapper& wrapper,
+                         const size_t n_pressures,
+			 const size_t n_temperatures,
+			 const std::vector<double>& composition,
+			 const std::vector<std::string>& melt_phases,
+			 const unsigned int n_workers)
+  : problem_hash(wrapper.problem_file_hash),
+    n_pressures(n_pressures),
+    n_temperatures(n_temperatures),
+    min_pressure(wrapper.min_pressure),
+    max_pressure(wrapper.max_pressure),
+    min_temperature(wrapper.min_temperature),
+    max_temperature(wrapper.max_temperature),
+    composition(composition.empty() ? wrapper.initial_bulk_composition : composition),
+    nodes_once(new std::once_flag)
+{
+  if (n_pressures < 2 || n_temperatures < 2)
+    throw std::invalid_argument("The table must have at least two points along each axis");
+
+  const std::vector<QueryPoint> points = 
+    make_query_grid(this->min_pressure, this->max_pressure, n_pressures,
+		    this->min_temperature, this->max_temperature, n_temperatures,
+		    this->composition);
+
+  solve_thermo_properties(wrapper, points, find_melt_phases(wrapper, melt_phases), 
+			  n_workers, this->values);
+
+  for (size_t k = 0; k < n_thermo_properties; ++k)
+    this->columns[k] = this->values.data() + k * points.size();
+}
+
+
+ThermoTable::ThermoTable(const std::shared_ptr<const TableReader>& file,
+                         const TableAxis& pressures,
+			 const TableAxis& temperatures,
+			 const std::vector<double>& composition)
+  : problem_hash(file->get_problem_hash()),
+    n_pressures(pressures.size),
+    n_temperatures(temperatures.size),
+    min_pressure(pressures.min),
+    max_pressure(pressures.max),
+    min_temperature(temperatures.min),
+    max_temperature(temperatures.max),
+    composition(composition),
+    file(file),
+    nodes_once(new std::once_flag)
+{
+  if (n_pressures < 2 || n_temperatures < 2)
+    throw std::runtime_error("The table must have at least two points along each axis.");
+
+  for (size_t k = 0; k < n_thermo_properties; ++k)
+    this->columns[k] = file->get_doubles(thermo_property_names[k], 
+					 n_pressures * n_temperatures);
+}
+
+
+ThermoTable
+ThermoTable::load(const std::string& filename)
+{
+  const std::shared_ptr<const TableReader> file = 
+    std::make_shared<const TableReader>(filename, table_kind);
+
+  const TableArray& composition = file->get_array("composition");
+  const double* c = file->get_doubles("composition", composition.size);
+
+  return ThermoTable(file, file->get_axis("pressure"), file->get_axis("temperature"),
+		     std::vector<double>(c, c + composition.size));
+}
+
+
+void
+ThermoTable::save(const std::string& filename) const
+{
+  TableWriter writer(table_kind, this->problem_hash);
+  writer.add_axis("pressure", "Pa", this->n_pressures, 
+		  this->min_pressure, this->max_pressure);
+  writer.add_axis("temperature", "K", this->n_temperatures, 
+		  this->min_temperature, this->max_temperature);
+  writer.add_array("composition", "", this->composition.data(), this->composition.size());
+  for (size_t k = 0; k < n_thermo_properties; ++k)
+    writer.add_array(thermo_property_names[k], thermo_property_units[k],
+		     this->columns[k], this->n_pressures * this->n_temperatures);
+  writer.write(filename);
+}
+
+
+double
+ThermoTable::interpolate(const ThermoProperty property,
+                         const double pressure,
+			 const double temperature) const
+{
+  size_t i, j;
+  double u, v;
+  this->locate(pressure, temperature, i, j, u, v);
+
+  const double value = this->interpolate(this->column(property), i, j, u, v);
+  return property == ThermoProperty::melt_fraction ? clamp_fraction(value) : value;
+}
+
+
+ThermoProperties
+ThermoTable::interpolate(const double pressure, const double temperature) const
+{
+  size_t i, j;
+  double u, v;
+  this->locate(pressure, temperature, i, j, u, v);
+
+  return ThermoProperties {
+    this->interpolate(this->column(ThermoProperty::density), i, j, u, v),
+    this->interpolate(this->column(ThermoProperty::expansivity), i, j, u, v),
+    this->interpolate(this->column(ThermoProperty::molar_heat_capacity), i, j, u, v),
+    this->interpolate(this->column(ThermoProperty::molar_entropy), i, j, u, v),
+    clamp_fraction(this->interpolate(this->column(ThermoProperty::melt_fraction), 
+				     i, j, u, v))
+  };
+}
+
+
+void
+ThermoTable::interpolate(const size_t n,
+                         const double* pressures,
+			 const double* temperatures,
+			 double* const out[n_thermo_properties]) const
+{
+  for (size_t p = 0; p < n; ++p) {
+    check_in_table(pressures[p], this->min_pressure, this->max_pressure, 
+		   "The pressure lies outside of the table");
+    check_in_table(temperatures[p], this->min_temperature, this->max_temperature, 
+		   "The temperature lies outside of the table");
+  }
+
+#ifdef PERPLEXCPP_HAVE_AVX2
+  // The gathers use 32-bit indices.
+  const size_t n_nodes = (this->n_pressures * this->n_temperatures + 1) * node_stride;
+  if (this->interpolation == Interpolation::bilinear && cpu_has_avx2() &&
+      n_nodes < static_cast<size_t>(std::numeric_limits<std::int32_t>::max())) {
+    const BilinearGrid grid {
+      this->interleave(),
+      this->n_temperatures,
+      this->min_pressure,
+      this->min_temperature,
+      (this->n_pressures - 1) / (this->max_pressure - this->min_pressure),
+      (this->n_temperatures - 1) / (this->max_temperature - this->min_temperature),
+      this->n_pressures - 2,
+      this->n_temperatures - 2
+    };
+    interpolate_bilinear_avx2(grid, n, pressures, temperatures, out);
+    return;
+  }
+#endif
+
+  // Otherwise read the property columns, locating each point only once.
+  const size_t melt = static_cast<size_t>(ThermoProperty::melt_fraction);
+  for (size_t p = 0; p < n; ++p) {
+    size_t i, j;
+    double u, v;
+    this->locate(pressures[p], temperatures[p], i, j, u, v);
+    for (size_t k = 0; k < n_thermo_properties; ++k)
+      if (out[k]) {
+	const double value = this->interpolate(this->columns[k], i, j, u, v);
+	out[k][p] = k == melt ? clamp_fraction(value) : value;
+      }
+  }
+}
+
+
+const double*
+ThermoTable::interleave() const
+{
+  std::call_once(*this->nodes_once, [this]() {
+    const size_t n_points = this->n_pressures * this->n_temperatures;
+
+    // Allocate an extra cache line so that the first grid point can be aligned.
+    this->nodes.assign(n_points * node_stride + node_stride, 0.0);
+    const size_t misalignment = 
+      reinterpret_cast<std::uintptr_t>(this->nodes.data()) % (node_stride * sizeof(double));
+    this->node_offset = misalignment == 0 ? 0 : 
+			node_stride - misalignment / sizeof(double);
+
+    double* nodes = this->nodes.data() + this->node_offset;
+    for (size_t p = 0; p < n_points; ++p)
+      for (size_t k = 0; k < n_thermo_properties; ++k)
+	nodes[p * node_stride + k] = this->columns[k][p];
+  });
+  return this->nodes.data() + this->node_offset;
+}
+
+
+void
+ThermoTable::locate(const double pressure,
+                    const double temperature,
+		    size_t& i,
+		    size_t& j,
+		    double& u,
+		    double& v) const
+{
+  check_in_table(pressure, this->min_pressure, this->max_pressure, 
+		 "The pressure lies outside of the table");
+  check_in_table(temperature, this->min_temperature, this->max_temperature, 
+		 "The temperature lies outside of the table");
+
+  const double x = (pressure - this->min_pressure) / 
+		   (this->max_pressure - this->min_pressure) * (this->n_pressures - 1);
+  const double y = (temperature - this->min_temperature) / 
+		   (this->max_temperature - this->min_temperature) * (this->n_temperatures - 1);
+
+  // Points on the upper boundaries belong to the last cell.
+  i = std::min(static_cast<size_t>(x), this->n_pressures - 2);
+  j = std::min(static_cast<size_t>(y), this->n_temperatures - 2);
+  u = x - i;
+  v = y - j;
+}
+
+
+double
+ThermoTable::interpolate(const double* column,
+                         const size_t i,
+			 const size_t j,
+			 const double u,
+			 const double v) const
+{
+  const size_t n_t = this->n_temperatures;
+
+  if (this->interpolation == Interpolation::bilinear) {
+    const double* row0 = column + i * n_t + j;
+    const double* row1 = row0 + n_t;
+    return (1-u) * ((1-v) * row0[0] + v * row0[1]) + 
+	   u * ((1-v) * row1[0] + v * row1[1]);
+  }
+
+  double wu[4], wv[4];
+  catmull_rom_weights(u, wu);
+  catmull_rom_weights(v, wv);
+
+  // Points beyond the edges of the table are clamped to the edge.
+  double result = 0.0;
+  for (int a = 0; a < 4; ++a) {
+    const long ii = std::min<long>(std::max<long>(long(i) + a - 1, 0), this->n_pressures - 1);
+    const double* row = column + ii * n_t;
+
+    double row_value = 0.0;
+    for (int b = 0; b < 4; ++b) {
+      const long jj = std::min<long>(std::max<long>(long(j) + b - 1, 0), n_t - 1);
+      row_value += wv[b] * row[jj];
+    }
+    result += wu[a] * row_value;
+  }
+  return result;
+}
+
+}  // namespace
@@ -20,8 +20,11 @@
 
 #include <perplexcpp/utils.h>
 
+#include <cmath>
 #include <cstdio>
 #include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
 #include <unistd.h>
 
 
@@ -67,5 +70,33 @@ namespace perplexcpp
       dup2(stdout_descriptor, 1);
       close(stdout_descriptor);
     }
+
+
+    std::uint64_t hash_file(const std::string& filename)
+    {
+      std::ifstream file(filename, std::ios::binary);
+      if (!file)
+	throw std::runtime_error("Could not open '" + filename + "'.");
+
+      std::uint64_t hash = 14695981039346656037ULL;
+      char buffer[4096];
+      while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+	for (std::streamsize i = 0; i < file.gcount(); ++i) {
+	  hash ^= static_cast<unsigned char>(buffer[i]);
+	  hash *= 1099511628211ULL;
+	}
+      }
+      return hash;
+    }
+
+
+    bool is_near_enough(const double x, const double y, const double rtol)
+    {
+      // If x is zero then return true if y is negligible.
+      if (x == 0)
+	return y < 1e-8;
+      else
+	return std::abs(x - y) / x <= rtol;
+    }
   }
 }
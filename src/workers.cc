@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "workers.h"
+
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+
+namespace perplexcpp
+{
+
+void
+run_workers(const size_t n_workers,
+	    const std::function<void(size_t worker, size_t n_workers)>& work)
+{
+  std::vector<pid_t> pids;
+  bool forked = true;
+  for (size_t w = 0; w < n_workers; ++w) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      // The worker must not run any exit handlers belonging to the parent.
+      int status = 0;
+      try {
+	work(w, n_workers);
+      }
+      catch (...) {
+	status = 1;
+      }
+      _exit(status);
+    }
+    else if (pid < 0) {
+      // Wait for the workers already started before reporting the failure.
+      forked = false;
+      break;
+    }
+    pids.push_back(pid);
+  }
+
+  bool failed = false;
+  for (pid_t pid : pids) {
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      failed = true;
+  }
+  if (!forked)
+    throw std::runtime_error("Could not fork a worker process.");
+  if (failed)
+    throw std::runtime_error("A worker process failed.");
+}
+
+}  // namespace
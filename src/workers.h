@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _perplexcpp_workers_h
+#define _perplexcpp_workers_h
+
+
+#include <cstddef>
+#include <functional>
+
+
+namespace perplexcpp
+{
+  /**
+   * Run a function in a number of forked worker processes and wait for them to
+   * finish. Each worker is passed its index and the number of workers. Throws an
+   * exception if any worker fails or cannot be forked. The work is never run in
+   * the calling process, so its state (e.g. the wrapper's cache) is unchanged.
+   *
+   * Perple_X cannot be used from multiple threads so this is how points are
+   * solved in parallel; results must be returned through shared memory.
+   */
+  void
+  run_workers(const size_t n_workers,
+	      const std::function<void(size_t worker, size_t n_workers)>& work);
+}
+
+
+#endif
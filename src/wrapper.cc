@@ -21,14 +21,17 @@
 #include <perplexcpp/wrapper.h>
 
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 #include <unistd.h>
 
 #include <perplexcpp/base.h>
+#include <perplexcpp/query_trace.h>
 #include <perplexcpp/utils.h>
 
 #include "f2c.h"
+#include "perf_counters.h"
 
 
 namespace perplexcpp
@@ -64,102 +67,69 @@ std::vector<PhaseName> get_phase_names()
 
 
 /**
- * @param end_phase_index The index for the phase for the result phase array.
- *
- * @return The phase composition.
+ * The number of system properties exported by f2c::res_props_export.
  */
-std::vector<double> make_endmember_composition_ratio(const size_t endmember_idx)
-{
-  std::vector<double> comp_ratio;
-  for (size_t c = 0; c < f2c::composition_props_get_n_components(); ++c)
-    comp_ratio.push_back(f2c::get_endmember_composition_ratio(endmember_idx, c));
-  return comp_ratio;
-}
+const size_t n_exported_sys_props = 4;
 
 
 /**
- * Find the phase index for a given phase name.
- *
- * @param phase_name The phase name.
- *
- * @return The corresponding phase index.
+ * The number of properties exported per result phase before its composition
+ * ratio by f2c::res_props_export.
  */
-size_t find_phase_index_from_name(const std::string& phase_name)
-{
-  for (size_t i = 0; i < f2c::soln_phase_props_get_n(); ++i) {
-    if (phase_name == get_phase_name(i).standard ||
-	phase_name == get_phase_name(i).abbreviated || 
-	phase_name == get_phase_name(i).full) {
-      return i;
-    }
-  }
-  throw std::invalid_argument("The phase name '" +
-			      phase_name +
-			      "' was not found among the solution models.");
-}
+const size_t n_exported_phase_props = 5;
 
 
 /**
- * @return A map mapping the phase index in the solution array in Perple_X (key)
- *         with the phase index in the result array (value).
+ * The longest result phase name (including the terminating null).
  */
-std::unordered_map<size_t,size_t> get_phase_index_mapping()
+const size_t max_res_phase_name_length = 15;
+
+
+/**
+ * The number of Perple_X stage timers (see f2c::solver_get_times).
+ */
+const size_t n_stage_timers = 30;
+
+
+/**
+ * The number of Perple_X work counters (see f2c::solver_get_counters).
+ */
+const size_t n_work_counters = 4;
+
+
+/**
+ * @return The time elapsed since start (s).
+ */
+double
+seconds_since(const std::chrono::steady_clock::time_point start)
 {
-  std::unordered_map<size_t,size_t> idx_map;
-
-  for (size_t i = 0; i < f2c::res_phase_props_get_n(); ++i) {
-    std::string phase_name = f2c::res_phase_props_get_name(i);
-
-    // If the Perple_X models are poorly suited to the problem at hand they may
-    // sometimes return phases that are not among the solution models (e.g. faTL).
-    // These phases are often present in extremely small amounts and so can be
-    // disregarded. However, if you are seeing lots of error messages or if the 
-    // fraction of material that is unrecognised is large it implies
-    // that you need to edit your parameter files.
-    try {
-      idx_map.emplace(find_phase_index_from_name(phase_name), i);
-    } 
-    catch (const std::invalid_argument& e) {
-      std::cerr << e.what() << std::endl
-		<< phase_name << " constitutes " << f2c::res_phase_props_get_mol_frac(i)*100
-		<< "\% of the end phases. If this number is large you may need to "
-		<< "edit your Perple_X problem definition file." << std::endl;
-    }
-  }
-  return idx_map;
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
 }
 
-std::vector<Phase> get_phases()
+
+/**
+ * @return The hardware counts of the calling thread, or zeros if counting is
+ *         disabled.
+ */
+HardwareCounters
+read_hardware(const bool enabled)
 {
-  std::vector<Phase> phases;
-
-  auto map = get_phase_index_mapping();
-  for (size_t i = 0; i < f2c::soln_phase_props_get_n(); ++i) {
-    Phase phase = { 
-      i,  // id
-      get_phase_name(i),  // name
-      0.0,  // weight_frac
-      0.0,  // volume_frac
-      0.0,  // molar_frac
-      0.0,  // n_moles  
-      std::vector<double>(f2c::composition_props_get_n_components(), 0.0),  // composition_ratio
-      0.0,  // density
-    };
+  return enabled ? perf::read() : HardwareCounters();
+}
 
-    // Check to see if the solution phase is present in the end phases.
-    // If they are then load the quantities.
-    if (map.find(i) != map.end()) {
-      phase.weight_frac = f2c::res_phase_props_get_weight_frac(map[i]);
-      phase.volume_frac = f2c::res_phase_props_get_vol_frac(map[i]);
-      phase.molar_frac = f2c::res_phase_props_get_mol_frac(map[i]);
-      phase.n_moles = f2c::res_phase_props_get_mol(map[i]);
-      phase.composition_ratio = make_endmember_composition_ratio(map[i]);
-      phase.density = f2c::get_endmember_density(map[i]);
-    }
 
-    phases.push_back(phase);
-  }
-  return phases;
+/**
+ * @return The hardware counts accumulated by Perple_X stage timers since the
+ *         stages were last reset.
+ */
+HardwareCounters
+get_stage_hardware(const size_t first_timer, const size_t second_timer=0)
+{
+  HardwareCounters counts = perf::get_stage(first_timer);
+  if (second_timer > 0)
+    counts += perf::get_stage(second_timer);
+  return counts;
 }
 
 }  // namespace
@@ -170,6 +140,11 @@ std::vector<Phase> get_phases()
 			   const size_t cache_capacity,
 			   const double cache_rtol)
   {
+    // Hash the problem file before changing directory so that a missing file
+    // does not leave the working directory changed.
+    const std::uint64_t hash = utils::hash_file(
+      problem_file[0] == '/' ? problem_file : working_dir + "/" + problem_file);
+
     // Save the current working directory.
     char initial_dir[256];
     if (getcwd(initial_dir, sizeof(initial_dir)) == NULL)
@@ -200,6 +175,8 @@ std::vector<Phase> get_phases()
       throw std::invalid_argument("Could not change directory.");
 
 
+    Wrapper::problem_hash = hash;
+
     // Save cache properties.
     Wrapper::cache_capacity = cache_capacity;
     Wrapper::cache_rtol = cache_rtol;
@@ -223,6 +200,132 @@ std::vector<Phase> get_phases()
   Wrapper::minimize(const double pressure, 
                     const double temperature,
 		    const std::vector<double>& composition) const
+  {
+    MinimizeResult result;
+    this->minimize_into(pressure, temperature, composition, result);
+    return result;
+  }
+
+
+  void
+  Wrapper::minimize_into(const double pressure,
+                         const double temperature,
+			 const DoubleSpan composition,
+			 MinimizeResult& out) const
+  {
+    this->check_arguments(pressure, temperature, composition);
+
+    const auto start = std::chrono::steady_clock::now();
+    const HardwareCounters hardware_start = read_hardware(this->hardware_counting);
+
+    // Before doing the calculation first check to see if the result is in the cache.
+    if (this->cache.capacity > 0 || this->cache_backend) {
+      this->query_composition.assign(composition.begin(), composition.end());
+
+      if ((this->cache.capacity > 0 &&
+	   this->cache.get(pressure, temperature, this->query_composition, out) == 0) ||
+	  (this->cache_backend &&
+	   this->cache_backend->get(pressure, temperature, this->query_composition, out) == 0)) {
+	// Cached results were not timed and did no work.
+	this->last_profile = SolveProfile();
+	this->last_counters = SolveCounters();
+	this->last_counters.cache_hit = true;
+	this->last_counters.hardware = read_hardware(this->hardware_counting);
+	this->last_counters.hardware -= hardware_start;
+	this->record(pressure, temperature, composition, this->last_counters, 
+		     seconds_since(start));
+	return;
+      }
+    }
+
+    const auto solve_start = std::chrono::steady_clock::now();
+
+    this->compute(pressure, temperature, composition, out);
+
+    const double solve_time = seconds_since(solve_start);
+
+    // Add this result to the cache for potential future lookups.
+    if (this->cache.capacity > 0)
+      this->cache.put(out, solve_time);
+
+    if (this->cache_backend)
+      this->cache_backend->put(out);
+
+    this->last_counters.hardware = read_hardware(this->hardware_counting);
+    this->last_counters.hardware -= hardware_start;
+    this->record(pressure, temperature, composition, this->last_counters, 
+		 seconds_since(start));
+  }
+
+
+  void
+  Wrapper::minimize_into(const double pressure,
+                         const double temperature,
+			 MinimizeResult& out) const
+  {
+    this->minimize_into(pressure, temperature, this->initial_bulk_composition, out);
+  }
+
+
+  MinimizeResult 
+  Wrapper::solve(const double pressure, 
+                 const double temperature,
+		 const std::vector<double>& composition) const
+  {
+    this->check_arguments(pressure, temperature, composition);
+
+    const auto start = std::chrono::steady_clock::now();
+    const HardwareCounters hardware_start = read_hardware(this->hardware_counting);
+
+    MinimizeResult result;
+    this->compute(pressure, temperature, composition, result);
+
+    this->last_counters.hardware = read_hardware(this->hardware_counting);
+    this->last_counters.hardware -= hardware_start;
+    this->stats.record(this->last_counters, seconds_since(start));
+    return result;
+  }
+
+
+  void
+  Wrapper::set_profiling(const bool enabled)
+  {
+    this->profiling = enabled;
+    f2c::solver_set_profiling(this->profiling || this->hardware_counting);
+  }
+
+
+  void
+  Wrapper::set_hardware_counting(const bool enabled)
+  {
+    if (enabled && !perf::open())
+      throw std::runtime_error("Could not open the hardware performance counters.");
+    else if (!enabled)
+      perf::close();
+
+    this->hardware_counting = enabled;
+    f2c::solver_set_profiling(this->profiling || this->hardware_counting);
+  }
+
+
+  void
+  Wrapper::reset_profile()
+  {
+    this->profile = SolveProfile();
+  }
+
+
+  void
+  Wrapper::reset_stats()
+  {
+    this->stats = SolverStats();
+  }
+
+
+  void
+  Wrapper::check_arguments(const double pressure, 
+                           const double temperature,
+			   const DoubleSpan composition) const
   {
     if (pressure < this->min_pressure)
       throw std::invalid_argument("The pressure is too low");
@@ -248,21 +351,30 @@ std::vector<Phase> get_phases()
       if (sum < 1e-8)
 	throw std::invalid_argument("The composition cannot be all zeroes");
     }
+  }
 
-    // Before doing the calculation first check to see if the result is in the cache.
-    if (this->cache.capacity > 0)
-    {
-      MinimizeResult result;
-      if (this->cache.get(pressure, temperature, composition, result) == 0)
-	return result;
-    }
 
+  void
+  Wrapper::compute(const double pressure, 
+                   const double temperature,
+		   const DoubleSpan composition,
+		   MinimizeResult& out) const
+  {
     for (size_t i = 0; i < n_composition_components; ++i)
       f2c::bulk_props_set_composition(i, composition[i]);
 
     f2c::solver_set_pressure(utils::convert_pascals_to_bar(pressure));
     f2c::solver_set_temperature(temperature);
 
+    const bool is_timed = this->profiling || this->hardware_counting;
+    if (is_timed) {
+      // Perple_X resets its options when a problem is read.
+      f2c::solver_set_profiling(true);
+      f2c::solver_reset_times();
+      perf::reset_stages();
+    }
+    f2c::solver_reset_counters();
+
 #ifndef ALLOW_PERPLEX_OUTPUT
     // Disable stdout to prevent Perple_X dominating stdout.
     const int fd = utils::disable_stdout();
@@ -274,22 +386,104 @@ std::vector<Phase> get_phases()
     utils::enable_stdout(fd);
 #endif
 
-    const MinimizeResult result {
-      pressure,  // pressure
-      temperature,  // temperature
-      composition,  // composition
-      get_phases(),  // phases
-      f2c::sys_props_get_density(),  // density
-      f2c::sys_props_get_expansivity(),  // expansivity
-      f2c::sys_props_get_mol_entropy(),  // molar_entropy
-      f2c::sys_props_get_mol_heat_capacity()  // molar_heat_capacity
-    };
+    out.pressure = pressure;
+    out.temperature = temperature;
+    out.composition.assign(composition.begin(), composition.end());
+    this->read_result(out);
+
+    int counters[n_work_counters];
+    f2c::solver_get_counters(counters);
+
+    this->last_counters.lp_iterations = counters[0];
+    this->last_counters.reopt_iterations = counters[1];
+    this->last_counters.n_static_compounds = counters[2];
+    this->last_counters.n_dynamic_compounds = counters[3];
+    this->last_counters.cache_hit = false;
+
+    this->last_profile = SolveProfile();
+    if (is_timed) {
+      double times[n_stage_timers];
+      f2c::solver_get_times(times);
+
+      this->last_profile.n_solves = 1;
+      this->last_profile.static_g_time = times[0];
+      this->last_profile.static_lp_time = times[1];
+      this->last_profile.resub_time = times[4] + times[5];
+      this->last_profile.dynamic_lp_time = times[7];
+      this->last_profile.getloc_time = times[8];
+      this->last_profile.total_time = times[29] + times[8];
+
+      this->last_profile.static_g_hardware = get_stage_hardware(1);
+      this->last_profile.static_lp_hardware = get_stage_hardware(2);
+      this->last_profile.resub_hardware = get_stage_hardware(5, 6);
+      this->last_profile.dynamic_lp_hardware = get_stage_hardware(8);
+      this->last_profile.getloc_hardware = get_stage_hardware(9);
+      this->last_profile.total_hardware = get_stage_hardware(30, 9);
+      this->profile += this->last_profile;
+    }
+  }
 
-    // Add this result to the cache for potential future lookups.
-    if (this->cache.capacity > 0)
-      this->cache.put(result);
 
-    return result;
+  void
+  Wrapper::read_result(MinimizeResult& out) const
+  {
+    size_t n_res_phases;
+    f2c::res_props_export(this->export_values.data(), this->export_ids.data(), 
+			  &n_res_phases);
+
+    const double* values = this->export_values.data();
+    out.density = values[0];
+    out.expansivity = values[1];
+    out.molar_entropy = values[2];
+    out.molar_heat_capacity = values[3];
+
+    out.phases.resize(this->n_phases);
+    for (size_t i = 0; i < this->n_phases; ++i) {
+      Phase& phase = out.phases[i];
+      phase.id = i;
+      if (phase.name.standard != this->phase_names[i].standard)
+	phase.name = this->phase_names[i];
+      phase.weight_frac = 0.0;
+      phase.volume_frac = 0.0;
+      phase.molar_frac = 0.0;
+      phase.n_moles = 0.0;
+      phase.density = 0.0;
+      phase.composition_ratio.assign(this->n_composition_components, 0.0);
+    }
+
+    // If a solution appears more than once (e.g. immiscible phases) use its
+    // first instance, so visit the result phases in reverse.
+    const size_t stride = n_exported_phase_props + this->n_composition_components;
+    for (size_t r = n_res_phases; r-- > 0;) {
+      const double* props = values + n_exported_sys_props + r * stride;
+
+      // If the Perple_X models are poorly suited to the problem at hand they may
+      // sometimes return phases that are not among the solution models (e.g. faTL).
+      // These phases are often present in extremely small amounts and so can be
+      // disregarded. However, if you are seeing lots of error messages or if the 
+      // fraction of material that is unrecognised is large it implies
+      // that you need to edit your parameter files.
+      const int id = this->export_ids[r];
+      if (id < 0 || static_cast<size_t>(id) >= this->n_phases) {
+	char name[max_res_phase_name_length];
+	f2c::res_phase_props_copy_name(r, name);
+	std::cerr << "The phase name '" << name 
+		  << "' was not found among the solution models." << std::endl
+		  << name << " constitutes " << props[2]*100
+		  << "\% of the end phases. If this number is large you may need to "
+		  << "edit your Perple_X problem definition file." << std::endl;
+	continue;
+      }
+
+      Phase& phase = out.phases[id];
+      phase.weight_frac = props[0];
+      phase.volume_frac = props[1];
+      phase.molar_frac = props[2];
+      phase.n_moles = props[3];
+      phase.density = props[4];
+      phase.composition_ratio.assign(props + n_exported_phase_props, 
+				     props + stride);
+    }
   }
 
 
@@ -303,6 +497,7 @@ std::vector<Phase> get_phases()
 
   // Static variables cannot be instantiated in the header file.
   bool Wrapper::initialized = false;
+  std::uint64_t Wrapper::problem_hash = 0;
   size_t Wrapper::cache_capacity = 0;
   double Wrapper::cache_rtol = 0.0;
 
@@ -341,9 +536,25 @@ std::vector<Phase> get_phases()
   }
 
 
+  void
+  Wrapper::record(const double pressure,
+                  const double temperature,
+		  const DoubleSpan composition,
+		  const SolveCounters& counters,
+		  const double latency) const
+  {
+    this->stats.record(counters, latency);
+
+    if (this->trace_recorder)
+      this->trace_recorder->record(pressure, temperature, composition, 
+				   counters.cache_hit, latency);
+  }
+
+
   
   Wrapper::Wrapper() 
-  : n_composition_components(f2c::composition_props_get_n_components()),
+  : problem_file_hash(Wrapper::problem_hash),
+    n_composition_components(f2c::composition_props_get_n_components()),
     composition_component_names(make_composition_component_names()),
     composition_molar_masses(make_composition_molar_masses()),
 
@@ -357,6 +568,20 @@ std::vector<Phase> get_phases()
     min_temperature(f2c::get_min_temperature()),
     max_temperature(f2c::get_max_temperature()),
 
-    cache(Wrapper::cache_capacity, Wrapper::cache_rtol)
-  {}
+    cache(Wrapper::cache_capacity, Wrapper::cache_rtol),
+
+    profiling(false),
+    hardware_counting(false),
+    profile(),
+    last_counters(),
+    last_profile(),
+    stats(),
+
+    export_values(n_exported_sys_props + f2c::res_props_get_max_n() * 
+		  (n_exported_phase_props + n_composition_components)),
+    export_ids(f2c::res_props_get_max_n())
+  {
+    // Index the cached phase names by phase id so that compact encodings may be used.
+    this->cache.set_phase_names(this->phase_names);
+  }
 }
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/adaptive_thermo_table.h>
+#include <perplexcpp/table_file.h>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "thermo_grid.h"
+
+
+using namespace perplexcpp;
+
+
+class AdaptiveThermoTableTest : public ::testing::Test {
+  protected:
+
+    void SetUp() override {
+      Wrapper::initialize("test.dat", "./simple", 10, 0.1);
+
+      // Building the table is expensive so share it between the tests.
+      if (!table)
+	table.reset(new AdaptiveThermoTable(Wrapper::get_instance(), 4, 1e-2, 1, 
+					    {}, {}, 2));
+    }
+
+
+    static std::unique_ptr<AdaptiveThermoTable> table;
+};
+
+
+std::unique_ptr<AdaptiveThermoTable> AdaptiveThermoTableTest::table;
+
+
+
+TEST_F(AdaptiveThermoTableTest, UsesFewerPointsThanUniformGrid)
+{
+  EXPECT_LT(table->n_points(), 17 * 17);
+  EXPECT_GE(table->n_leaves(), 4);
+}
+
+
+
+TEST_F(AdaptiveThermoTableTest, CornersMatchSolver)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+
+  const MinimizeResult expected = 
+    wrapper.solve(table->max_pressure, table->min_temperature, 
+		  wrapper.initial_bulk_composition);
+
+  EXPECT_NEAR(table->interpolate(ThermoProperty::density, 
+				 table->max_pressure, table->min_temperature),
+	      expected.density, 1e-8);
+}
+
+
+
+TEST_F(AdaptiveThermoTableTest, InterpolationIsCloseToSolver)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+
+  const double pressure = 0.37 * table->min_pressure + 0.63 * table->max_pressure;
+  const double temperature = 0.55 * table->min_temperature + 0.45 * table->max_temperature;
+  const MinimizeResult expected = 
+    wrapper.solve(pressure, temperature, wrapper.initial_bulk_composition);
+
+  const ThermoProperties properties = table->interpolate(pressure, temperature);
+  EXPECT_NEAR(properties.density, expected.density, 0.01 * expected.density);
+  EXPECT_NEAR(properties.molar_heat_capacity, expected.molar_heat_capacity, 
+	      0.02 * expected.molar_heat_capacity);
+}
+
+
+
+TEST_F(AdaptiveThermoTableTest, InterpolateThrowsOutsideTable)
+{
+  EXPECT_THROW(table->interpolate(ThermoProperty::density, 
+				  2 * table->max_pressure, table->min_temperature),
+	       std::invalid_argument);
+}
+
+
+
+TEST_F(AdaptiveThermoTableTest, SaveAndLoad)
+{
+  const std::string filename = "adaptive_thermo_table.bin";
+  table->save(filename);
+  const AdaptiveThermoTable loaded = AdaptiveThermoTable::load(filename);
+  std::remove(filename.c_str());
+
+  EXPECT_EQ(loaded.problem_hash, table->problem_hash);
+  EXPECT_EQ(loaded.n_points(), table->n_points());
+  EXPECT_EQ(loaded.n_leaves(), table->n_leaves());
+
+  const double pressure = 0.21 * table->min_pressure + 0.79 * table->max_pressure;
+  const double temperature = 0.83 * table->min_temperature + 0.17 * table->max_temperature;
+  EXPECT_EQ(loaded.depth(pressure, temperature), table->depth(pressure, temperature));
+  EXPECT_EQ(loaded.interpolate(ThermoProperty::melt_fraction, pressure, temperature),
+	    table->interpolate(ThermoProperty::melt_fraction, pressure, temperature));
+}
+
+
+
+TEST(AdaptiveThermoTableLoadTest, RejectCyclicTree)
+{
+  // The second node lists itself as its first child.
+  const std::vector<std::uint32_t> nodes = { 1, 0, 2, 6, 8,
+					     1, 0, 1, 3, 4,
+					     0, 1, 2, 4, 5,
+					     0, 3, 4, 6, 7,
+					     0, 4, 5, 7, 8 };
+  const std::vector<double> composition = { 1 };
+  const std::vector<double> values(9, 1);
+
+  const std::string filename = "cyclic_adaptive_thermo_table.bin";
+  TableWriter writer("AdaptiveThermoTable", 0);
+  writer.add_axis("pressure", "Pa", 3, 0, 1);
+  writer.add_axis("temperature", "K", 3, 0, 1);
+  writer.add_array("composition", "", composition.data(), composition.size());
+  writer.add_array("nodes", "", nodes.data(), nodes.size());
+  for (size_t k = 0; k < n_thermo_properties; ++k)
+    writer.add_array(thermo_property_names[k], thermo_property_units[k],
+		     values.data(), values.size());
+  writer.write(filename);
+
+  EXPECT_THROW(AdaptiveThermoTable::load(filename), std::runtime_error);
+  std::remove(filename.c_str());
+}
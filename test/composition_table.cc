@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/composition_table.h>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <memory>
+
+
+using namespace perplexcpp;
+
+
+class CompositionTableTest : public ::testing::Test {
+  protected:
+
+    void SetUp() override {
+      Wrapper::initialize("test.dat", "./simple", 10, 0.1);
+      const Wrapper& wrapper = Wrapper::get_instance();
+
+      // Vary every component by 5% about the initial composition.
+      min_composition = max_composition = wrapper.initial_bulk_composition;
+      for (size_t c = 0; c < wrapper.n_composition_components; ++c) {
+	min_composition[c] *= 0.95;
+	max_composition[c] *= 1.05;
+      }
+
+      // Building the table is expensive so share it between the tests.
+      if (!table)
+	table.reset(new CompositionTable(wrapper, 3, min_composition, max_composition,
+					 {}, 2));
+    }
+
+
+    std::vector<double> min_composition, max_composition;
+
+    static std::unique_ptr<CompositionTable> table;
+};
+
+
+std::unique_ptr<CompositionTable> CompositionTableTest::table;
+
+
+
+TEST_F(CompositionTableTest, CheckSize)
+{
+  EXPECT_EQ(table->n_dimensions(), 6);
+  // A level 3 sparse grid in 6 dimensions (with boundary points).
+  EXPECT_EQ(table->n_points(), 2768);
+}
+
+
+
+TEST_F(CompositionTableTest, GridPointsMatchSolver)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+
+  // The point at the centre of the pressure range, a quarter of the temperature
+  // range, the upper bound of the first component and the lower bound of the
+  // others lies on the sparse grid.
+  const double pressure = 0.5 * (table->min_pressure + table->max_pressure);
+  const double temperature = 0.75 * table->min_temperature + 0.25 * table->max_temperature;
+  std::vector<double> composition = min_composition;
+  composition[0] = max_composition[0];
+
+  const MinimizeResult expected = wrapper.solve(pressure, temperature, composition);
+  const ThermoProperties properties = table->interpolate(pressure, temperature, composition);
+
+  EXPECT_NEAR(properties.density, expected.density, 1e-8 * expected.density);
+  EXPECT_NEAR(properties.molar_entropy, expected.molar_entropy, 
+	      1e-8 * expected.molar_entropy);
+}
+
+
+
+TEST_F(CompositionTableTest, ErrorIsBounded)
+{
+  const ThermoProperties errors = table->validate(Wrapper::get_instance(), 20, 2);
+
+  // The largest errors are near the phase boundaries.
+  EXPECT_LT(errors.density, 0.02);
+  EXPECT_LT(errors.expansivity, 0.15);
+  EXPECT_LT(errors.molar_heat_capacity, 0.06);
+  EXPECT_LT(errors.molar_entropy, 0.02);
+  EXPECT_LT(errors.melt_fraction, 0.15);
+}
+
+
+
+TEST_F(CompositionTableTest, ValidateUsesMeltPhases)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+  const std::string filename = "composition_table_melt_phases.bin";
+
+  // Count olivine, which is present almost everywhere, as melt.
+  const CompositionTable olivine(wrapper, 2, wrapper.initial_bulk_composition,
+				 wrapper.initial_bulk_composition, { "Ol" }, 2);
+  olivine.save(filename);
+  const CompositionTable loaded = CompositionTable::load(filename);
+  std::remove(filename.c_str());
+
+  EXPECT_LT(olivine.validate(wrapper, 10, 2).melt_fraction, 0.12);
+  EXPECT_LT(loaded.validate(wrapper, 10, 2).melt_fraction, 0.12);
+}
+
+
+
+TEST_F(CompositionTableTest, InterpolateThrowsOutsideTable)
+{
+  std::vector<double> composition = max_composition;
+  composition[1] *= 1.1;
+
+  EXPECT_THROW(table->interpolate(table->min_pressure, table->min_temperature, composition),
+	       std::invalid_argument);
+  EXPECT_THROW(table->interpolate(2 * table->max_pressure, table->min_temperature, 
+				  min_composition),
+	       std::invalid_argument);
+}
+
+
+
+TEST_F(CompositionTableTest, SaveAndLoad)
+{
+  const std::string filename = "composition_table.bin";
+  table->save(filename);
+  const CompositionTable loaded = CompositionTable::load(filename);
+  std::remove(filename.c_str());
+
+  EXPECT_EQ(loaded.problem_hash, table->problem_hash);
+  EXPECT_EQ(loaded.level, table->level);
+  EXPECT_EQ(loaded.n_points(), table->n_points());
+  EXPECT_EQ(loaded.max_composition, table->max_composition);
+
+  const double pressure = 0.3 * table->min_pressure + 0.7 * table->max_pressure;
+  const double temperature = 0.6 * table->min_temperature + 0.4 * table->max_temperature;
+  EXPECT_EQ(loaded.interpolate(ThermoProperty::density, pressure, temperature, 
+			       max_composition),
+	    table->interpolate(ThermoProperty::density, pressure, temperature, 
+			       max_composition));
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/concurrent_result_cache.h>
+
+#include <gtest/gtest.h>
+#include <thread>
+
+
+using namespace perplexcpp;
+
+
+namespace
+{
+  MinimizeResult make_result(const double temperature)
+  {
+    return MinimizeResult {
+      2.0e8,
+      temperature,
+      std::vector<double>(2, 1.0),
+      std::vector<Phase> {
+	Phase { 0, PhaseName { "O", "Ol", "olivine" }, 1.0, 1.0, 1.0, 4.0,
+	        std::vector<double> { 0.1, 0.2 }, 3300 }
+      },
+      temperature,  // density
+      1.0,
+      2.0,
+      3.0
+    };
+  }
+}
+
+
+
+TEST(ConcurrentResultCacheTest, GetReturnsExactMatch)
+{
+  ConcurrentResultCache cache(10);
+  cache.put(make_result(1500));
+
+  MinimizeResult result;
+  ASSERT_EQ(cache.get(2.0e8, 1500, std::vector<double>(2, 1.0), result), 0);
+  EXPECT_EQ(result.density, 1500);
+  EXPECT_STREQ(result.phases[0].name.full.c_str(), "olivine");
+
+  EXPECT_EQ(cache.get(2.0e8, 1501, std::vector<double>(2, 1.0), result), -1);
+
+  EXPECT_EQ(cache.get_n_hits(), 1);
+  EXPECT_EQ(cache.get_n_misses(), 1);
+}
+
+
+
+TEST(ConcurrentResultCacheTest, GetReturnsNearMatchFromAnyShard)
+{
+  ConcurrentResultCache cache(64, 0.1, 8);
+  cache.put(make_result(1500));
+
+  MinimizeResult result;
+  for (int t = 1400; t < 1600; t += 7)
+    EXPECT_EQ(cache.get(2.0e8, t, std::vector<double>(2, 1.0), result), 0);
+}
+
+
+
+TEST(ConcurrentResultCacheTest, PutEvictsUnreferencedItems)
+{
+  // A single shard makes the eviction order deterministic.
+  ConcurrentResultCache cache(2, 0.0, 1);
+  cache.put(make_result(1000));
+  cache.put(make_result(1001));
+
+  MinimizeResult result;
+  ASSERT_EQ(cache.get(2.0e8, 1000, std::vector<double>(2, 1.0), result), 0);
+
+  cache.put(make_result(1002));
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.get(2.0e8, 1000, std::vector<double>(2, 1.0), result), 0);
+  EXPECT_EQ(cache.get(2.0e8, 1001, std::vector<double>(2, 1.0), result), -1);
+  EXPECT_EQ(cache.get(2.0e8, 1002, std::vector<double>(2, 1.0), result), 0);
+}
+
+
+
+TEST(ConcurrentResultCacheTest, ConcurrentAccessIsConsistent)
+{
+  ConcurrentResultCache cache(256, 0.0, 8);
+
+  const int n_readers = 4;
+  const int n_lookups = 2000;
+
+  // One thread fills the cache while the others read from it.
+  std::vector<std::thread> threads;
+  threads.emplace_back([&cache]() {
+    for (int i = 0; i < 512; ++i)
+      cache.put(make_result(1000 + i));
+  });
+
+  for (int r = 0; r < n_readers; ++r)
+    threads.emplace_back([&cache, r]() {
+      MinimizeResult result;
+      for (int i = 0; i < n_lookups; ++i) {
+	const double temperature = 1000 + (i * 7 + r) % 512;
+	if (cache.get(2.0e8, temperature, std::vector<double>(2, 1.0), result) == 0) {
+	  ASSERT_EQ(result.density, temperature);
+	}
+      }
+    });
+
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT_EQ(cache.get_n_hits() + cache.get_n_misses(), n_readers * n_lookups);
+  EXPECT_LE(cache.size(), 256);
+}
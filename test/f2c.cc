@@ -19,6 +19,7 @@
 
 
 #include <gtest/gtest.h>
+#include <vector>
 
 #include "f2c.h"
 
@@ -127,3 +128,39 @@ TEST_F(InterfaceTest, CheckMolarWeights)
   EXPECT_NEAR(get_composition_molar_mass(3)*1000, 71.844, 5e-4);
 }
 
+
+
+TEST_F(InterfaceTest, CheckResPropsExport)
+{
+  const size_t n_components = composition_props_get_n_components();
+  const size_t stride = 5 + n_components;
+  std::vector<double> values(4 + res_props_get_max_n() * stride);
+  std::vector<int> ids(res_props_get_max_n());
+  size_t n;
+
+  res_props_export(values.data(), ids.data(), &n);
+
+  ASSERT_EQ(n, res_phase_props_get_n());
+  EXPECT_EQ(values[0], sys_props_get_density());
+  EXPECT_EQ(values[3], sys_props_get_mol_heat_capacity());
+
+  // Cpx(HGP) is the first solution model.
+  EXPECT_EQ(ids[0], 0);
+  for (size_t i = 0; i < n; ++i) {
+    const double* props = values.data() + 4 + i * stride;
+    EXPECT_EQ(props[0], res_phase_props_get_weight_frac(i));
+    EXPECT_EQ(props[2], res_phase_props_get_mol_frac(i));
+    EXPECT_EQ(props[3], res_phase_props_get_mol(i));
+    EXPECT_EQ(props[4], get_endmember_density(i));
+    for (size_t c = 0; c < n_components; ++c)
+      EXPECT_EQ(props[5+c], get_endmember_composition_ratio(i, c));
+
+    // Phases that are not solution models have no id.
+    if (ids[i] == -1)
+      continue;
+
+    char name[15];
+    res_phase_props_copy_name(i, name);
+    EXPECT_STREQ(name, soln_phase_props_get_name(ids[i]));
+  }
+}
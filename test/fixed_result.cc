@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/fixed_result.h>
+
+#include <type_traits>
+
+#include <gtest/gtest.h>
+#include <perplexcpp/problems/simple.h>
+#include <perplexcpp/utils.h>
+#include <perplexcpp/wrapper.h>
+
+
+using namespace perplexcpp;
+
+namespace simple = perplexcpp::problems::simple;
+
+
+class FixedResultTest : public ::testing::Test {
+  protected:
+
+    void SetUp() override {
+      Wrapper::initialize("test.dat", "./simple", 10, 0.1);
+    }
+
+
+    const double pressure = utils::convert_bar_to_pascals(20000);
+
+    const double temperature = 1500;
+};
+
+
+
+TEST(FixedResultTypeTest, CheckIsTriviallyCopyable)
+{
+  EXPECT_TRUE(std::is_trivially_copyable<simple::Result>::value);
+  EXPECT_TRUE(std::is_standard_layout<simple::Result>::value);
+}
+
+
+TEST_F(FixedResultTest, CheckGeneratedHeaderMatchesProblem)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+
+  EXPECT_EQ(simple::problem_hash, wrapper.problem_file_hash);
+  EXPECT_EQ(simple::n_components, wrapper.n_composition_components);
+  EXPECT_EQ(simple::n_phases, wrapper.n_phases);
+
+  EXPECT_EQ(wrapper.composition_component_names[static_cast<size_t>(simple::Component::MgO)],
+	    "MgO");
+  EXPECT_EQ(wrapper.phase_names[static_cast<size_t>(simple::PhaseId::Opx_HGP)].standard,
+	    "Opx(HGP)");
+}
+
+
+TEST_F(FixedResultTest, CheckMinimizeInto)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+  const MinimizeResult expected = wrapper.minimize(pressure, temperature);
+
+  simple::Result result;
+  minimize_into(wrapper, pressure, temperature, wrapper.initial_bulk_composition, result);
+
+  EXPECT_DOUBLE_EQ(result.pressure, expected.pressure);
+  EXPECT_DOUBLE_EQ(result.temperature, expected.temperature);
+  EXPECT_DOUBLE_EQ(result.density, expected.density);
+  EXPECT_DOUBLE_EQ(result.molar_heat_capacity, expected.molar_heat_capacity);
+
+  const Phase& melt = expected.phases[find_phase_index(expected.phases, "melt(HGP)")];
+  EXPECT_DOUBLE_EQ(result.phase(simple::PhaseId::melt_HGP).weight_frac, melt.weight_frac);
+  EXPECT_DOUBLE_EQ(result.phase<1>().n_moles, melt.n_moles);
+  EXPECT_DOUBLE_EQ(result.phase(simple::PhaseId::melt_HGP).composition_ratio[
+		     static_cast<size_t>(simple::Component::SiO2)], 
+		   melt.composition_ratio[0]);
+}
+
+
+TEST_F(FixedResultTest, CheckRoundTrip)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+  const MinimizeResult expected = wrapper.minimize(pressure, temperature);
+
+  simple::Result fixed;
+  copy_to_fixed(expected, fixed);
+
+  MinimizeResult result;
+  copy_from_fixed(fixed, wrapper.phase_names, result);
+
+  EXPECT_EQ(result.composition, expected.composition);
+  ASSERT_EQ(result.phases.size(), expected.phases.size());
+  for (size_t p = 0; p < result.phases.size(); ++p) {
+    EXPECT_EQ(result.phases[p].id, expected.phases[p].id);
+    EXPECT_EQ(result.phases[p].name.standard, expected.phases[p].name.standard);
+    EXPECT_DOUBLE_EQ(result.phases[p].molar_frac, expected.phases[p].molar_frac);
+    EXPECT_EQ(result.phases[p].composition_ratio, expected.phases[p].composition_ratio);
+  }
+}
+
+
+TEST_F(FixedResultTest, CheckWrongSizeThrows)
+{
+  const MinimizeResult expected = 
+    Wrapper::get_instance().minimize(pressure, temperature);
+
+  FixedResult<simple::n_components,simple::n_phases+1> fixed;
+  EXPECT_THROW(copy_to_fixed(expected, fixed), std::invalid_argument);
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/interpolating_cache.h>
+
+#include <gtest/gtest.h>
+
+
+using namespace perplexcpp;
+
+
+namespace
+{
+  MinimizeResult make_result(const double pressure,
+                             const double temperature,
+			     const double density,
+			     const double melt_frac)
+  {
+    const std::vector<double> comp_ratio(2, 1.0);
+
+    return MinimizeResult {
+      pressure,
+      temperature,
+      std::vector<double>(2, 1.0),
+      std::vector<Phase> {
+	Phase { 0, PhaseName { "O", "Ol", "olivine" },
+	        1.0-melt_frac, 1.0-melt_frac, 1.0-melt_frac, 1.0-melt_frac,
+		comp_ratio, density },
+	Phase { 1, PhaseName { "melt", "Melt", "liquid" },
+	        melt_frac, melt_frac, melt_frac, melt_frac,
+		comp_ratio, density }
+      },
+      density,
+      1.0,
+      2.0,
+      3.0
+    };
+  }
+}
+
+
+
+TEST(InterpolatingCacheTest, GetInterpolatesBetweenNeighbours)
+{
+  auto cache = InterpolatingCache(10, 2, 0.1, 1e9, 1000);
+
+  cache.put(make_result(1e9, 1500, 3000, 0.0));
+  cache.put(make_result(1e9, 1520, 3100, 0.0));
+
+  MinimizeResult result;
+  double error;
+  ASSERT_EQ(cache.get(1e9, 1510, std::vector<double>(2, 1.0), result, error), 0);
+
+  EXPECT_NEAR(result.density, 3050, 1e-8);
+  EXPECT_EQ(result.temperature, 1510);
+  EXPECT_NEAR(error, 50.0/3050, 1e-8);
+  EXPECT_EQ(cache.get_last_error_estimate(), error);
+  EXPECT_STREQ(result.phases[1].name.full.c_str(), "liquid");
+}
+
+
+
+TEST(InterpolatingCacheTest, GetReturnsExactMatch)
+{
+  auto cache = InterpolatingCache(10, 2, 0.1, 1e9, 1000);
+
+  cache.put(make_result(1e9, 1500, 3000, 0.0));
+  cache.put(make_result(1e9, 1520, 3100, 0.0));
+
+  MinimizeResult result;
+  double error;
+  ASSERT_EQ(cache.get(1e9, 1520, std::vector<double>(2, 1.0), result, error), 0);
+
+  EXPECT_EQ(result.density, 3100);
+  EXPECT_EQ(error, 0.0);
+}
+
+
+
+TEST(InterpolatingCacheTest, GetMissesWithDifferentAssemblages)
+{
+  auto cache = InterpolatingCache(10, 2, 0.1, 1e9, 1000);
+
+  cache.put(make_result(1e9, 1500, 3000, 0.0));
+  cache.put(make_result(1e9, 1520, 3100, 0.1));
+
+  MinimizeResult result;
+  EXPECT_EQ(cache.get(1e9, 1510, std::vector<double>(2, 1.0), result), -1);
+}
+
+
+
+TEST(InterpolatingCacheTest, GetMissesWhenNeighboursAreTooFar)
+{
+  auto cache = InterpolatingCache(10, 2, 0.1, 1e9, 1000);
+
+  cache.put(make_result(1e9, 1500, 3000, 0.0));
+  cache.put(make_result(1e9, 1700, 3100, 0.0));
+
+  MinimizeResult result;
+  EXPECT_EQ(cache.get(1e9, 1510, std::vector<double>(2, 1.0), result), -1);
+
+  cache.set_max_distance(0.2);
+  EXPECT_EQ(cache.get(1e9, 1510, std::vector<double>(2, 1.0), result), 0);
+
+  EXPECT_EQ(cache.get_n_hits(), 1);
+  EXPECT_EQ(cache.get_n_misses(), 1);
+}
+
+
+
+TEST(InterpolatingCacheTest, GetFindsNearestNeighboursAmongMany)
+{
+  auto cache = InterpolatingCache(1000, 1, 0.01, 1e9, 1000);
+
+  for (int i = 0; i < 100; ++i)
+    for (int j = 0; j < 5; ++j)
+      cache.put(make_result(1e9 + j*1e8, 1000 + i*10, i*1000 + j, 0.0));
+
+  MinimizeResult result;
+  ASSERT_EQ(cache.get(1.2e9, 1371, std::vector<double>(2, 1.0), result), 0);
+  EXPECT_EQ(result.density, 37002);
+}
+
+
+
+TEST(InterpolatingCacheTest, PutEvictsOldestItems)
+{
+  auto cache = InterpolatingCache(8, 1, 0.001, 1e9, 1000);
+
+  for (int i = 0; i < 9; ++i)
+    cache.put(make_result(1e9, 1000 + i*10, i, 0.0));
+
+  EXPECT_EQ(cache.size(), 7);
+
+  MinimizeResult result;
+  EXPECT_EQ(cache.get(1e9, 1000, std::vector<double>(2, 1.0), result), -1);
+  EXPECT_EQ(cache.get(1e9, 1080, std::vector<double>(2, 1.0), result), 0);
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/persistent_cache.h>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+
+
+using namespace perplexcpp;
+
+
+namespace
+{
+  const std::vector<PhaseName> phase_names {
+    PhaseName { "O", "Ol", "olivine" },
+    PhaseName { "melt", "Melt", "liquid" }
+  };
+
+
+  MinimizeResult make_result(const double pressure, const double temperature)
+  {
+    return MinimizeResult {
+      pressure,
+      temperature,
+      std::vector<double> { 1.0, 2.0 },
+      std::vector<Phase> {
+	Phase { 0, phase_names[0], 0.7, 0.6, 0.5, 4.0,
+	        std::vector<double> { 0.1, 0.2 }, 3300 },
+	Phase { 1, phase_names[1], 0.3, 0.4, 0.5, 1.0,
+	        std::vector<double> { 0.3, 0.4 }, 2900 }
+      },
+      3200,
+      1.0,
+      2.0,
+      3.0
+    };
+  }
+
+
+  class PersistentCacheTest : public ::testing::Test {
+    protected:
+      // ctest runs the tests in parallel so each needs its own file.
+      void SetUp() override 
+      { 
+	filename = std::string("persistent_cache_") + 
+		   ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+	std::remove(filename.c_str()); 
+      }
+
+      void TearDown() override { std::remove(filename.c_str()); }
+
+      std::string filename;
+  };
+}
+
+
+
+TEST_F(PersistentCacheTest, GetReturnsMinusOneWhenEmpty)
+{
+  PersistentCache cache(filename, 1234, 2, phase_names, 16);
+
+  MinimizeResult result;
+  EXPECT_EQ(cache.get(2e9, 1500, std::vector<double> { 1.0, 2.0 }, result), -1);
+  EXPECT_EQ(cache.get_n_misses(), 1);
+}
+
+
+
+TEST_F(PersistentCacheTest, GetReturnsExactMatch)
+{
+  PersistentCache cache(filename, 1234, 2, phase_names, 16);
+  cache.put(make_result(2e9, 1500));
+
+  MinimizeResult result;
+  ASSERT_EQ(cache.get(2e9, 1500, std::vector<double> { 1.0, 2.0 }, result), 0);
+
+  EXPECT_EQ(result.density, 3200);
+  ASSERT_EQ(result.phases.size(), 2);
+  EXPECT_EQ(result.phases[1].id, 1);
+  EXPECT_STREQ(result.phases[1].name.full.c_str(), "liquid");
+  EXPECT_EQ(result.phases[1].composition_ratio[1], 0.4);
+  EXPECT_EQ(result.phases[0].density, 3300);
+
+  EXPECT_EQ(cache.get(2e9, 1501, std::vector<double> { 1.0, 2.0 }, result), -1);
+}
+
+
+
+TEST_F(PersistentCacheTest, ResultsPersistBetweenInstances)
+{
+  {
+    PersistentCache cache(filename, 1234, 2, phase_names, 16);
+    for (int i = 0; i < 10; ++i)
+      cache.put(make_result(2e9, 1500 + i));
+  }
+
+  PersistentCache cache(filename, 1234, 2, phase_names);
+  EXPECT_EQ(cache.size(), 10);
+
+  MinimizeResult result;
+  EXPECT_EQ(cache.get(2e9, 1509, std::vector<double> { 1.0, 2.0 }, result), 0);
+}
+
+
+
+TEST_F(PersistentCacheTest, ResultsAreSharedBetweenMappings)
+{
+  PersistentCache writer(filename, 1234, 2, phase_names, 16);
+  PersistentCache reader(filename, 1234, 2, phase_names, 16);
+
+  writer.put(make_result(2e9, 1500));
+
+  MinimizeResult result;
+  EXPECT_EQ(reader.get(2e9, 1500, std::vector<double> { 1.0, 2.0 }, result), 0);
+}
+
+
+
+TEST_F(PersistentCacheTest, PutIgnoresDuplicatesAndOverflow)
+{
+  PersistentCache cache(filename, 1234, 2, phase_names, 4);
+
+  cache.put(make_result(2e9, 1500));
+  cache.put(make_result(2e9, 1500));
+  EXPECT_EQ(cache.size(), 1);
+
+  for (int i = 0; i < 10; ++i)
+    cache.put(make_result(2e9, 1600 + i));
+  EXPECT_EQ(cache.size(), 4);
+}
+
+
+
+TEST_F(PersistentCacheTest, ConstructorThrowsForDifferentProblem)
+{
+  { PersistentCache cache(filename, 1234, 2, phase_names, 16); }
+
+  EXPECT_THROW(PersistentCache(filename, 4321, 2, phase_names, 16), std::runtime_error);
+  EXPECT_THROW(PersistentCache(filename, 1234, 3, phase_names, 16), std::runtime_error);
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/prewarm.h>
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <perplexcpp/result_cache.h>
+#include <perplexcpp/utils.h>
+
+
+using namespace perplexcpp;
+
+
+class PrewarmTest : public ::testing::Test {
+  protected:
+
+    void SetUp() override {
+      Wrapper::initialize("test.dat", "./simple", 10, 0.1);
+    }
+};
+
+
+
+TEST(PrewarmGridTest, MakeQueryGridSpansRange)
+{
+  auto points = make_query_grid(1e9, 2e9, 3, 1000, 1500, 2);
+
+  ASSERT_EQ(points.size(), 6);
+  EXPECT_EQ(points[0].pressure, 1e9);
+  EXPECT_EQ(points[0].temperature, 1000);
+  EXPECT_EQ(points[1].temperature, 1500);
+  EXPECT_EQ(points[2].pressure, 1.5e9);
+  EXPECT_EQ(points[5].pressure, 2e9);
+  EXPECT_TRUE(points[5].composition.empty());
+}
+
+
+
+TEST(PrewarmGridTest, MakeQueryGridEndsAtMaximum)
+{
+  // Without clamping min + (n-1) * d rounds above the maximum for these sizes.
+  auto points = make_query_grid(1e5, 5e9, 592, 300, 2500, 1);
+  EXPECT_EQ(points.back().pressure, 5e9);
+
+  points = make_query_grid(1e9, 1e9, 1, 300, 2500, 2166);
+  EXPECT_EQ(points.back().temperature, 2500);
+}
+
+
+
+TEST(PrewarmGridTest, ReadQueryPoints)
+{
+  const std::string filename = "query_points.txt";
+  {
+    std::ofstream file(filename);
+    file << "# pressure temperature composition\n"
+	 << "2e9 1500\n"
+	 << "\n"
+	 << "3e9 1600 1.0 2.0 3.0 4.0\n";
+  }
+
+  auto points = read_query_points(filename);
+  std::remove(filename.c_str());
+
+  ASSERT_EQ(points.size(), 2);
+  EXPECT_EQ(points[0].pressure, 2e9);
+  EXPECT_TRUE(points[0].composition.empty());
+  EXPECT_EQ(points[1].temperature, 1600);
+  ASSERT_EQ(points[1].composition.size(), 4);
+  EXPECT_EQ(points[1].composition[3], 4.0);
+}
+
+
+
+TEST_F(PrewarmTest, PrewarmFillsCache)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+
+  auto points = make_query_grid(utils::convert_bar_to_pascals(21000), 
+				utils::convert_bar_to_pascals(23000), 2,
+				1510, 1530, 2);
+  // Points outside the problem bounds are skipped.
+  points.push_back(QueryPoint { 2 * wrapper.max_pressure, 1500, {} });
+
+  ResultCache cache(10);
+  EXPECT_EQ(prewarm(wrapper, points, cache, 2), 4);
+  EXPECT_EQ(cache.size(), 4);
+
+  const MinimizeResult expected = wrapper.solve(points[3].pressure, 
+						points[3].temperature,
+						wrapper.initial_bulk_composition);
+  MinimizeResult cached;
+  ASSERT_EQ(cache.get(points[3].pressure, points[3].temperature, 
+		      wrapper.initial_bulk_composition, cached), 0);
+  EXPECT_NEAR(cached.density, expected.density, 1e-8);
+  EXPECT_NEAR(cached.molar_entropy, expected.molar_entropy, 1e-8);
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/query_trace.h>
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+
+using namespace perplexcpp;
+
+
+namespace
+{
+  class QueryTraceTest : public ::testing::Test {
+    protected:
+      // ctest runs the tests in parallel so each needs its own file.
+      void SetUp() override 
+      { 
+	filename = std::string("query_trace_") + 
+		   ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+	std::remove(filename.c_str()); 
+      }
+
+      void TearDown() override { std::remove(filename.c_str()); }
+
+      size_t file_size() const
+      {
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	return file.tellg();
+      }
+
+      std::string filename;
+
+      const std::vector<double> composition_a { 1.0, 2.0 };
+
+      const std::vector<double> composition_b { 3.0, 4.0 };
+  };
+}
+
+
+
+TEST_F(QueryTraceTest, CheckRoundTrip)
+{
+  {
+    TraceRecorder recorder(filename, 1234, 2);
+    recorder.record(1e9, 1500, composition_a, false, 0.005);
+    recorder.record(2e9, 1600, composition_a, true, 1e-6);
+    recorder.record(3e9, 1700, composition_b, false, 0.004);
+    EXPECT_EQ(recorder.size(), 3);
+  }
+
+  // The composition is only stored when it changes.
+  EXPECT_EQ(file_size(), 24 + 3 * 21 + 2 * 2 * sizeof(double));
+
+  const QueryTrace trace = QueryTrace::load(filename);
+  EXPECT_EQ(trace.problem_hash, 1234);
+  EXPECT_EQ(trace.n_components, 2);
+  ASSERT_EQ(trace.records.size(), 3);
+  EXPECT_EQ(trace.n_cache_hits(), 1);
+
+  EXPECT_EQ(trace.records[1].pressure, 2e9);
+  EXPECT_EQ(trace.records[1].temperature, 1600);
+  EXPECT_EQ(trace.records[1].composition, composition_a);
+  EXPECT_TRUE(trace.records[1].cache_hit);
+  EXPECT_FLOAT_EQ(trace.records[1].latency, 1e-6);
+  EXPECT_EQ(trace.records[2].composition, composition_b);
+  EXPECT_FALSE(trace.records[2].cache_hit);
+
+  const std::vector<QueryPoint> points = trace.to_query_points();
+  ASSERT_EQ(points.size(), 3);
+  EXPECT_EQ(points[2].pressure, 3e9);
+  EXPECT_EQ(points[2].composition, composition_b);
+}
+
+
+TEST_F(QueryTraceTest, CheckAppend)
+{
+  {
+    TraceRecorder recorder(filename, 1234, 2);
+    recorder.record(1e9, 1500, composition_a, false, 0.005);
+  }
+  {
+    TraceRecorder recorder(filename, 1234, 2);
+    recorder.record(2e9, 1600, composition_a, true, 1e-6);
+  }
+
+  const QueryTrace trace = QueryTrace::load(filename);
+  ASSERT_EQ(trace.records.size(), 2);
+  EXPECT_EQ(trace.records[1].composition, composition_a);
+}
+
+
+TEST_F(QueryTraceTest, CheckDifferentProblemThrows)
+{
+  { TraceRecorder recorder(filename, 1234, 2); }
+
+  EXPECT_THROW(TraceRecorder(filename, 4321, 2), std::runtime_error);
+  EXPECT_THROW(TraceRecorder(filename, 1234, 3), std::runtime_error);
+}
+
+
+TEST_F(QueryTraceTest, CheckTruncatedRecordIgnored)
+{
+  {
+    TraceRecorder recorder(filename, 1234, 2);
+    recorder.record(1e9, 1500, composition_a, false, 0.005);
+    recorder.record(2e9, 1600, composition_b, false, 0.005);
+  }
+
+  // Drop the end of the last composition.
+  const size_t size = file_size();
+  std::vector<char> bytes(size);
+  std::ifstream(filename, std::ios::binary).read(bytes.data(), size);
+  std::ofstream(filename, std::ios::binary | std::ios::trunc).write(bytes.data(), size - 4);
+
+  const QueryTrace trace = QueryTrace::load(filename);
+  ASSERT_EQ(trace.records.size(), 1);
+  EXPECT_EQ(trace.records[0].composition, composition_a);
+}
+
+
+TEST_F(QueryTraceTest, CheckAppendAfterTruncatedRecord)
+{
+  {
+    TraceRecorder recorder(filename, 1234, 2);
+    recorder.record(1e9, 1500, composition_a, false, 0.005);
+  }
+  std::ofstream(filename, std::ios::binary | std::ios::app) << "partial";
+  {
+    TraceRecorder recorder(filename, 1234, 2);
+    recorder.record(2e9, 1600, composition_b, true, 1e-6);
+  }
+
+  const QueryTrace trace = QueryTrace::load(filename);
+  ASSERT_EQ(trace.records.size(), 2);
+  EXPECT_EQ(trace.records[1].pressure, 2e9);
+  EXPECT_EQ(trace.records[1].composition, composition_b);
+  EXPECT_TRUE(trace.records[1].cache_hit);
+}
+
+
+TEST_F(QueryTraceTest, CheckInvalidFileThrows)
+{
+  std::ofstream(filename) << "not a trace";
+  EXPECT_THROW(QueryTrace::load(filename), std::runtime_error);
+
+  EXPECT_THROW(QueryTrace::load("missing_trace.bin"), std::runtime_error);
+}
+
+
+TEST_F(QueryTraceTest, CheckWrongCompositionSizeThrows)
+{
+  TraceRecorder recorder(filename, 1234, 2);
+  EXPECT_THROW(recorder.record(1e9, 1500, std::vector<double> { 1.0 }, false, 0.0),
+	       std::invalid_argument);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/result_batch.h>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <perplexcpp/utils.h>
+
+
+using namespace perplexcpp;
+
+
+class ResultBatchTest : public ::testing::Test {
+  protected:
+
+    void SetUp() override {
+      Wrapper::initialize("test.dat", "./simple", 10, 0.1);
+    }
+
+
+    const std::vector<QueryPoint> points = {
+      { utils::convert_bar_to_pascals(20000), 1500, {} },
+      { utils::convert_bar_to_pascals(25000), 1600, {} },
+      // outside the problem bounds
+      { utils::convert_bar_to_pascals(20000), 10000, {} },
+      { utils::convert_bar_to_pascals(30000), 1700, {} }
+    };
+};
+
+
+
+TEST_F(ResultBatchTest, MinimizeBatchMatchesMinimize)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+  const ResultBatch batch = minimize_batch(wrapper, points, 2);
+
+  ASSERT_EQ(batch.size(), points.size());
+  EXPECT_EQ(batch.n_solved(), 3);
+  EXPECT_EQ(batch.solved()[2], 0);
+  EXPECT_EQ(batch.density()[2], 0.0);
+
+  for (size_t i : { 0, 1, 3 }) {
+    EXPECT_EQ(batch.solved()[i], 1);
+
+    const MinimizeResult expected = 
+      wrapper.solve(points[i].pressure, points[i].temperature, 
+		    wrapper.initial_bulk_composition);
+    EXPECT_DOUBLE_EQ(batch.pressure()[i], expected.pressure);
+    EXPECT_DOUBLE_EQ(batch.density()[i], expected.density);
+    EXPECT_DOUBLE_EQ(batch.molar_heat_capacity()[i], expected.molar_heat_capacity);
+    EXPECT_DOUBLE_EQ(batch.composition(2)[i], expected.composition[2]);
+    for (const Phase& phase : expected.phases) {
+      EXPECT_DOUBLE_EQ(batch.phase_weight_frac(phase.id)[i], phase.weight_frac);
+      EXPECT_DOUBLE_EQ(batch.phase_composition_ratio(phase.id, 1)[i], 
+		       phase.composition_ratio[1]);
+    }
+  }
+}
+
+
+
+TEST_F(ResultBatchTest, SetAndGetRoundTrip)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+  const MinimizeResult expected = 
+    wrapper.minimize(points[0].pressure, points[0].temperature);
+
+  ResultBatch batch(wrapper, 2);
+  batch.set(1, expected);
+  EXPECT_EQ(batch.n_solved(), 1);
+
+  // Reuse a result holding a different point.
+  MinimizeResult result = wrapper.minimize(points[3].pressure, points[3].temperature);
+  EXPECT_THROW(batch.get(0, result), std::invalid_argument);
+  batch.get(1, result);
+
+  EXPECT_EQ(result.pressure, expected.pressure);
+  EXPECT_EQ(result.temperature, expected.temperature);
+  EXPECT_EQ(result.density, expected.density);
+  EXPECT_EQ(result.expansivity, expected.expansivity);
+  EXPECT_EQ(result.molar_entropy, expected.molar_entropy);
+  EXPECT_EQ(result.molar_heat_capacity, expected.molar_heat_capacity);
+  EXPECT_EQ(result.composition, expected.composition);
+  ASSERT_EQ(result.phases.size(), expected.phases.size());
+  for (size_t p = 0; p < result.phases.size(); ++p) {
+    EXPECT_EQ(result.phases[p].name.standard, expected.phases[p].name.standard);
+    EXPECT_EQ(result.phases[p].weight_frac, expected.phases[p].weight_frac);
+    EXPECT_EQ(result.phases[p].volume_frac, expected.phases[p].volume_frac);
+    EXPECT_EQ(result.phases[p].molar_frac, expected.phases[p].molar_frac);
+    EXPECT_EQ(result.phases[p].n_moles, expected.phases[p].n_moles);
+    EXPECT_EQ(result.phases[p].density, expected.phases[p].density);
+    EXPECT_EQ(result.phases[p].composition_ratio, expected.phases[p].composition_ratio);
+  }
+}
+
+
+
+TEST_F(ResultBatchTest, SaveAndLoad)
+{
+  const std::string filename = "result_batch_test.bin";
+  const ResultBatch batch = minimize_batch(Wrapper::get_instance(), points, 2);
+  batch.save(filename);
+
+  const ResultBatch loaded = ResultBatch::load(filename);
+  std::remove(filename.c_str());
+
+  EXPECT_EQ(loaded.get_problem_hash(), batch.get_problem_hash());
+  EXPECT_EQ(loaded.get_component_names(), batch.get_component_names());
+  ASSERT_EQ(loaded.n_phases(), batch.n_phases());
+  EXPECT_EQ(loaded.get_phase_names()[1].full, batch.get_phase_names()[1].full);
+  ASSERT_EQ(loaded.size(), batch.size());
+  EXPECT_EQ(loaded.n_solved(), batch.n_solved());
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    EXPECT_EQ(loaded.temperature()[i], batch.temperature()[i]);
+    EXPECT_EQ(loaded.expansivity()[i], batch.expansivity()[i]);
+    EXPECT_EQ(loaded.composition(3)[i], batch.composition(3)[i]);
+    EXPECT_EQ(loaded.phase_density(3)[i], batch.phase_density(3)[i]);
+    EXPECT_EQ(loaded.phase_composition_ratio(2, 3)[i], 
+	      batch.phase_composition_ratio(2, 3)[i]);
+  }
+}
@@ -169,3 +169,390 @@ TEST(ResultCacheTest, GetRecordsHitsAndMisses)
   EXPECT_EQ(cache.get_n_hits(), 3);
   EXPECT_EQ(cache.get_n_misses(), 2);
 }
+
+
+
+TEST(ResultCacheTest, LookupReturnsStoredResult)
+{
+  auto cache = ResultCache(3);
+
+  const MinimizeResult item { 
+    2.05e8, 
+    1788, 
+    std::vector<double>(2, 5.1), 
+    std::vector<Phase> {
+      Phase { 3, PhaseName { "O(HGP)", "Ol", "olivine" }, 
+              0.1, 0.2, 0.3, 4.0, std::vector<double> { 1.5, 2.5 }, 3300 }
+    }, 
+    1.2, 1.0, 2.0, 3.0 
+  };
+  cache.put(item);
+
+  const ResultView* view = cache.lookup(2.05e8, 1788, std::vector<double>(2, 5.1));
+  ASSERT_NE(view, nullptr);
+
+  EXPECT_EQ(view->density(), 1.2);
+  EXPECT_EQ(view->composition()[1], 5.1);
+  ASSERT_EQ(view->n_phases(), 1);
+  EXPECT_EQ(view->phase_id(0), 3);
+  EXPECT_STREQ(view->phase_name(0).full.c_str(), "olivine");
+  EXPECT_EQ(view->phase_n_moles(0), 4.0);
+  EXPECT_EQ(view->phase_composition_ratio(0, 1), 2.5);
+
+  MinimizeResult result;
+  ASSERT_EQ(cache.get(2.05e8, 1788, std::vector<double>(2, 5.1), result), 0);
+  ASSERT_EQ(result.phases.size(), 1);
+  EXPECT_STREQ(result.phases[0].name.abbreviated.c_str(), "Ol");
+  EXPECT_EQ(result.phases[0].composition_ratio[0], 1.5);
+  EXPECT_EQ(result.phases[0].density, 3300);
+}
+
+
+
+TEST(ResultCacheTest, LookupMovesItemToFront)
+{
+  auto cache = ResultCache(2);
+
+  for (int i = 0; i < 2; ++i)
+    cache.put(MinimizeResult { 
+      2.0e8, 
+      1000.0 + i, 
+      std::vector<double>(2, 1.0), 
+      std::vector<Phase>(), 
+      1.2, 1.0, 2.0, 3.0 
+    });
+
+  // Using the oldest item means that the other one is evicted instead.
+  ASSERT_NE(cache.lookup(2.0e8, 1000, std::vector<double>(2, 1.0)), nullptr);
+  cache.put(MinimizeResult { 
+    2.0e8, 
+    1002, 
+    std::vector<double>(2, 1.0), 
+    std::vector<Phase>(), 
+    1.2, 1.0, 2.0, 3.0 
+  });
+
+  EXPECT_NE(cache.lookup(2.0e8, 1000, std::vector<double>(2, 1.0)), nullptr);
+  EXPECT_EQ(cache.lookup(2.0e8, 1001, std::vector<double>(2, 1.0)), nullptr);
+}
+
+
+
+TEST(ResultCacheTest, GreedyDualSizeKeepsExpensiveItems)
+{
+  auto cache = ResultCache(2);
+  cache.set_eviction_policy(EvictionPolicy::greedy_dual_size);
+
+  const std::vector<double> solve_times { 10.0, 0.01, 0.01 };
+  for (int i = 0; i < 3; ++i)
+    cache.put(MinimizeResult { 
+      2.0e8, 
+      1000.0 + i, 
+      std::vector<double>(2, 1.0), 
+      std::vector<Phase>(), 
+      1.2, 1.0, 2.0, 3.0 
+    }, solve_times[i]);
+
+  // LRU would evict the oldest item but it is the most expensive.
+  EXPECT_NE(cache.lookup(2.0e8, 1000, std::vector<double>(2, 1.0)), nullptr);
+  EXPECT_EQ(cache.lookup(2.0e8, 1001, std::vector<double>(2, 1.0)), nullptr);
+  EXPECT_NE(cache.lookup(2.0e8, 1002, std::vector<double>(2, 1.0)), nullptr);
+}
+
+
+
+TEST(ResultCacheTest, PutRespectsByteBudget)
+{
+  auto cache = ResultCache(100);
+
+  const MinimizeResult item { 
+    2.0e8, 
+    1000.0, 
+    std::vector<double>(2, 1.0), 
+    std::vector<Phase>(), 
+    1.2, 1.0, 2.0, 3.0 
+  };
+  cache.put(item);
+  const size_t item_size = cache.get_n_bytes();
+  ASSERT_GT(item_size, 0);
+
+  cache.set_max_bytes(3 * item_size);
+  for (int i = 1; i < 10; ++i)
+  {
+    MinimizeResult other = item;
+    other.temperature += i;
+    cache.put(other);
+  }
+
+  EXPECT_EQ(cache.size(), 3);
+  EXPECT_LE(cache.get_n_bytes(), 3 * item_size);
+
+  // Shrinking the budget evicts immediately.
+  cache.set_max_bytes(item_size);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+
+
+TEST(ResultCacheTest, GetRecordsSolveTimeSaved)
+{
+  auto cache = ResultCache(3);
+
+  const MinimizeResult item { 
+    2.0e8, 
+    1000.0, 
+    std::vector<double>(2, 1.0), 
+    std::vector<Phase>(), 
+    1.2, 1.0, 2.0, 3.0 
+  };
+  cache.put(item, 0.5);
+
+  MinimizeResult result;
+  ASSERT_EQ(cache.get(2.0e8, 1000.0, std::vector<double>(2, 1.0), result), 0);
+  ASSERT_EQ(cache.get(2.0e8, 1000.0, std::vector<double>(2, 1.0), result), 0);
+
+  EXPECT_DOUBLE_EQ(cache.get_solve_time_spent(), 0.5);
+  EXPECT_DOUBLE_EQ(cache.get_solve_time_saved(), 1.0);
+
+  cache.reset_counters();
+  EXPECT_EQ(cache.get_solve_time_saved(), 0.0);
+}
+
+
+
+TEST(ResultCacheTest, GetRescalesNormalizedComposition)
+{
+  auto cache = ResultCache(3);
+  cache.set_normalize_composition(true);
+
+  const MinimizeResult item { 
+    2.0e8, 
+    1000.0, 
+    std::vector<double> { 1.0, 3.0 }, 
+    std::vector<Phase> {
+      Phase { 3, PhaseName { "O(HGP)", "Ol", "olivine" }, 
+              0.1, 0.2, 0.3, 4.0, std::vector<double> { 1.5, 2.5 }, 3300 }
+    }, 
+    1.2, 1.0, 2.0, 3.0 
+  };
+  cache.put(item);
+
+  MinimizeResult result;
+  ASSERT_EQ(cache.get(2.0e8, 1000.0, std::vector<double> { 0.3, 0.9 }, result), 0);
+
+  EXPECT_NEAR(result.composition[1], 0.9, 1e-12);
+  EXPECT_EQ(result.density, 1.2);
+  EXPECT_NEAR(result.molar_entropy, 0.6, 1e-12);
+  EXPECT_NEAR(result.molar_heat_capacity, 0.9, 1e-12);
+  ASSERT_EQ(result.phases.size(), 1);
+  EXPECT_EQ(result.phases[0].molar_frac, 0.3);
+  EXPECT_NEAR(result.phases[0].n_moles, 1.2, 1e-12);
+
+  // Different proportions still miss.
+  EXPECT_EQ(cache.get(2.0e8, 1000.0, std::vector<double> { 0.3, 1.2 }, result), -1);
+
+  cache.set_normalize_composition(false);
+  EXPECT_EQ(cache.get(2.0e8, 1000.0, std::vector<double> { 0.3, 0.9 }, result), -1);
+}
+
+
+
+namespace
+{
+
+MinimizeResult
+make_result(const double temperature, 
+	    const double density, 
+	    const double olivine_frac, 
+	    const double garnet_frac)
+{
+  return MinimizeResult {
+    2.0e8,
+    temperature,
+    std::vector<double>(2, 1.0),
+    std::vector<Phase> {
+      Phase { 0, PhaseName { "O(HGP)", "Ol", "olivine" }, 
+              olivine_frac, olivine_frac, olivine_frac, 1.0, 
+	      std::vector<double>(2, 0.5), 3300 },
+      Phase { 1, PhaseName { "Gt(HGP)", "Gt", "garnet" }, 
+              garnet_frac, garnet_frac, garnet_frac, 1.0, 
+	      std::vector<double>(2, 0.5), 3600 }
+    },
+    density, 1.0, 2.0, 3.0
+  };
+}
+
+}  // namespace
+
+
+
+TEST(ResultCacheTest, AdaptiveToleranceAcceptsFlatRegions)
+{
+  auto cache = ResultCache(10, 0.05);
+  cache.set_error_tolerance(1e-3);
+
+  cache.put(make_result(1000, 3300, 0.5, 0.5));
+  cache.put(make_result(1010, 3300.01, 0.5, 0.5));
+
+  MinimizeResult result;
+  EXPECT_EQ(cache.get(2.0e8, 1005, std::vector<double>(2, 1.0), result), 0);
+}
+
+
+
+TEST(ResultCacheTest, AdaptiveToleranceRejectsSteepRegions)
+{
+  auto cache = ResultCache(10, 0.05);
+  cache.set_error_tolerance(1e-3);
+
+  cache.put(make_result(1000, 3300, 0.5, 0.5));
+  cache.put(make_result(1010, 3300, 0.4, 0.6));
+
+  MinimizeResult result;
+  EXPECT_EQ(cache.get(2.0e8, 1005, std::vector<double>(2, 1.0), result), -1);
+
+  // Exact matches are always accepted.
+  EXPECT_EQ(cache.get(2.0e8, 1010, std::vector<double>(2, 1.0), result), 0);
+}
+
+
+
+TEST(ResultCacheTest, AdaptiveToleranceRespectsPhaseBoundaries)
+{
+  auto cache = ResultCache(10, 0.05);
+  cache.set_error_tolerance(1e-3);
+
+  cache.put(make_result(990, 3300, 0.5, 0.5));
+  cache.put(make_result(1000, 3300, 0.5, 0.5));
+  cache.put(make_result(1010, 3300, 1.0, 0.0));
+
+  MinimizeResult result;
+  EXPECT_EQ(cache.get(2.0e8, 998, std::vector<double>(2, 1.0), result), 0);
+  EXPECT_EQ(result.temperature, 1000);
+
+  // This is closer to the boundary than half the distance between the items.
+  EXPECT_EQ(cache.get(2.0e8, 1006, std::vector<double>(2, 1.0), result), -1);
+}
+
+
+
+namespace
+{
+
+MinimizeResult
+make_many_phase_result(const size_t n_phases, const size_t n_present)
+{
+  MinimizeResult result { 
+    2.0e8, 1000.0, std::vector<double>(6, 1.0), std::vector<Phase>(), 
+    3300, 3e-5, 1.2e4, 6.2e3
+  };
+
+  for (size_t p = 0; p < n_phases; ++p) {
+    const std::string name = "phase" + std::to_string(p);
+    Phase phase { p, PhaseName { name, name, name }, 
+                  0.0, 0.0, 0.0, 0.0, std::vector<double>(6, 0.0), 0.0 };
+
+    if (p < n_present) {
+      phase.weight_frac = 0.11 * (p+1);
+      phase.volume_frac = 0.12 * (p+1);
+      phase.molar_frac = 0.13 * (p+1);
+      phase.n_moles = 4.1 * (p+1);
+      phase.density = 3200 + p;
+      for (size_t c = 0; c < 6; ++c)
+	phase.composition_ratio[c] = 0.3 * c + 0.01 * p;
+    }
+    result.phases.push_back(phase);
+  }
+  return result;
+}
+
+}  // namespace
+
+
+
+TEST(ResultCacheTest, CompactEncodingsRoundTrip)
+{
+  const MinimizeResult item = make_many_phase_result(4, 2);
+
+  for (ResultEncoding encoding : { ResultEncoding::float32, ResultEncoding::fixed16 })
+  {
+    auto cache = ResultCache(3);
+    cache.set_encoding(encoding);
+    cache.put(item);
+
+    MinimizeResult result;
+    ASSERT_EQ(cache.get(2.0e8, 1000.0, std::vector<double>(6, 1.0), result), 0);
+
+    EXPECT_EQ(result.density, item.density);
+    EXPECT_EQ(result.expansivity, item.expansivity);
+    ASSERT_EQ(result.phases.size(), 4);
+    for (size_t p = 0; p < 4; ++p) {
+      const Phase& expected = item.phases[p];
+      const Phase& actual = result.phases[p];
+
+      EXPECT_EQ(actual.id, p);
+      EXPECT_STREQ(actual.name.full.c_str(), expected.name.full.c_str());
+      EXPECT_NEAR(actual.weight_frac, expected.weight_frac, 8e-6);
+      EXPECT_NEAR(actual.volume_frac, expected.volume_frac, 8e-6);
+      EXPECT_NEAR(actual.molar_frac, expected.molar_frac, 8e-6);
+      EXPECT_NEAR(actual.n_moles, expected.n_moles, 1e-6);
+      EXPECT_NEAR(actual.density, expected.density, 1e-3);
+      ASSERT_EQ(actual.composition_ratio.size(), 6);
+      for (size_t c = 0; c < 6; ++c)
+	EXPECT_NEAR(actual.composition_ratio[c], expected.composition_ratio[c], 2e-5);
+    }
+  }
+}
+
+
+
+TEST(ResultCacheTest, CompactEncodingKeepsTracePhases)
+{
+  MinimizeResult item = make_many_phase_result(3, 2);
+  item.phases[1].weight_frac = 1e-7;
+  item.phases[1].volume_frac = 2e-7;
+  item.phases[1].molar_frac = 3e-7;
+
+  auto cache = ResultCache(3);
+  cache.set_encoding(ResultEncoding::fixed16);
+  cache.put(item);
+
+  MinimizeResult result;
+  ASSERT_EQ(cache.get(2.0e8, 1000.0, std::vector<double>(6, 1.0), result), 0);
+
+  // The phase is still present and absent phases are still absent.
+  EXPECT_GT(result.phases[1].weight_frac, 0.0);
+  EXPECT_GT(result.phases[1].volume_frac, 0.0);
+  EXPECT_GT(result.phases[1].molar_frac, 0.0);
+  EXPECT_LT(result.phases[1].molar_frac, 2e-5);
+  EXPECT_EQ(result.phases[2].molar_frac, 0.0);
+}
+
+
+
+TEST(ResultCacheTest, CompactEncodingReducesFootprint)
+{
+  const MinimizeResult item = make_many_phase_result(20, 3);
+
+  auto cache = ResultCache(3);
+  cache.put(item);
+  const size_t full_size = cache.get_n_bytes();
+
+  auto compact_cache = ResultCache(3);
+  compact_cache.set_encoding(ResultEncoding::fixed16);
+  compact_cache.put(item);
+
+  EXPECT_GT(full_size, 4 * compact_cache.get_n_bytes());
+}
+
+
+
+TEST(ResultCacheTest, CompactEncodingRequiresOrderedPhases)
+{
+  auto cache = ResultCache(3);
+  cache.set_encoding(ResultEncoding::float32);
+  cache.set_phase_names({ PhaseName { "a", "a", "a" }, PhaseName { "b", "b", "b" } });
+
+  MinimizeResult item = make_many_phase_result(2, 2);
+  EXPECT_THROW(cache.put(item), std::invalid_argument);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/shared_memory_cache.h>
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+using namespace perplexcpp;
+
+
+namespace
+{
+  const std::vector<PhaseName> phase_names {
+    PhaseName { "O", "Ol", "olivine" }
+  };
+
+
+  MinimizeResult make_result(const double pressure, const double temperature)
+  {
+    return MinimizeResult {
+      pressure,
+      temperature,
+      std::vector<double> { 1.0, 2.0 },
+      std::vector<Phase> {
+	Phase { 0, phase_names[0], 1.0, 1.0, 1.0, 4.0,
+	        std::vector<double> { 0.1, 0.2 }, 3300 }
+      },
+      3300,
+      1.0,
+      2.0,
+      3.0
+    };
+  }
+
+
+  class SharedMemoryCacheTest : public ::testing::Test {
+    protected:
+      void SetUp() override { SharedMemoryCache::unlink(name); }
+
+      void TearDown() override { SharedMemoryCache::unlink(name); }
+
+      const std::string name = SharedMemoryCache::make_name(getpid());
+  };
+}
+
+
+
+TEST_F(SharedMemoryCacheTest, GetReturnsExactMatch)
+{
+  SharedMemoryCache cache(name, 1234, 2, phase_names, 16);
+  cache.put(make_result(2e9, 1500));
+
+  MinimizeResult result;
+  ASSERT_EQ(cache.get(2e9, 1500, std::vector<double> { 1.0, 2.0 }, result), 0);
+  EXPECT_EQ(result.density, 3300);
+  EXPECT_STREQ(result.phases[0].name.full.c_str(), "olivine");
+
+  EXPECT_EQ(cache.get(2e9, 1501, std::vector<double> { 1.0, 2.0 }, result), -1);
+  EXPECT_EQ(cache.get_n_hits(), 1);
+  EXPECT_EQ(cache.get_n_misses(), 1);
+}
+
+
+
+TEST_F(SharedMemoryCacheTest, ResultsAreSharedBetweenProcesses)
+{
+  SharedMemoryCache cache(name, 1234, 2, phase_names, 64);
+
+  // Each child process inserts its own results.
+  const int n_children = 4;
+  for (int i = 0; i < n_children; ++i) {
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      SharedMemoryCache child_cache(name, 1234, 2, phase_names);
+      for (int j = 0; j < 10; ++j)
+	child_cache.put(make_result(2e9, 1000 + 10*i + j));
+      _exit(0);
+    }
+  }
+
+  for (int i = 0; i < n_children; ++i) {
+    int status;
+    wait(&status);
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+  }
+
+  EXPECT_EQ(cache.size(), 40);
+
+  MinimizeResult result;
+  for (int t = 1000; t < 1040; ++t)
+    EXPECT_EQ(cache.get(2e9, t, std::vector<double> { 1.0, 2.0 }, result), 0);
+}
+
+
+
+TEST_F(SharedMemoryCacheTest, ConstructorThrowsForDifferentProblem)
+{
+  SharedMemoryCache cache(name, 1234, 2, phase_names, 16);
+
+  EXPECT_THROW(SharedMemoryCache(name, 4321, 2, phase_names), std::runtime_error);
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/solver_stats.h>
+
+#include <gtest/gtest.h>
+
+
+using namespace perplexcpp;
+
+
+TEST(LatencyHistogramTest, CheckEmpty)
+{
+  LatencyHistogram hist;
+  EXPECT_EQ(hist.count(), 0);
+  EXPECT_EQ(hist.mean(), 0.0);
+  EXPECT_EQ(hist.percentile(0.5), 0.0);
+}
+
+
+TEST(LatencyHistogramTest, CheckPercentiles)
+{
+  LatencyHistogram hist;
+  for (int i = 1; i <= 1000; ++i)
+    hist.record(i * 1e-6);
+
+  EXPECT_EQ(hist.count(), 1000);
+  EXPECT_NEAR(hist.mean(), 500.5e-6, 1e-12);
+  EXPECT_DOUBLE_EQ(hist.max(), 1000e-6);
+
+  // The percentiles are bucket upper bounds so lie within 12.5% above the
+  // exact values.
+  EXPECT_GE(hist.percentile(0.5), 500e-6);
+  EXPECT_LE(hist.percentile(0.5), 500e-6 * 1.125);
+  EXPECT_GE(hist.percentile(0.99), 990e-6);
+  EXPECT_LE(hist.percentile(0.99), 1000e-6);
+  EXPECT_DOUBLE_EQ(hist.percentile(1.0), 1000e-6);
+}
+
+
+TEST(LatencyHistogramTest, CheckSmallAndLargeValues)
+{
+  LatencyHistogram hist;
+  hist.record(0.0);
+  hist.record(3e-9);
+  hist.record(1e9);
+
+  EXPECT_EQ(hist.percentile(0.3), 0.0);
+  EXPECT_DOUBLE_EQ(hist.percentile(0.6), 3e-9);
+  EXPECT_DOUBLE_EQ(hist.percentile(1.0), 1e9);
+}
+
+
+TEST(LatencyHistogramTest, CheckMerge)
+{
+  LatencyHistogram a, b;
+  a.record(1e-3);
+  b.record(2e-3);
+  b.record(3e-3);
+
+  a.merge(b);
+  EXPECT_EQ(a.count(), 3);
+  EXPECT_NEAR(a.mean(), 2e-3, 1e-12);
+  EXPECT_DOUBLE_EQ(a.max(), 3e-3);
+
+  a.reset();
+  EXPECT_EQ(a.count(), 0);
+}
+
+
+TEST(SolverStatsTest, CheckRecord)
+{
+  SolveCounters solved = { 10, 2, 100, 50, false, {} };
+  SolveCounters hit = { 0, 0, 0, 0, true, {} };
+
+  SolverStats stats;
+  stats.record(solved, 1e-3);
+  stats.record(solved, 2e-3);
+  stats.record(hit, 1e-6);
+
+  EXPECT_EQ(stats.n_calls, 3);
+  EXPECT_EQ(stats.n_cache_hits, 1);
+  EXPECT_EQ(stats.n_solves(), 2);
+  EXPECT_EQ(stats.lp_iterations, 20);
+  EXPECT_EQ(stats.n_dynamic_compounds, 100);
+  EXPECT_EQ(stats.latency.count(), 3);
+  EXPECT_EQ(stats.solve_latency.count(), 2);
+
+  SolverStats total;
+  total += stats;
+  total += stats;
+  EXPECT_EQ(total.n_calls, 6);
+  EXPECT_EQ(total.hit_latency.count(), 2);
+
+  EXPECT_NE(stats.to_text().find("cache hits           1 (33.3%)"), std::string::npos);
+  EXPECT_NE(stats.to_json().find("\"lp_iterations\": 20"), std::string::npos);
+}
+
+
+
+TEST(SolverStatsTest, CheckHardware)
+{
+  SolveCounters solved = { 10, 2, 100, 50, false, { 1000, 2000, 10, 20 } };
+
+  SolverStats stats;
+  EXPECT_EQ(stats.to_text().find("hardware"), std::string::npos);
+
+  stats.record(solved, 1e-3);
+  stats.record(solved, 1e-3);
+  EXPECT_EQ(stats.solve_hardware.cycles, 2000);
+  EXPECT_EQ(stats.hit_hardware.cycles, 0);
+
+  EXPECT_NE(stats.to_text().find("hardware"), std::string::npos);
+  EXPECT_NE(stats.to_json().find("\"solve_hardware\": {\"cycles\": 2000"), 
+	    std::string::npos);
+}
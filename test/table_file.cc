@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/table_file.h>
+
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+using namespace perplexcpp;
+
+
+class TableFileTest : public ::testing::Test {
+  protected:
+
+    void SetUp() override {
+      // ctest runs the tests in parallel so each needs its own file.
+      filename = std::string("table_file_") + 
+		 ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+
+      TableWriter writer("TestTable", 1234);
+      writer.add_axis("pressure", "Pa", 3, 1e9, 2e9);
+      writer.add_array("density", "kg/m3", doubles.data(), doubles.size());
+      writer.add_array("nodes", "", integers.data(), integers.size());
+      writer.write(filename);
+    }
+
+
+    void TearDown() override {
+      std::remove(filename.c_str());
+    }
+
+
+    std::string filename;
+
+    const std::vector<double> doubles = { 3000.0, 3100.0, 3200.0 };
+
+    const std::vector<std::uint32_t> integers = { 1, 2, 3, 4, 5 };
+};
+
+
+
+TEST_F(TableFileTest, RoundTrip)
+{
+  const TableReader reader(filename, "TestTable");
+
+  EXPECT_EQ(reader.get_problem_hash(), 1234);
+
+  ASSERT_EQ(reader.get_axes().size(), 1);
+  const TableAxis& axis = reader.get_axis("pressure");
+  EXPECT_EQ(axis.units, "Pa");
+  EXPECT_EQ(axis.size, 3);
+  EXPECT_EQ(axis.min, 1e9);
+  EXPECT_EQ(axis.max, 2e9);
+
+  ASSERT_EQ(reader.get_arrays().size(), 2);
+  EXPECT_EQ(reader.get_array("density").units, "kg/m3");
+
+  const double* density = reader.get_doubles("density", doubles.size());
+  EXPECT_EQ(std::vector<double>(density, density + doubles.size()), doubles);
+
+  const std::uint32_t* nodes = reader.get_uint32s("nodes", integers.size());
+  EXPECT_EQ(std::vector<std::uint32_t>(nodes, nodes + integers.size()), integers);
+}
+
+
+
+TEST_F(TableFileTest, ArraysAreAligned)
+{
+  const TableReader reader(filename, "TestTable");
+
+  for (const TableArray& array : reader.get_arrays())
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(array.data) % 64, 0);
+}
+
+
+
+TEST_F(TableFileTest, CheckArrayTypeAndSize)
+{
+  const TableReader reader(filename, "TestTable");
+
+  EXPECT_THROW(reader.get_doubles("nodes", integers.size()), std::runtime_error);
+  EXPECT_THROW(reader.get_doubles("density", 2), std::runtime_error);
+  EXPECT_THROW(reader.get_array("missing"), std::runtime_error);
+  EXPECT_THROW(reader.get_axis("temperature"), std::runtime_error);
+}
+
+
+
+TEST_F(TableFileTest, RejectWrongKind)
+{
+  EXPECT_THROW(TableReader(filename, "OtherTable"), std::runtime_error);
+}
+
+
+
+TEST_F(TableFileTest, RejectTruncatedFile)
+{
+  std::vector<char> contents;
+  {
+    std::ifstream file(filename, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(file), 
+		    std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size() - 8);
+  }
+
+  EXPECT_THROW(TableReader(filename, "TestTable"), std::runtime_error);
+}
+
+
+
+TEST(TableWriterTest, RejectLongNames)
+{
+  TableWriter writer("TestTable", 0);
+  EXPECT_THROW(writer.add_axis(std::string(40, 'x'), "", 2, 0, 1), 
+	       std::invalid_argument);
+}
+
+
+
+TEST(TableWriterTest, StringsRoundTrip)
+{
+  const std::string filename = "table_file_strings.bin";
+  const std::vector<std::string> strings = { "Cpx(HGP)", "", "melt(HGP)" };
+  {
+    TableWriter writer("TestTable", 0);
+    writer.add_strings("names", strings);
+    writer.write(filename);
+  }
+
+  const TableReader reader(filename, "TestTable");
+  EXPECT_EQ(reader.get_strings("names"), strings);
+  std::remove(filename.c_str());
+}
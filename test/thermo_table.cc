@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <perplexcpp/thermo_table.h>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <limits>
+#include <memory>
+
+
+using namespace perplexcpp;
+
+
+class ThermoTableTest : public ::testing::Test {
+  protected:
+
+    void SetUp() override {
+      Wrapper::initialize("test.dat", "./simple", 10, 0.1);
+
+      // Building the table is expensive so share it between the tests.
+      if (!table)
+	table.reset(new ThermoTable(Wrapper::get_instance(), 5, 6, {}, {}, 2));
+    }
+
+
+    static std::unique_ptr<ThermoTable> table;
+};
+
+
+std::unique_ptr<ThermoTable> ThermoTableTest::table;
+
+
+
+TEST_F(ThermoTableTest, GridPointsMatchSolver)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+
+  const double pressure = table->min_pressure + 
+			  2 * (table->max_pressure - table->min_pressure) / 4;
+  const double temperature = table->min_temperature + 
+			     3 * (table->max_temperature - table->min_temperature) / 5;
+  const MinimizeResult expected = 
+    wrapper.solve(pressure, temperature, wrapper.initial_bulk_composition);
+
+  EXPECT_NEAR(table->get(ThermoProperty::density, 2, 3), expected.density, 1e-8);
+  EXPECT_NEAR(table->get(ThermoProperty::molar_heat_capacity, 2, 3), 
+	      expected.molar_heat_capacity, 1e-8);
+
+  for (Interpolation interpolation : { Interpolation::bilinear, Interpolation::bicubic }) {
+    table->set_interpolation(interpolation);
+    EXPECT_NEAR(table->interpolate(ThermoProperty::density, pressure, temperature), 
+		expected.density, 1e-6);
+  }
+  table->set_interpolation(Interpolation::bilinear);
+}
+
+
+
+TEST_F(ThermoTableTest, InterpolationIsCloseToSolver)
+{
+  const Wrapper& wrapper = Wrapper::get_instance();
+
+  const double pressure = 0.37 * table->min_pressure + 0.63 * table->max_pressure;
+  const double temperature = 0.55 * table->min_temperature + 0.45 * table->max_temperature;
+  const MinimizeResult expected = 
+    wrapper.solve(pressure, temperature, wrapper.initial_bulk_composition);
+
+  for (Interpolation interpolation : { Interpolation::bilinear, Interpolation::bicubic }) {
+    table->set_interpolation(interpolation);
+    const ThermoProperties properties = table->interpolate(pressure, temperature);
+
+    EXPECT_NEAR(properties.density, expected.density, 0.01 * expected.density);
+    EXPECT_GE(properties.melt_fraction, -1e-6);
+    EXPECT_LE(properties.melt_fraction, 1 + 1e-6);
+  }
+  table->set_interpolation(Interpolation::bilinear);
+}
+
+
+
+TEST_F(ThermoTableTest, InterpolateThrowsOutsideTable)
+{
+  EXPECT_THROW(table->interpolate(ThermoProperty::density, 
+				  2 * table->max_pressure, table->min_temperature),
+	       std::invalid_argument);
+  EXPECT_THROW(table->interpolate(table->min_pressure, table->min_temperature - 1),
+	       std::invalid_argument);
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(table->interpolate(nan, table->min_temperature), std::invalid_argument);
+  EXPECT_THROW(table->interpolate(ThermoProperty::density, table->min_pressure, nan),
+	       std::invalid_argument);
+}
+
+
+
+TEST_F(ThermoTableTest, BatchMatchesPointwiseInterpolation)
+{
+  // Use an odd number of points so that the vectorized kernels leave a remainder
+  // and include the table corners.
+  std::vector<double> pressures, temperatures;
+  for (size_t n = 0; n < 11; ++n) {
+    pressures.push_back(table->min_pressure + 
+			(table->max_pressure - table->min_pressure) * n / 10.0);
+    temperatures.push_back(table->max_temperature - 
+			   (table->max_temperature - table->min_temperature) * n * n / 100.0);
+  }
+
+  for (Interpolation interpolation : { Interpolation::bilinear, Interpolation::bicubic }) {
+    table->set_interpolation(interpolation);
+
+    std::vector<double> density(pressures.size()), melt_fraction(pressures.size());
+    double* const out[n_thermo_properties] = { 
+      density.data(), nullptr, nullptr, nullptr, melt_fraction.data() 
+    };
+    table->interpolate(pressures.size(), pressures.data(), temperatures.data(), out);
+
+    for (size_t n = 0; n < pressures.size(); ++n) {
+      const ThermoProperties expected = 
+	table->interpolate(pressures[n], temperatures[n]);
+      EXPECT_NEAR(density[n], expected.density, 1e-9 * expected.density);
+      EXPECT_NEAR(melt_fraction[n], expected.melt_fraction, 1e-12);
+    }
+  }
+  table->set_interpolation(Interpolation::bilinear);
+
+  const double outside = 2 * table->max_pressure;
+  double value;
+  double* const out[n_thermo_properties] = { &value, nullptr, nullptr, nullptr, nullptr };
+  EXPECT_THROW(table->interpolate(1, &outside, temperatures.data(), out),
+	       std::invalid_argument);
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(table->interpolate(1, &nan, temperatures.data(), out),
+	       std::invalid_argument);
+}
+
+
+
+TEST_F(ThermoTableTest, SaveAndLoad)
+{
+  const std::string filename = "thermo_table.bin";
+  table->save(filename);
+  const ThermoTable loaded = ThermoTable::load(filename);
+  std::remove(filename.c_str());
+
+  EXPECT_EQ(loaded.problem_hash, table->problem_hash);
+  ASSERT_EQ(loaded.n_pressures, table->n_pressures);
+  ASSERT_EQ(loaded.n_temperatures, table->n_temperatures);
+  EXPECT_EQ(loaded.max_temperature, table->max_temperature);
+  EXPECT_EQ(loaded.composition, table->composition);
+  for (size_t i = 0; i < loaded.n_pressures; ++i)
+    for (size_t j = 0; j < loaded.n_temperatures; ++j)
+      EXPECT_EQ(loaded.get(ThermoProperty::melt_fraction, i, j),
+		table->get(ThermoProperty::melt_fraction, i, j));
+
+  // The interleaved copy of a loaded table is built by its first batch.
+  const std::vector<double> pressures { table->min_pressure, 0.5 * table->max_pressure,
+					table->max_pressure };
+  const std::vector<double> temperatures { table->min_temperature, 1500, 
+					   table->max_temperature };
+  std::vector<double> expected(3), density(3);
+  double* out[n_thermo_properties] = { expected.data() };
+  table->interpolate(3, pressures.data(), temperatures.data(), out);
+  out[0] = density.data();
+  loaded.interpolate(3, pressures.data(), temperatures.data(), out);
+  EXPECT_EQ(density, expected);
+}
@@ -20,8 +20,12 @@
 
 #include <perplexcpp/wrapper.h>
 
+#include <cstdio>
 #include <gtest/gtest.h>
+#include <perplexcpp/interpolating_cache.h>
+#include <perplexcpp/query_trace.h>
 #include <perplexcpp/utils.h>
+#include <unistd.h>
 
 
 using namespace perplexcpp;
@@ -49,6 +53,18 @@ class WrapperSimpleDataTest : public ::testing::Test {
 
 
 
+TEST_F(WrapperSimpleDataTest, InitializeWithMissingFileKeepsDirectory)
+{
+  char before[256], after[256];
+  ASSERT_NE(getcwd(before, sizeof(before)), nullptr);
+
+  EXPECT_THROW(Wrapper::initialize("missing.dat", "./simple"), std::runtime_error);
+
+  ASSERT_NE(getcwd(after, sizeof(after)), nullptr);
+  EXPECT_STREQ(after, before);
+}
+
+
 TEST_F(WrapperSimpleDataTest, CheckNCompositionComponents)
 {
   EXPECT_EQ(Wrapper::get_instance().n_composition_components, 4);
@@ -264,3 +280,310 @@ TEST_F(WrapperSimpleDataTest, CheckResultCompositionsSumToBulkComposition)
 
   EXPECT_NEAR(phase_sum, bulk_sum, 1e-8);
 }
+
+
+
+TEST_F(WrapperSimpleDataTest, CheckCacheBackendIsUsed)
+{
+  auto& wrapper = Wrapper::get_instance();
+
+  auto backend = std::make_shared<InterpolatingCache>(
+    10, 1, 0.2, wrapper.max_pressure, wrapper.max_temperature);
+  wrapper.set_cache_backend(backend);
+
+  // The second temperature lies outside of the tolerance of the LRU cache.
+  const double pressure = utils::convert_bar_to_pascals(25000);
+  wrapper.minimize(pressure, 1600);
+  MinimizeResult cached = wrapper.minimize(pressure, 1800);
+
+  wrapper.set_cache_backend(nullptr);
+
+  EXPECT_EQ(backend->size(), 1);
+  EXPECT_EQ(backend->get_n_hits(), 1);
+  EXPECT_EQ(cached.phases.size(), 4);
+}
+
+
+
+TEST_F(WrapperSimpleDataTest, CheckCacheBackendHitHasNoCounters)
+{
+  auto& wrapper = Wrapper::get_instance();
+
+  auto backend = std::make_shared<InterpolatingCache>(
+    10, 1, 0.2, wrapper.max_pressure, wrapper.max_temperature);
+  wrapper.set_cache_backend(backend);
+  wrapper.set_profiling(true);
+
+  // The second temperature lies outside of the tolerance of the LRU cache.
+  const double pressure = utils::convert_bar_to_pascals(35000);
+  wrapper.minimize(pressure, 1500);
+  const SolveCounters solved = wrapper.get_last_counters();
+  const SolveProfile solved_profile = wrapper.get_last_profile();
+
+  wrapper.minimize(pressure, 1700);
+  const SolveCounters& cached = wrapper.get_last_counters();
+  const SolveProfile& cached_profile = wrapper.get_last_profile();
+
+  wrapper.set_profiling(false);
+  wrapper.set_cache_backend(nullptr);
+
+  EXPECT_FALSE(solved.cache_hit);
+  EXPECT_GT(solved.lp_iterations, 0);
+  EXPECT_EQ(solved_profile.n_solves, 1);
+
+  EXPECT_TRUE(cached.cache_hit);
+  EXPECT_EQ(cached.lp_iterations, 0);
+  EXPECT_EQ(cached.reopt_iterations, 0);
+  EXPECT_EQ(cached.n_static_compounds, 0);
+  EXPECT_EQ(cached.n_dynamic_compounds, 0);
+  EXPECT_EQ(cached_profile.n_solves, 0);
+  EXPECT_EQ(cached_profile.total_time, 0.0);
+}
+
+
+
+TEST_F(WrapperSimpleDataTest, CheckNormalizedCacheRescalesResult)
+{
+  auto& wrapper = Wrapper::get_instance();
+  auto& cache = wrapper.get_cache();
+
+  const double pressure = utils::convert_bar_to_pascals(30000);
+  const double temperature = 1700;
+
+  const std::vector<double> composition = wrapper.initial_bulk_composition;
+  std::vector<double> scaled;
+  for (double c : composition)
+    scaled.push_back(3.0 * c);
+
+  // Solve both compositions. The unscaled result is the most recently used.
+  const MinimizeResult expected = wrapper.minimize(pressure, temperature, scaled);
+  wrapper.minimize(pressure, temperature, composition);
+
+  cache.set_normalize_composition(true);
+  cache.reset_counters();
+  const MinimizeResult cached = wrapper.minimize(pressure, temperature, scaled);
+  cache.set_normalize_composition(false);
+
+  EXPECT_EQ(cache.get_n_hits(), 1);
+  EXPECT_NEAR(cached.density, expected.density, 1e-6 * expected.density);
+  EXPECT_NEAR(cached.molar_entropy, expected.molar_entropy, 1e-6 * expected.molar_entropy);
+  EXPECT_NEAR(cached.molar_heat_capacity, expected.molar_heat_capacity,
+	      1e-6 * expected.molar_heat_capacity);
+  ASSERT_EQ(cached.phases.size(), expected.phases.size());
+  for (size_t p = 0; p < cached.phases.size(); ++p)
+    EXPECT_NEAR(cached.phases[p].n_moles, expected.phases[p].n_moles, 1e-6);
+}
+
+
+
+TEST_F(WrapperSimpleDataTest, CheckCompactCacheEncoding)
+{
+  auto& wrapper = Wrapper::get_instance();
+  auto& cache = wrapper.get_cache();
+
+  const double pressure = utils::convert_bar_to_pascals(35000);
+  const double temperature = 1650;
+
+  cache.set_encoding(ResultEncoding::fixed16);
+  const MinimizeResult expected = wrapper.minimize(pressure, temperature);
+  cache.reset_counters();
+  const MinimizeResult cached = wrapper.minimize(pressure, temperature);
+  cache.set_encoding(ResultEncoding::float64);
+
+  EXPECT_EQ(cache.get_n_hits(), 1);
+  ASSERT_EQ(cached.phases.size(), wrapper.n_phases);
+  for (size_t p = 0; p < cached.phases.size(); ++p) {
+    EXPECT_STREQ(cached.phases[p].name.standard.c_str(), 
+		 wrapper.phase_names[p].standard.c_str());
+    EXPECT_NEAR(cached.phases[p].molar_frac, expected.phases[p].molar_frac, 8e-6);
+    EXPECT_NEAR(cached.phases[p].n_moles, expected.phases[p].n_moles, 
+		1e-6 * expected.phases[p].n_moles);
+  }
+}
+
+
+
+TEST_F(WrapperSimpleDataTest, CheckMinimizeIntoReusesStorage)
+{
+  const auto& wrapper = Wrapper::get_instance();
+
+  const double composition[] = { 38.500, 2.820, 50.500, 5.880 };
+
+  MinimizeResult out;
+  wrapper.minimize_into(utils::convert_bar_to_pascals(25000), 1400, composition, out);
+  const Phase* phases = out.phases.data();
+  const double* ratio = out.phases[0].composition_ratio.data();
+  const double* bulk = out.composition.data();
+
+  const double pressure = utils::convert_bar_to_pascals(40000);
+  const double temperature = 1800;
+  wrapper.minimize_into(pressure, temperature, composition, out);
+
+  EXPECT_EQ(out.phases.data(), phases);
+  EXPECT_EQ(out.phases[0].composition_ratio.data(), ratio);
+  EXPECT_EQ(out.composition.data(), bulk);
+
+  const MinimizeResult expected = wrapper.solve(
+    pressure, temperature, std::vector<double>(composition, composition + 4));
+  EXPECT_EQ(out.pressure, pressure);
+  EXPECT_EQ(out.composition, expected.composition);
+  EXPECT_DOUBLE_EQ(out.density, expected.density);
+  ASSERT_EQ(out.phases.size(), expected.phases.size());
+  for (size_t p = 0; p < out.phases.size(); ++p) {
+    EXPECT_EQ(out.phases[p].name.standard, expected.phases[p].name.standard);
+    EXPECT_DOUBLE_EQ(out.phases[p].n_moles, expected.phases[p].n_moles);
+  }
+}
+
+
+
+TEST_F(WrapperSimpleDataTest, CheckSolveProfile)
+{
+  auto& wrapper = Wrapper::get_instance();
+  const double pressure = utils::convert_bar_to_pascals(30000);
+  const double temperature = 1600;
+
+  const MinimizeResult unprofiled = 
+    wrapper.solve(pressure, temperature, wrapper.initial_bulk_composition);
+  EXPECT_EQ(wrapper.get_last_profile().n_solves, 0);
+  EXPECT_EQ(wrapper.get_last_profile().total_time, 0.0);
+
+  wrapper.reset_profile();
+  wrapper.set_profiling(true);
+  const MinimizeResult first = 
+    wrapper.solve(pressure, temperature, wrapper.initial_bulk_composition);
+  const SolveProfile first_profile = wrapper.get_last_profile();
+  wrapper.solve(pressure, temperature + 100, wrapper.initial_bulk_composition);
+  const SolveProfile second_profile = wrapper.get_last_profile();
+  wrapper.set_profiling(false);
+
+  // The timings do not change the result.
+  EXPECT_EQ(first.density, unprofiled.density);
+
+  for (const SolveProfile& profile : { first_profile, second_profile }) {
+    EXPECT_EQ(profile.n_solves, 1);
+    EXPECT_GT(profile.total_time, 0.0);
+    EXPECT_GE(profile.static_g_time, 0.0);
+    EXPECT_GE(profile.dynamic_lp_time, 0.0);
+    EXPECT_LE(profile.static_g_time + profile.static_lp_time + profile.resub_time
+	      + profile.dynamic_lp_time + profile.getloc_time, 
+	      profile.total_time * (1 + 1e-6));
+  }
+
+  const SolveProfile& total = wrapper.get_profile();
+  EXPECT_EQ(total.n_solves, 2);
+  EXPECT_DOUBLE_EQ(total.total_time, 
+		   first_profile.total_time + second_profile.total_time);
+
+  wrapper.reset_profile();
+  EXPECT_EQ(wrapper.get_profile().n_solves, 0);
+}
+
+
+
+TEST_F(WrapperSimpleDataTest, CheckSolverStats)
+{
+  auto& wrapper = Wrapper::get_instance();
+  wrapper.reset_stats();
+
+  // The result of SetUp() is cached.
+  wrapper.minimize(utils::convert_bar_to_pascals(20000), 1500);
+  const SolveCounters hit = wrapper.get_last_counters();
+  EXPECT_TRUE(hit.cache_hit);
+  EXPECT_EQ(hit.lp_iterations, 0);
+
+  wrapper.solve(utils::convert_bar_to_pascals(30000), 1600, 
+		wrapper.initial_bulk_composition);
+  const SolveCounters solved = wrapper.get_last_counters();
+  EXPECT_FALSE(solved.cache_hit);
+  EXPECT_GT(solved.lp_iterations, 0);
+  EXPECT_GT(solved.reopt_iterations, 0);
+  EXPECT_GT(solved.n_static_compounds, 0);
+  EXPECT_GT(solved.n_dynamic_compounds, 0);
+
+  const SolverStats& stats = wrapper.get_stats();
+  EXPECT_EQ(stats.n_calls, 2);
+  EXPECT_EQ(stats.n_cache_hits, 1);
+  EXPECT_EQ(stats.n_solves(), 1);
+  EXPECT_EQ(stats.lp_iterations, solved.lp_iterations);
+  EXPECT_EQ(stats.hit_latency.count(), 1);
+  EXPECT_EQ(stats.solve_latency.count(), 1);
+  EXPECT_GT(stats.solve_latency.max(), stats.hit_latency.max());
+
+  EXPECT_NE(stats.to_json().find("\"n_cache_hits\": 1"), std::string::npos);
+
+  wrapper.reset_stats();
+  EXPECT_EQ(wrapper.get_stats().n_calls, 0);
+}
+
+
+
+TEST_F(WrapperSimpleDataTest, CheckHardwareCounting)
+{
+  auto& wrapper = Wrapper::get_instance();
+  try {
+    wrapper.set_hardware_counting(true);
+  }
+  catch (const std::runtime_error&) {
+    GTEST_SKIP() << "The hardware performance counters are not available.";
+  }
+
+  wrapper.solve(utils::convert_bar_to_pascals(30000), 1600, 
+		wrapper.initial_bulk_composition);
+  wrapper.set_hardware_counting(false);
+  EXPECT_FALSE(wrapper.is_hardware_counting());
+
+  const HardwareCounters& call = wrapper.get_last_counters().hardware;
+  EXPECT_GT(call.cycles, 0);
+  EXPECT_GT(call.instructions, 0);
+
+  const SolveProfile& profile = wrapper.get_last_profile();
+  EXPECT_GT(profile.dynamic_lp_hardware.instructions, 0);
+  EXPECT_GT(profile.getloc_hardware.instructions, 0);
+  EXPECT_LE(profile.static_g_hardware.instructions + profile.static_lp_hardware.instructions
+	    + profile.resub_hardware.instructions + profile.dynamic_lp_hardware.instructions
+	    + profile.getloc_hardware.instructions,
+	    profile.total_hardware.instructions);
+  EXPECT_LE(profile.total_hardware.instructions, call.instructions);
+}
+
+
+
+TEST_F(WrapperSimpleDataTest, CheckTraceRecorder)
+{
+  const char* filename = "wrapper_trace_test.bin";
+  std::remove(filename);
+
+  auto& wrapper = Wrapper::get_instance();
+  auto recorder = std::make_shared<TraceRecorder>(filename, wrapper.problem_file_hash,
+						  wrapper.n_composition_components);
+  wrapper.set_trace_recorder(recorder);
+
+  // The result of SetUp() is cached.
+  wrapper.minimize(utils::convert_bar_to_pascals(20000), 1500);
+  // No other test solves this point, so it is not cached when the tests share
+  // a process.
+  wrapper.minimize(utils::convert_bar_to_pascals(45000), 1300);
+
+  // Calls to solve() are not recorded.
+  wrapper.solve(utils::convert_bar_to_pascals(45000), 1300, 
+		wrapper.initial_bulk_composition);
+
+  wrapper.set_trace_recorder(nullptr);
+  EXPECT_EQ(recorder->size(), 2);
+  recorder.reset();
+
+  const QueryTrace trace = QueryTrace::load(filename);
+  EXPECT_EQ(trace.problem_hash, wrapper.problem_file_hash);
+  ASSERT_EQ(trace.records.size(), 2);
+  EXPECT_EQ(trace.n_cache_hits(), 1);
+
+  EXPECT_TRUE(trace.records[0].cache_hit);
+  EXPECT_FALSE(trace.records[1].cache_hit);
+  EXPECT_DOUBLE_EQ(trace.records[1].pressure, utils::convert_bar_to_pascals(45000));
+  EXPECT_DOUBLE_EQ(trace.records[1].temperature, 1300);
+  EXPECT_EQ(trace.records[1].composition, wrapper.initial_bulk_composition);
+  EXPECT_GT(trace.records[1].latency, trace.records[0].latency);
+
+  std::remove(filename);
+}
@@ -0,0 +1,442 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Solve the same points with the wrapper and with the reference MEEMUM built
+ * from the unmodified Perple_X sources (the meemum target), then compare the
+ * results and the wall time of each.
+ *
+ * Usage:
+ *
+ *     perplexcpp-compare-reference PROBLEM_FILE WORKING_DIR MEEMUM
+ *                                  (--grid PMIN PMAX NP TMIN TMAX NT | --points FILE)
+ *                                  [--tol PERCENT] [--rtol RTOL]
+ *
+ * Pressures are in Pa and temperatures in K. The points file holds one point
+ * per line as described in perplexcpp::read_query_points.
+ *
+ * The phase weight, volume and molar percentages must agree to within --tol
+ * percentage points (default 0.02, MEEMUM prints them to two decimal places)
+ * and the system and phase densities to within the relative tolerance --rtol
+ * (default 1e-3). Phases that are not solution models, which the wrapper does
+ * not return, are reported but not counted as differences. The exit status is
+ * nonzero if any point differs.
+ *
+ * The reference time per point excludes the time MEEMUM takes to start and
+ * read its data files, which is measured by a run with no points, but
+ * includes printing the results.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <perplexcpp/base.h>
+#include <perplexcpp/prewarm.h>
+#include <perplexcpp/utils.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace
+{
+
+using namespace perplexcpp;
+
+
+/**
+ * A phase printed by MEEMUM.
+ */
+struct ReferencePhase
+{
+  std::string name;
+
+  /**
+   * The weight, volume and molar percentages.
+   */
+  double weight_pct;
+  double volume_pct;
+  double molar_pct;
+
+  /**
+   * The density (kg/m3), or NaN if it was not printed.
+   */
+  double density;
+};
+
+
+/**
+ * The result of a point printed by MEEMUM.
+ */
+struct ReferenceResult
+{
+  bool solved;
+
+  std::vector<ReferencePhase> phases;
+
+  /**
+   * The system density (kg/m3), or NaN if it was not printed.
+   */
+  double density;
+};
+
+
+void
+print_usage(const char* program)
+{
+  std::cerr << "Usage: " << program << " PROBLEM_FILE WORKING_DIR MEEMUM\n"
+	    << "         (--grid PMIN PMAX NP TMIN TMAX NT | --points FILE)\n"
+	    << "         [--tol PERCENT] [--rtol RTOL]" << std::endl;
+}
+
+
+std::string
+trim(const std::string& str)
+{
+  const size_t begin = str.find_first_not_of(' ');
+  if (begin == std::string::npos)
+    return "";
+  return str.substr(begin, str.find_last_not_of(' ') - begin + 1);
+}
+
+
+/**
+ * @return The name of a phase in a line of the MEEMUM output (columns 2-15).
+ */
+std::string
+get_phase_name(const std::string& line)
+{
+  return line.size() < 2 ? "" : trim(line.substr(1, 14));
+}
+
+
+/**
+ * Parse the output of the reference MEEMUM (see extern/perplex/meemum.f).
+ */
+std::vector<ReferenceResult>
+parse_reference_output(std::istream& is)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  enum class Section { none, phases, properties } section = Section::none;
+
+  std::vector<ReferenceResult> results;
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.compare(0, 6, "#point") == 0) {
+      results.push_back(ReferenceResult { true, std::vector<ReferencePhase>(), nan });
+      section = Section::none;
+    }
+    else if (results.empty())
+      continue;
+    else if (line.compare(0, 7, "#failed") == 0)
+      results.back().solved = false;
+    else if (line.compare(0, 18, "Phase Compositions") == 0) {
+      std::getline(is, line);  // the column headings
+      section = Section::phases;
+    }
+    else if (line.compare(0, 29, "Molar Properties and Density:") == 0) {
+      std::getline(is, line);  // the column headings
+      section = Section::properties;
+    }
+    else if (trim(line).empty())
+      section = Section::none;
+    else if (section == Section::phases) {
+      ReferencePhase phase { get_phase_name(line), 0, 0, 0, nan };
+      std::istringstream values(line.substr(15));
+      values >> phase.weight_pct >> phase.volume_pct >> phase.molar_pct;
+      results.back().phases.push_back(phase);
+    }
+    else if (section == Section::properties) {
+      // The density is the last column.
+      const std::string name = get_phase_name(line);
+      const double density = std::stod(line.substr(line.find_last_of(' ', 
+				       line.find_last_not_of(' '))));
+
+      if (name == "System")
+	results.back().density = density;
+      else
+	for (ReferencePhase& phase : results.back().phases)
+	  if (phase.name == name && std::isnan(phase.density)) {
+	    phase.density = density;
+	    break;
+	  }
+    }
+  }
+  return results;
+}
+
+
+/**
+ * Run the reference MEEMUM on the points.
+ *
+ * @return The wall time (s).
+ */
+double
+run_reference(const std::string& meemum,
+              const std::string& working_dir,
+	      const std::string& project,
+	      const Wrapper& wrapper,
+	      const std::vector<QueryPoint>& points,
+	      const std::string& output_file)
+{
+  char input_file[] = "/tmp/perplexcpp-reference-XXXXXX";
+  const int fd = mkstemp(input_file);
+  if (fd == -1)
+    throw std::runtime_error("Could not create the reference input file.");
+  close(fd);
+
+  {
+    std::ofstream input(input_file);
+    input << project << "\n" << std::setprecision(17);
+    for (const QueryPoint& point : points) {
+      input << utils::convert_pascals_to_bar(point.pressure) << " " 
+	    << point.temperature;
+      for (double c : point.composition.empty() ? 
+		      wrapper.initial_bulk_composition : point.composition)
+	input << " " << c;
+      input << "\n";
+    }
+  }
+
+  const std::string command = "cd '" + working_dir + "' && '" + meemum + "' < '" 
+			      + input_file + "' > '" + output_file + "' 2>&1";
+
+  const auto start = std::chrono::steady_clock::now();
+  const int status = std::system(command.c_str());
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::remove(input_file);
+  if (status != 0)
+    throw std::runtime_error("The reference MEEMUM failed, see " + output_file + ".");
+  return elapsed.count();
+}
+
+
+/**
+ * @return The phase of the wrapper result with the name, or nullptr.
+ */
+const Phase*
+find_result_phase(const MinimizeResult& result, const std::string& name)
+{
+  for (const Phase& phase : result.phases)
+    if (phase.name.standard == name || phase.name.abbreviated == name || 
+	phase.name.full == name)
+      return &phase;
+  return nullptr;
+}
+
+
+/**
+ * @return True if x is within the relative tolerance of the reference value.
+ */
+bool
+is_close(const double x, const double reference, const double rtol)
+{
+  return std::abs(x - reference) <= rtol * std::abs(reference);
+}
+
+
+/**
+ * Compare a wrapper result with the reference.
+ *
+ * @return The differences found, one per line.
+ */
+std::string
+compare(const MinimizeResult& result,
+        const ReferenceResult& reference,
+	const double tol,
+	const double rtol,
+	double& unrepresented_pct)
+{
+  std::ostringstream diffs;
+  unrepresented_pct = 0.0;
+
+  if (!reference.solved) {
+    diffs << "  the reference optimization failed\n";
+    return diffs.str();
+  }
+
+  if (!is_close(result.density, reference.density, rtol))
+    diffs << "  system density: " << result.density << " vs " 
+	  << reference.density << "\n";
+
+  for (const Phase& phase : result.phases) {
+    if (phase.weight_frac == 0.0)
+      continue;
+    bool found = false;
+    for (const ReferencePhase& ref_phase : reference.phases)
+      found = found || find_result_phase(result, ref_phase.name) == &phase;
+    if (!found)
+      diffs << "  " << phase.name.standard << " is not in the reference ("
+	    << phase.weight_frac * 100 << " wt %)\n";
+  }
+
+  std::vector<const Phase*> seen;
+  for (const ReferencePhase& ref_phase : reference.phases) {
+    const Phase* phase = find_result_phase(result, ref_phase.name);
+
+    // The wrapper only returns the first instance of each solution model.
+    if (phase && std::find(seen.begin(), seen.end(), phase) != seen.end())
+      phase = nullptr;
+
+    if (!phase) {
+      unrepresented_pct += ref_phase.weight_pct;
+      continue;
+    }
+    seen.push_back(phase);
+
+    const double values[] = { phase->weight_frac * 100, phase->volume_frac * 100, 
+			      phase->molar_frac * 100 };
+    const double ref_values[] = { ref_phase.weight_pct, ref_phase.volume_pct,
+				  ref_phase.molar_pct };
+    const char* names[] = { "wt %", "vol %", "mol %" };
+    for (size_t i = 0; i < 3; ++i)
+      if (std::abs(values[i] - ref_values[i]) > tol)
+	diffs << "  " << ref_phase.name << " " << names[i] << ": " << values[i] 
+	      << " vs " << ref_values[i] << "\n";
+
+    if (!std::isnan(ref_phase.density) && 
+	!is_close(phase->density, ref_phase.density, rtol))
+      diffs << "  " << ref_phase.name << " density: " << phase->density 
+	    << " vs " << ref_phase.density << "\n";
+  }
+  return diffs.str();
+}
+
+}  // namespace
+
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 5) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const std::string problem_file = argv[1];
+  const std::string working_dir = argv[2];
+  const std::string meemum = argv[3];
+
+  try {
+    std::vector<QueryPoint> points;
+    double tol = 0.02;
+    double rtol = 1e-3;
+    for (int i = 4; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (arg == "--grid" && i + 6 < argc) {
+	points = make_query_grid(std::stod(argv[i+1]), std::stod(argv[i+2]), 
+				 std::stoul(argv[i+3]), std::stod(argv[i+4]), 
+				 std::stod(argv[i+5]), std::stoul(argv[i+6]));
+	i += 6;
+      }
+      else if (arg == "--points" && i + 1 < argc)
+	points = read_query_points(argv[++i]);
+      else if (arg == "--tol" && i + 1 < argc)
+	tol = std::stod(argv[++i]);
+      else if (arg == "--rtol" && i + 1 < argc)
+	rtol = std::stod(argv[++i]);
+      else {
+	print_usage(argv[0]);
+	return EXIT_FAILURE;
+      }
+    }
+    if (points.empty())
+      throw std::invalid_argument("There are no points to solve.");
+
+    Wrapper::initialize(problem_file, working_dir);
+    const Wrapper& wrapper = Wrapper::get_instance();
+
+    // Solve the points with the wrapper.
+    std::vector<MinimizeResult> results;
+    results.reserve(points.size());
+    const auto start = std::chrono::steady_clock::now();
+    for (const QueryPoint& point : points)
+      results.push_back(point.composition.empty() ?
+			wrapper.minimize(point.pressure, point.temperature) :
+			wrapper.minimize(point.pressure, point.temperature, 
+					 point.composition));
+    const std::chrono::duration<double> wrapper_time = 
+      std::chrono::steady_clock::now() - start;
+
+    // Solve them with MEEMUM, first with no points to measure its start-up time.
+    const std::string project = problem_file.substr(0, problem_file.find(".dat"));
+    const std::string output_file = "perplexcpp-reference.out";
+    const double startup_time = run_reference(meemum, working_dir, project, wrapper, 
+					      std::vector<QueryPoint>(), output_file);
+    const double reference_time = run_reference(meemum, working_dir, project, wrapper, 
+						points, output_file);
+
+    std::ifstream output(output_file);
+    const std::vector<ReferenceResult> references = parse_reference_output(output);
+    if (references.size() != points.size())
+      throw std::runtime_error("The reference output has the wrong number of points, "
+			       "see " + output_file + ".");
+
+    size_t n_differing = 0;
+    double max_unrepresented_pct = 0.0;
+    for (size_t i = 0; i < points.size(); ++i) {
+      double unrepresented_pct;
+      const std::string diffs = compare(results[i], references[i], tol, rtol,
+					unrepresented_pct);
+      max_unrepresented_pct = std::max(max_unrepresented_pct, unrepresented_pct);
+      if (diffs.empty())
+	continue;
+
+      n_differing++;
+      std::cout << "Point " << i << " (" << points[i].pressure << " Pa, " 
+		<< points[i].temperature << " K) differs:\n" << diffs;
+    }
+
+    const double wrapper_per_point = wrapper_time.count() / points.size();
+    const double reference_per_point = 
+      std::max(reference_time - startup_time, 0.0) / points.size();
+
+    std::cout << std::fixed << std::setprecision(3)
+	      << "Points:                     " << points.size() << "\n"
+	      << "Differing points:           " << n_differing << "\n"
+	      << "Max non-solution phase wt %: " << max_unrepresented_pct << "\n"
+	      << "Wrapper time per point:     " << wrapper_per_point * 1e3 << " ms\n"
+	      << "Reference time per point:   " << reference_per_point * 1e3 << " ms"
+	      << " (start-up " << startup_time * 1e3 << " ms)\n"
+	      << "Wrapper overhead:           " 
+	      << (reference_per_point > 0 ? 
+		  100 * (wrapper_per_point / reference_per_point - 1) : 0.0) 
+	      << " %" << std::endl;
+
+    std::remove(output_file.c_str());
+    return n_differing == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Generate a header defining the FixedResult type and the component and phase
+ * enums for a Perple_X problem file. It is normally run at build time by the
+ * CMake function perplexcpp_generate_fixed_result.
+ *
+ * Usage:
+ *
+ *     perplexcpp-generate-fixed-result PROBLEM_FILE WORKING_DIR NAME HEADER
+ *
+ * The definitions are placed in namespace perplexcpp::problems::NAME.
+ */
+
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/wrapper.h>
+
+
+namespace
+{
+
+/**
+ * @return The name with every character that may not appear in an identifier
+ *         replaced by an underscore and trailing underscores removed.
+ */
+std::string
+make_identifier(const std::string& name)
+{
+  std::string identifier;
+  for (char c : name)
+    identifier += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+  while (!identifier.empty() && identifier.back() == '_')
+    identifier.pop_back();
+  if (identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier[0])))
+    identifier = "_" + identifier;
+  return identifier;
+}
+
+
+/**
+ * @return An identifier for each name. Names that give the same identifier as an
+ *         earlier name (e.g. 'Opx(HP)' and 'Opx_HP') are suffixed with their
+ *         index. Throws an exception if this still leaves a duplicate.
+ */
+std::vector<std::string>
+make_identifiers(const std::vector<std::string>& names)
+{
+  std::vector<std::string> identifiers;
+  std::set<std::string> used;
+  for (size_t i = 0; i < names.size(); ++i) {
+    std::string identifier = make_identifier(names[i]);
+    if (used.count(identifier))
+      identifier += "_" + std::to_string(i);
+    if (!used.insert(identifier).second)
+      throw std::runtime_error("The name '" + names[i] + "' gives the duplicate "
+			       "identifier '" + identifier + "'.");
+    identifiers.push_back(identifier);
+  }
+  return identifiers;
+}
+
+
+/**
+ * Write an enum class with an enumerator for each name.
+ */
+void
+write_enum(std::ostream& out,
+           const std::string& enum_name,
+	   const std::vector<std::string>& names)
+{
+  const std::vector<std::string> identifiers = make_identifiers(names);
+
+  out << "  enum class " << enum_name << "\n  {\n";
+  for (size_t i = 0; i < names.size(); ++i)
+    out << "    " << identifiers[i] << " = " << i 
+	<< (i+1 < names.size() ? "," : "") << "\n";
+  out << "  };\n";
+}
+
+}  // namespace
+
+
+int
+main(int argc, char* argv[])
+{
+  using namespace perplexcpp;
+
+  if (argc != 5) {
+    std::cerr << "Usage: " << argv[0] << " PROBLEM_FILE WORKING_DIR NAME HEADER" 
+	      << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string problem_file = argv[1];
+  const std::string working_dir = argv[2];
+  const std::string name = make_identifier(argv[3]);
+  const std::string header = argv[4];
+
+  try {
+    Wrapper::initialize(problem_file, working_dir);
+    const Wrapper& wrapper = Wrapper::get_instance();
+
+    std::vector<std::string> phase_names;
+    for (const PhaseName& phase_name : wrapper.phase_names)
+      phase_names.push_back(phase_name.standard);
+
+    std::string guard = "PERPLEXCPP_PROBLEMS_" + name + "_H";
+    for (char& c : guard)
+      c = std::toupper(static_cast<unsigned char>(c));
+
+    std::ofstream out(header);
+    if (!out)
+      throw std::runtime_error("Could not open '" + header + "'.");
+
+    out << "/* Generated by perplexcpp-generate-fixed-result from " << problem_file 
+	<< ". Do not edit. */\n\n\n"
+	<< "#ifndef " << guard << "\n"
+	<< "#define " << guard << "\n\n\n"
+	<< "#include <cstddef>\n"
+	<< "#include <cstdint>\n\n"
+	<< "#include <perplexcpp/fixed_result.h>\n\n\n"
+	<< "namespace perplexcpp\n{\nnamespace problems\n{\nnamespace " << name 
+	<< "\n{\n"
+	<< "  /**\n   * The hash of the problem definition file.\n   */\n"
+	<< "  const std::uint64_t problem_hash = " << wrapper.problem_file_hash 
+	<< "ULL;\n\n\n"
+	<< "  const size_t n_components = " << wrapper.n_composition_components 
+	<< ";\n\n\n"
+	<< "  const size_t n_phases = " << wrapper.n_phases << ";\n\n\n"
+	<< "  /**\n   * The composition components in Wrapper order.\n   */\n";
+    write_enum(out, "Component", wrapper.composition_component_names);
+    out << "\n\n"
+	<< "  /**\n   * The phases in Wrapper::phase_names order.\n   */\n";
+    write_enum(out, "PhaseId", phase_names);
+    out << "\n\n"
+	<< "  typedef FixedResult<n_components,n_phases> Result;\n"
+	<< "}\n}\n}\n\n\n"
+	<< "#endif\n";
+
+    if (!out)
+      throw std::runtime_error("Could not write '" + header + "'.");
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Solve a grid or list of query points ahead of a simulation and store the
+ * results in a persistent cache file.
+ *
+ * Usage:
+ *
+ *     perplexcpp-prewarm PROBLEM_FILE WORKING_DIR CACHE_FILE
+ *                        (--grid PMIN PMAX NP TMIN TMAX NT | --points FILE | 
+ *                         --trace FILE)
+ *                        [--workers N]
+ *
+ * Pressures are in Pa and temperatures in K. The points file holds one point
+ * per line as described in perplexcpp::read_query_points. A trace file holds
+ * the queries recorded by a perplexcpp::TraceRecorder.
+ */
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/persistent_cache.h>
+#include <perplexcpp/prewarm.h>
+#include <perplexcpp/query_trace.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace
+{
+
+void
+print_usage(const char* program)
+{
+  std::cerr << "Usage: " << program << " PROBLEM_FILE WORKING_DIR CACHE_FILE\n"
+	    << "         (--grid PMIN PMAX NP TMIN TMAX NT | --points FILE | --trace FILE)\n"
+	    << "         [--workers N]" << std::endl;
+}
+
+}  // namespace
+
+
+int
+main(int argc, char* argv[])
+{
+  using namespace perplexcpp;
+
+  if (argc < 5) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const std::string problem_file = argv[1];
+  const std::string working_dir = argv[2];
+  const std::string cache_file = argv[3];
+
+  try {
+    Wrapper::initialize(problem_file, working_dir);
+    const Wrapper& wrapper = Wrapper::get_instance();
+
+    std::vector<QueryPoint> points;
+    unsigned int n_workers = 0;
+    for (int i = 4; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (arg == "--grid" && i + 6 < argc) {
+	points = make_query_grid(std::stod(argv[i+1]), std::stod(argv[i+2]), 
+				 std::stoul(argv[i+3]), std::stod(argv[i+4]), 
+				 std::stod(argv[i+5]), std::stoul(argv[i+6]));
+	i += 6;
+      }
+      else if (arg == "--points" && i + 1 < argc)
+	points = read_query_points(argv[++i]);
+      else if (arg == "--trace" && i + 1 < argc)
+	points = QueryTrace::load(argv[++i]).to_query_points();
+      else if (arg == "--workers" && i + 1 < argc)
+	n_workers = std::stoul(argv[++i]);
+      else {
+	print_usage(argv[0]);
+	return EXIT_FAILURE;
+      }
+    }
+
+    PersistentCache cache(cache_file, wrapper.problem_file_hash, 
+			  wrapper.n_composition_components, wrapper.phase_names,
+			  std::max<size_t>(65536, 2 * points.size()));
+
+    const size_t n_added = prewarm(wrapper, points, cache, n_workers);
+    std::cout << "Solved " << n_added << " of " << points.size() << " points. "
+	      << cache_file << " holds " << cache.size() << " results." << std::endl;
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2020 Connor Ward.
+ *
+ * This file is part of PerpleX-cpp.
+ *
+ * PerpleX-cpp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PerpleX-cpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PerpleX-cpp.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Replay a trace of minimize calls recorded by a perplexcpp::TraceRecorder
+ * through a chosen cache and scheduling configuration and report the
+ * throughput and cache hit rate, along with those that were recorded.
+ *
+ * Usage:
+ *
+ *     perplexcpp-replay-trace PROBLEM_FILE WORKING_DIR TRACE_FILE
+ *                             [--cache CAPACITY] [--rtol RTOL] 
+ *                             [--persistent CACHE_FILE] 
+ *                             [--batch SIZE] [--workers N] [--limit N]
+ *
+ * --cache and --rtol set the capacity and tolerance of the wrapper's LRU cache
+ * and --persistent adds a persistent cache file (e.g. one filled by
+ * perplexcpp-prewarm) as its backend. By default each query is replayed in turn
+ * through Wrapper::minimize. With --batch the trace is replayed in consecutive
+ * batches of SIZE queries: each batch is first looked up in the caches and the
+ * misses are then solved together with perplexcpp::minimize_batch using N
+ * worker processes (by default one per hardware thread). --limit replays only
+ * the first N queries.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <perplexcpp/persistent_cache.h>
+#include <perplexcpp/prewarm.h>
+#include <perplexcpp/query_trace.h>
+#include <perplexcpp/result_batch.h>
+#include <perplexcpp/wrapper.h>
+
+
+namespace
+{
+
+using namespace perplexcpp;
+
+
+/**
+ * The outcome of a replay.
+ */
+struct ReplayCounts
+{
+  size_t n_hits = 0;
+
+  size_t n_failed = 0;
+};
+
+
+void
+print_usage(const char* program)
+{
+  std::cerr << "Usage: " << program << " PROBLEM_FILE WORKING_DIR TRACE_FILE\n"
+	    << "         [--cache CAPACITY] [--rtol RTOL] [--persistent CACHE_FILE]\n"
+	    << "         [--batch SIZE] [--workers N] [--limit N]" << std::endl;
+}
+
+
+/**
+ * Replay the queries one at a time through the wrapper.
+ */
+ReplayCounts
+replay_serial(const Wrapper& wrapper, const std::vector<QueryPoint>& points)
+{
+  ReplayCounts counts;
+  MinimizeResult result;
+  for (const QueryPoint& point : points) {
+    try {
+      wrapper.minimize_into(point.pressure, point.temperature, point.composition, 
+			    result);
+      if (wrapper.get_last_counters().cache_hit)
+	counts.n_hits++;
+    }
+    catch (const std::invalid_argument&) {
+      counts.n_failed++;
+    }
+  }
+  return counts;
+}
+
+
+/**
+ * Replay the queries in batches, solving the cache misses of each batch in
+ * parallel.
+ */
+ReplayCounts
+replay_batched(Wrapper& wrapper, 
+               const std::vector<QueryPoint>& points,
+	       const size_t batch_size,
+	       const unsigned int n_workers)
+{
+  ResultCache& cache = wrapper.get_cache();
+  const std::shared_ptr<CacheBackend> backend = wrapper.get_cache_backend();
+
+  ReplayCounts counts;
+  MinimizeResult result;
+  std::vector<QueryPoint> misses;
+  for (size_t begin = 0; begin < points.size(); begin += batch_size) {
+    const size_t end = std::min(begin + batch_size, points.size());
+
+    misses.clear();
+    for (size_t i = begin; i < end; ++i) {
+      const QueryPoint& point = points[i];
+      if ((cache.capacity > 0 &&
+	   cache.get(point.pressure, point.temperature, point.composition, result) == 0) ||
+	  (backend && 
+	   backend->get(point.pressure, point.temperature, point.composition, result) == 0))
+	counts.n_hits++;
+      else
+	misses.push_back(point);
+    }
+    if (misses.empty())
+      continue;
+
+    const ResultBatch batch = minimize_batch(wrapper, misses, n_workers);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (!batch.solved()[i]) {
+	counts.n_failed++;
+	continue;
+      }
+      batch.get(i, result);
+      if (cache.capacity > 0)
+	cache.put(result);
+      if (backend)
+	backend->put(result);
+    }
+  }
+  return counts;
+}
+
+}  // namespace
+
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 4) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const std::string problem_file = argv[1];
+  const std::string working_dir = argv[2];
+  const std::string trace_file = argv[3];
+
+  try {
+    size_t cache_capacity = 0;
+    double cache_rtol = 0.0;
+    std::string persistent_file;
+    size_t batch_size = 0;
+    unsigned int n_workers = 0;
+    size_t limit = 0;
+    for (int i = 4; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (arg == "--cache" && i + 1 < argc)
+	cache_capacity = std::stoul(argv[++i]);
+      else if (arg == "--rtol" && i + 1 < argc)
+	cache_rtol = std::stod(argv[++i]);
+      else if (arg == "--persistent" && i + 1 < argc)
+	persistent_file = argv[++i];
+      else if (arg == "--batch" && i + 1 < argc)
+	batch_size = std::stoul(argv[++i]);
+      else if (arg == "--workers" && i + 1 < argc)
+	n_workers = std::stoul(argv[++i]);
+      else if (arg == "--limit" && i + 1 < argc)
+	limit = std::stoul(argv[++i]);
+      else {
+	print_usage(argv[0]);
+	return EXIT_FAILURE;
+      }
+    }
+
+    Wrapper::initialize(problem_file, working_dir, cache_capacity, cache_rtol);
+    Wrapper& wrapper = Wrapper::get_instance();
+
+    QueryTrace trace = QueryTrace::load(trace_file);
+    if (trace.problem_hash != wrapper.problem_file_hash)
+      throw std::runtime_error("The trace was recorded for a different problem file.");
+    if (limit > 0 && limit < trace.records.size())
+      trace.records.resize(limit);
+    if (trace.records.empty())
+      throw std::invalid_argument("The trace is empty.");
+
+    if (!persistent_file.empty())
+      wrapper.set_cache_backend(std::make_shared<PersistentCache>(
+	persistent_file, wrapper.problem_file_hash, wrapper.n_composition_components, 
+	wrapper.phase_names));
+
+    const std::vector<QueryPoint> points = trace.to_query_points();
+
+    const auto start = std::chrono::steady_clock::now();
+    const ReplayCounts counts = batch_size > 0 ?
+      replay_batched(wrapper, points, batch_size, n_workers) :
+      replay_serial(wrapper, points);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double recorded_time = 0.0;
+    for (const TraceRecord& record : trace.records)
+      recorded_time += record.latency;
+
+    const size_t n_queries = points.size();
+    std::cout << std::fixed << std::setprecision(3)
+	      << "Queries:              " << n_queries << " (" << counts.n_failed 
+	      << " failed)\n"
+	      << "Wall time:            " << elapsed.count() << " s\n"
+	      << "Throughput:           " << n_queries / elapsed.count() << " /s\n"
+	      << "Hit rate:             " << 100.0 * counts.n_hits / n_queries << " %\n"
+	      << "Recorded throughput:  " 
+	      << (recorded_time > 0 ? n_queries / recorded_time : 0.0) << " /s\n"
+	      << "Recorded hit rate:    " 
+	      << 100.0 * trace.n_cache_hits() / n_queries << " %" << std::endl;
+
+    // The statistics only cover the calls made through the wrapper.
+    if (batch_size == 0)
+      std::cout << "\n" << wrapper.get_stats().to_text() << std::endl;
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}